@@ -0,0 +1,183 @@
+/**
+ * @file bench.c
+ * @brief Ejecutor de micro-benchmarks con el contador de ciclos de la CPU.
+ *
+ * Las muestras se toman de una en una alrededor de la llamada al kernel;
+ * el coste de la medición (llamada indirecta vacía) se calibra una vez y
+ * se descuenta de cada muestra.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_cpu.h"
+#include "esp_log.h"
+
+static const char *TAG = "BENCH";
+
+/* Entrada de la tabla de benchmarks registrados */
+typedef struct {
+    const char *name;
+    bench_fn_t fn;
+    void *arg;
+    bench_fn_t enter;   /* Opcionales, fuera de la medición */
+    bench_fn_t leave;
+} bench_entry_t;
+
+static bench_entry_t s_entries[BENCH_MAX_ENTRIES];
+static size_t s_entry_count = 0;
+
+/* Muestras de la ejecución en curso (bench_run no es reentrante) */
+static uint32_t s_samples[BENCH_MAX_ITERATIONS];
+
+/* Kernel vacío para calibrar el coste de la medición */
+static void bench_empty(void *arg)
+{
+    (void)arg;
+}
+
+/* Ciclos de una sola ejecución de `fn` */
+static inline uint32_t bench_measure(bench_fn_t fn, void *arg)
+{
+    uint32_t start = esp_cpu_get_cycle_count();
+    fn(arg);
+    return esp_cpu_get_cycle_count() - start;
+}
+
+/* Ordenación por inserción: como mucho BENCH_MAX_ITERATIONS muestras */
+static void bench_sort(uint32_t *v, size_t n)
+{
+    for (size_t i = 1; i < n; i++) {
+        uint32_t key = v[i];
+        size_t j = i;
+        while (j > 0 && v[j - 1] > key) {
+            v[j] = v[j - 1];
+            j--;
+        }
+        v[j] = key;
+    }
+}
+
+/* Coste mínimo de medir un kernel vacío */
+static uint32_t bench_overhead(void)
+{
+    uint32_t best = UINT32_MAX;
+    for (int i = 0; i < 8; i++) {
+        uint32_t c = bench_measure(bench_empty, NULL);
+        if (c < best) {
+            best = c;
+        }
+    }
+    return best;
+}
+
+esp_err_t bench_register(const char *name, bench_fn_t fn, void *arg)
+{
+    return bench_register_guarded(name, fn, arg, NULL, NULL);
+}
+
+esp_err_t bench_register_guarded(const char *name, bench_fn_t fn, void *arg,
+                                 bench_fn_t enter, bench_fn_t leave)
+{
+    if (name == NULL || fn == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_entry_count >= BENCH_MAX_ENTRIES) {
+        ESP_LOGE(TAG, "Tabla de benchmarks llena, no se registra %s", name);
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_entries[s_entry_count++] = (bench_entry_t) {
+        .name = name,
+        .fn = fn,
+        .arg = arg,
+        .enter = enter,
+        .leave = leave,
+    };
+    ESP_LOGD(TAG, "Benchmark registrado: %s", name);
+    return ESP_OK;
+}
+
+size_t bench_run(const char *name, uint32_t iterations,
+                 bench_result_t *results, size_t max_results)
+{
+    if (iterations == 0) {
+        iterations = 1;
+    } else if (iterations > BENCH_MAX_ITERATIONS) {
+        iterations = BENCH_MAX_ITERATIONS;
+    }
+
+    uint32_t overhead = bench_overhead();
+    size_t count = 0;
+
+    for (size_t i = 0; i < s_entry_count && count < max_results; i++) {
+        const bench_entry_t *e = &s_entries[i];
+        if (name != NULL && strcmp(name, e->name) != 0) {
+            continue;
+        }
+
+        if (e->enter) {
+            e->enter(e->arg);
+        }
+
+        /* Una ejecución de calentamiento (caché de flash, primeras reservas) */
+        e->fn(e->arg);
+
+        for (uint32_t n = 0; n < iterations; n++) {
+            uint32_t c = bench_measure(e->fn, e->arg);
+            s_samples[n] = (c > overhead) ? c - overhead : 0;
+        }
+
+        if (e->leave) {
+            e->leave(e->arg);
+        }
+        bench_sort(s_samples, iterations);
+
+        results[count++] = (bench_result_t) {
+            .name = e->name,
+            .iterations = iterations,
+            .min_cycles = s_samples[0],
+            .median_cycles = s_samples[iterations / 2],
+            .max_cycles = s_samples[iterations - 1],
+        };
+        ESP_LOGI(TAG, "%s: min=%lu med=%lu max=%lu ciclos (%lu it)", e->name,
+                 (unsigned long)s_samples[0], (unsigned long)s_samples[iterations / 2],
+                 (unsigned long)s_samples[iterations - 1], (unsigned long)iterations);
+    }
+
+    return count;
+}
+
+int bench_format_json(const bench_result_t *results, size_t count, char *out, size_t len)
+{
+    size_t pos = 0;
+    int n = snprintf(out, len, "{\"bench\":[");
+    if (n < 0 || (size_t)n >= len) {
+        return -1;
+    }
+    pos = n;
+
+    for (size_t i = 0; i < count; i++) {
+        const bench_result_t *r = &results[i];
+        n = snprintf(out + pos, len - pos,
+                     "%s{\"name\":\"%s\",\"iterations\":%lu,\"min\":%lu,\"median\":%lu,\"max\":%lu}",
+                     i ? "," : "", r->name, (unsigned long)r->iterations,
+                     (unsigned long)r->min_cycles, (unsigned long)r->median_cycles,
+                     (unsigned long)r->max_cycles);
+        if (n < 0 || (size_t)n >= len - pos) {
+            return -1;
+        }
+        pos += n;
+    }
+
+    n = snprintf(out + pos, len - pos, "]}");
+    if (n < 0 || (size_t)n >= len - pos) {
+        return -1;
+    }
+    return (int)(pos + n);
+}
@@ -0,0 +1,75 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+/**
+ * @file bench.h
+ * @brief Micro-benchmarks en el dispositivo medidos con el contador de ciclos.
+ *
+ * Cada componente registra funciones cortas (un "kernel") con un nombre;
+ * bench_run() las ejecuta N veces midiendo ciclos de CPU con
+ * esp_cpu_get_cycle_count() y devuelve mínimo, mediana y máximo ya
+ * descontado el coste de la propia medición.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#define BENCH_MAX_ENTRIES     16   /* Benchmarks registrables */
+#define BENCH_MAX_ITERATIONS  64   /* Muestras por benchmark (para la mediana) */
+
+/** Kernel a medir; `arg` es el puntero pasado al registrarlo. */
+typedef void (*bench_fn_t)(void *arg);
+
+/** Resultado de un benchmark (ciclos de CPU por iteración). */
+typedef struct {
+    const char *name;
+    uint32_t iterations;
+    uint32_t min_cycles;
+    uint32_t median_cycles;
+    uint32_t max_cycles;
+} bench_result_t;
+
+/**
+ * @brief Registra un benchmark.
+ * @param name Nombre (cadena estática) usado para invocarlo.
+ * @param fn   Función a medir.
+ * @param arg  Argumento opaco para `fn`.
+ * @return ESP_OK, ESP_ERR_NO_MEM si la tabla está llena o
+ *         ESP_ERR_INVALID_ARG si faltan parámetros.
+ */
+esp_err_t bench_register(const char *name, bench_fn_t fn, void *arg);
+
+/**
+ * @brief Registra un benchmark con un par de funciones que se llaman una
+ *        vez antes y otra después de todas sus iteraciones, fuera de la
+ *        medición (p.ej. para tomar en exclusiva un recurso que el kernel
+ *        comparte con otra tarea).
+ * @param enter Se llama con `arg` antes del calentamiento (puede ser NULL).
+ * @param leave Se llama con `arg` tras la última muestra (puede ser NULL).
+ * @return Lo mismo que bench_register().
+ */
+esp_err_t bench_register_guarded(const char *name, bench_fn_t fn, void *arg,
+                                 bench_fn_t enter, bench_fn_t leave);
+
+/**
+ * @brief Ejecuta uno o todos los benchmarks registrados.
+ * @param name        Nombre del benchmark o NULL para ejecutarlos todos.
+ * @param iterations  Iteraciones por benchmark (se limita a BENCH_MAX_ITERATIONS).
+ * @param results     Array de salida.
+ * @param max_results Capacidad de `results`.
+ * @return Número de resultados escritos (0 si `name` no existe).
+ */
+size_t bench_run(const char *name, uint32_t iterations,
+                 bench_result_t *results, size_t max_results);
+
+/**
+ * @brief Serializa resultados como JSON: {"bench":[{"name":..,"min":..},..]}.
+ * @return Longitud escrita (sin NUL) o -1 si `out` es demasiado pequeño.
+ */
+int bench_format_json(const bench_result_t *results, size_t count, char *out, size_t len);
+
+#endif // BENCH_H
@@ -0,0 +1,255 @@
+/**
+ * @file button.c
+ * @brief Pulsador por interrupción: conmutación inmediata en ISR,
+ * antirrebote por temporizador y clasificación de gestos.
+ *
+ * Flujo:
+ *  - ISR (cualquier flanco): si no hay ventana de antirrebote abierta y el
+ *    nivel es "pulsado", conmuta los canales con la API _from_isr de
+ *    led_control (latencia de microsegundos) y abre la ventana. Cada
+ *    rebote reinicia la ventana.
+ *  - Timer de antirrebote (tarea de timers): con el nivel ya estable,
+ *    confirma pulsación/liberación y cierra la ventana.
+ *  - Timer de gestos: espera de pulsación larga y ventana de doble
+ *    pulsación.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#include "button.h"
+#include "led_control.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/timers.h"
+#include "driver/gpio.h"
+#include "soc/gpio_reg.h"
+#include "soc/soc.h"
+#include "soc/soc_caps.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+
+#if SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER
+#include "driver/gpio_filter.h"
+#endif
+
+static const char *TAG = "BUTTON";
+
+/* Estado del gesto en curso (solo se toca desde la tarea de timers) */
+typedef enum {
+    GESTURE_IDLE = 0,
+    GESTURE_LONG_WAIT,      /* Pulsado, esperando a la pulsación larga */
+    GESTURE_DOUBLE_WAIT,    /* Soltado tras una corta, esperando la segunda */
+} gesture_state_t;
+
+static TimerHandle_t s_debounce_timer = NULL;
+static TimerHandle_t s_gesture_timer = NULL;
+
+/* Estado compartido con la ISR (protegido por s_lock) */
+static volatile bool s_pressed = false;
+static volatile bool s_press_pending = false;
+static volatile bool s_debouncing = false;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static gesture_state_t s_gesture = GESTURE_IDLE;
+static bool s_ignore_release = false;
+
+static button_callback_t s_callback = NULL;
+static void *s_callback_arg = NULL;
+
+static const char *s_event_names[] = {
+    [BUTTON_EVENT_PRESS]   = "PRESS",
+    [BUTTON_EVENT_RELEASE] = "RELEASE",
+    [BUTTON_EVENT_SHORT]   = "SHORT",
+    [BUTTON_EVENT_LONG]    = "LONG",
+    [BUTTON_EVENT_DOUBLE]  = "DOUBLE",
+};
+
+
+/* Funciones privadas ------------------------------------------------------ */
+
+static inline IRAM_ATTR bool read_pressed(void)
+{
+    return ((REG_READ(GPIO_IN_REG) >> BUTTON_GPIO) & 1) == BUTTON_ACTIVE_LEVEL;
+}
+
+static void emit(button_event_t event)
+{
+    ESP_LOGD(TAG, "Evento %s", s_event_names[event]);
+    button_callback_t cb = s_callback;
+    if (cb) {
+        cb(event, s_callback_arg);
+    }
+}
+
+static void on_press(void)
+{
+    emit(BUTTON_EVENT_PRESS);
+
+    if (s_gesture == GESTURE_DOUBLE_WAIT) {
+        xTimerStop(s_gesture_timer, 0);
+        s_gesture = GESTURE_IDLE;
+        s_ignore_release = true;
+        emit(BUTTON_EVENT_DOUBLE);
+        return;
+    }
+
+    s_gesture = GESTURE_LONG_WAIT;
+    s_ignore_release = false;
+    xTimerChangePeriod(s_gesture_timer, pdMS_TO_TICKS(BUTTON_LONG_PRESS_MS), 0);
+}
+
+static void on_release(void)
+{
+    emit(BUTTON_EVENT_RELEASE);
+
+    if (s_ignore_release) {
+        s_ignore_release = false;
+        return;
+    }
+    if (s_gesture == GESTURE_LONG_WAIT) {
+        s_gesture = GESTURE_DOUBLE_WAIT;
+        xTimerChangePeriod(s_gesture_timer, pdMS_TO_TICKS(BUTTON_DOUBLE_PRESS_MS), 0);
+    }
+}
+
+static void gesture_timer_cb(TimerHandle_t timer)
+{
+    if (s_gesture == GESTURE_LONG_WAIT) {
+        s_gesture = GESTURE_IDLE;
+        s_ignore_release = true;
+        emit(BUTTON_EVENT_LONG);
+    } else if (s_gesture == GESTURE_DOUBLE_WAIT) {
+        s_gesture = GESTURE_IDLE;
+        emit(BUTTON_EVENT_SHORT);
+    }
+}
+
+/* El nivel lleva BUTTON_DEBOUNCE_MS estable: confirmar y cerrar la ventana */
+static void debounce_timer_cb(TimerHandle_t timer)
+{
+    portENTER_CRITICAL(&s_lock);
+    bool press = s_press_pending;
+    bool down = read_pressed();
+    bool release = s_pressed && !down;
+    /* Pulsación que empezó dentro de la ventana de una liberación */
+    bool late_press = !s_pressed && down;
+    s_pressed = down;
+    s_press_pending = false;
+    s_debouncing = false;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (late_press && BUTTON_TOGGLE_MASK) {
+        led_control_toggle_mask(BUTTON_TOGGLE_MASK);
+    }
+    if (press || late_press) {
+        on_press();
+    }
+    if (release) {
+        on_release();
+    }
+}
+
+static void IRAM_ATTR button_isr(void *arg)
+{
+    bool toggle = false;
+
+    portENTER_CRITICAL_ISR(&s_lock);
+    if (!s_debouncing) {
+        if (read_pressed() && !s_pressed) {
+            s_pressed = true;
+            s_press_pending = true;
+            toggle = true;
+        }
+        s_debouncing = true;
+    }
+    portEXIT_CRITICAL_ISR(&s_lock);
+
+    if (toggle && BUTTON_TOGGLE_MASK) {
+        led_control_toggle_mask_from_isr(BUTTON_TOGGLE_MASK);
+    }
+
+    /* Cada flanco (rebote incluido) reinicia la ventana */
+    BaseType_t woken = pdFALSE;
+    xTimerResetFromISR(s_debounce_timer, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+
+/* API pública ------------------------------------------------------------- */
+
+esp_err_t button_init(void)
+{
+    s_debounce_timer = xTimerCreate("btn_debounce", pdMS_TO_TICKS(BUTTON_DEBOUNCE_MS),
+                                    pdFALSE, NULL, debounce_timer_cb);
+    s_gesture_timer = xTimerCreate("btn_gesture", pdMS_TO_TICKS(BUTTON_LONG_PRESS_MS),
+                                   pdFALSE, NULL, gesture_timer_cb);
+    if (s_debounce_timer == NULL || s_gesture_timer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << BUTTON_GPIO,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = BUTTON_ACTIVE_LEVEL == 0 ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE,
+        .pull_down_en = BUTTON_ACTIVE_LEVEL == 0 ? GPIO_PULLDOWN_DISABLE : GPIO_PULLDOWN_ENABLE,
+        .intr_type = GPIO_INTR_ANYEDGE,
+    };
+    esp_err_t ret = gpio_config(&io_conf);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+#if SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER
+    /* Filtro hardware: descarta pulsos de menos de 2 ciclos de reloj */
+    gpio_pin_glitch_filter_config_t filter_conf = {
+        .clk_src = GLITCH_FILTER_CLK_SRC_DEFAULT,
+        .gpio_num = BUTTON_GPIO,
+    };
+    gpio_glitch_filter_handle_t filter;
+    if (gpio_new_pin_glitch_filter(&filter_conf, &filter) == ESP_OK) {
+        gpio_glitch_filter_enable(filter);
+    } else {
+        ESP_LOGW(TAG, "Filtro de glitches no disponible");
+    }
+#endif
+
+    /* Arrancar con el estado real (un botón mantenido al arrancar no conmuta) */
+    s_pressed = read_pressed();
+
+    ret = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Error instalando servicio ISR: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    ret = gpio_isr_handler_add(BUTTON_GPIO, button_isr, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error registrando ISR: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Botón en GPIO%d (antirrebote %d ms, canales 0x%04lX)",
+             BUTTON_GPIO, BUTTON_DEBOUNCE_MS, (unsigned long)BUTTON_TOGGLE_MASK);
+    return ESP_OK;
+}
+
+void button_set_callback(button_callback_t cb, void *arg)
+{
+    s_callback_arg = arg;
+    s_callback = cb;
+}
+
+bool button_is_pressed(void)
+{
+    return s_pressed;
+}
+
+const char *button_event_name(button_event_t event)
+{
+    if (event < BUTTON_EVENT_PRESS || event > BUTTON_EVENT_DOUBLE) {
+        return "?";
+    }
+    return s_event_names[event];
+}
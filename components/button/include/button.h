@@ -0,0 +1,73 @@
+#ifndef BUTTON_H
+#define BUTTON_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @file button.h
+ * @brief Pulsador físico por interrupción con antirrebote y gestos.
+ *
+ * La ISR del GPIO conmuta los canales de BUTTON_TOGGLE_MASK en el mismo
+ * flanco de pulsación (sin pasar por ninguna tarea ni bucle de sondeo);
+ * los rebotes posteriores se descartan hasta que el nivel lleva
+ * BUTTON_DEBOUNCE_MS estable. Los gestos (corta, larga, doble) se
+ * clasifican en la tarea de timers de FreeRTOS y se notifican por callback.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+/* -----------------------------
+ * Configuración
+ * ----------------------------- */
+#ifndef BUTTON_GPIO
+#define BUTTON_GPIO              9     /* Botón BOOT de las placas ESP32-C3 */
+#endif
+#define BUTTON_ACTIVE_LEVEL      0     /* Pulsado a GND, con pull-up interno */
+#define BUTTON_DEBOUNCE_MS       20    /* Nivel estable exigido tras un flanco */
+#define BUTTON_LONG_PRESS_MS     800   /* Pulsación larga */
+#define BUTTON_DOUBLE_PRESS_MS   300   /* Ventana para la segunda pulsación */
+
+/* Canales que conmuta la ISR en cada pulsación (0 = ninguno) */
+#ifndef BUTTON_TOGGLE_MASK
+#define BUTTON_TOGGLE_MASK       (1UL << 0)
+#endif
+
+/** Eventos notificados por callback */
+typedef enum {
+    BUTTON_EVENT_PRESS = 0,   /* Pulsación confirmada (la conmutación ya se hizo) */
+    BUTTON_EVENT_RELEASE,     /* Liberación confirmada */
+    BUTTON_EVENT_SHORT,       /* Pulsación corta sin segunda pulsación */
+    BUTTON_EVENT_LONG,        /* Mantenido BUTTON_LONG_PRESS_MS */
+    BUTTON_EVENT_DOUBLE,      /* Dos pulsaciones cortas seguidas */
+} button_event_t;
+
+/**
+ * Callback de eventos. Se ejecuta en la tarea de timers de FreeRTOS:
+ * debe ser breve y no bloquear.
+ */
+typedef void (*button_callback_t)(button_event_t event, void *arg);
+
+/**
+ * @brief Configura el GPIO, el filtro de glitches y la ISR.
+ */
+esp_err_t button_init(void);
+
+/**
+ * @brief Registra el callback de eventos (NULL para quitarlo).
+ */
+void button_set_callback(button_callback_t cb, void *arg);
+
+/**
+ * @brief Estado antirrebote actual del botón.
+ */
+bool button_is_pressed(void);
+
+/**
+ * @brief Nombre del evento ("PRESS", "SHORT", ...).
+ */
+const char *button_event_name(button_event_t event);
+
+#endif // BUTTON_H
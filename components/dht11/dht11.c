@@ -182,22 +182,38 @@ esp_err_t dht11_read(dht11_t *dht11, int connection_timeout)
 
     ESP_LOGD(TAG, "Data: %02X %02X %02X %02X [%02X]", received_data[0], received_data[1], received_data[2], received_data[3], received_data[4]);
 
-    /* Verificar checksum */
-    uint8_t crc = received_data[0] + received_data[1] + received_data[2] + received_data[3];
-    if (crc == received_data[4]) {
-        dht11->humidity = received_data[0] + (received_data[1] / 10.0);
-        dht11->temperature = received_data[2] + (received_data[3] / 10.0);
-
-        /* Rango razonable de lectura */
-        if (dht11->humidity > 100.0 || dht11->temperature > 50.0) {
-            ESP_LOGE(TAG, "Invalid readings: Temp=%.1f, Hum=%.1f", dht11->temperature, dht11->humidity);
-            return ESP_ERR_INVALID_RESPONSE;
-        }
-
+    esp_err_t ret = dht11_decode(dht11, received_data);
+    if (ret == ESP_OK) {
         ESP_LOGI(TAG, "Read successful: Temp=%.1f°C, Humidity=%.1f%%", dht11->temperature, dht11->humidity);
-        return ESP_OK;
-    } else {
-        ESP_LOGE(TAG, "Checksum error: calc=0x%02X, recv=0x%02X", crc, received_data[4]);
+    }
+    return ret;
+}
+
+
+/**
+ * dht11_decode: valida el checksum de la trama de 5 bytes y la convierte
+ * en temperatura y humedad. Separada de dht11_read para poder medirla y
+ * reutilizarla sin acceder al sensor.
+ */
+esp_err_t dht11_decode(dht11_t *dht11, const uint8_t data[5])
+{
+    /* Verificar checksum */
+    uint8_t crc = data[0] + data[1] + data[2] + data[3];
+    if (crc != data[4]) {
+        ESP_LOGE(TAG, "Checksum error: calc=0x%02X, recv=0x%02X", crc, data[4]);
         return ESP_ERR_INVALID_CRC;
     }
+
+    float humidity = data[0] + (data[1] / 10.0);
+    float temperature = data[2] + (data[3] / 10.0);
+
+    /* Rango razonable de lectura */
+    if (humidity > 100.0 || temperature > 50.0) {
+        ESP_LOGE(TAG, "Invalid readings: Temp=%.1f, Hum=%.1f", temperature, humidity);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    dht11->humidity = humidity;
+    dht11->temperature = temperature;
+    return ESP_OK;
 }
\ No newline at end of file
@@ -61,4 +61,13 @@ void hold_low(dht11_t dht11, int hold_time_us);
  */
 esp_err_t dht11_read(dht11_t *dht11, int connection_timeout);
 
+/**
+ * Valida y decodifica una trama de 40 bits ya recibida.
+ * Solo actualiza `dht11` si el checksum y el rango son válidos.
+ * @param dht11 Estructura donde se guardan temperatura y humedad
+ * @param data  Los 5 bytes recibidos (hum, hum_dec, temp, temp_dec, checksum)
+ * @return ESP_OK, ESP_ERR_INVALID_CRC o ESP_ERR_INVALID_RESPONSE
+ */
+esp_err_t dht11_decode(dht11_t *dht11, const uint8_t data[5]);
+
 #endif /* _DHT_11 */
\ No newline at end of file
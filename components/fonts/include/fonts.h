@@ -20,6 +20,14 @@
  */
 extern const uint8_t font_5x7[95][5];
 
+/*
+ * Glifos desplazados 0..7 filas hacia abajo, para dibujar texto en una y
+ * que no es múltiplo de 8: font_5x7_shifted[y % 8][c - 32][col]. El byte
+ * bajo va a la página de y y el alto a la siguiente (formato de página
+ * del SSD1306: bit 0 = fila superior). Generadas en compilación.
+ */
+extern const uint16_t font_5x7_shifted[8][95][5];
+
 /**
  * @brief Devuelve un puntero a la tabla de fuentes 5x7.
  * @return const uint8_t* Apunta al primer elemento de `font_5x7`.
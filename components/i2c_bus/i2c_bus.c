@@ -0,0 +1,673 @@
+/**
+ * @file i2c_bus.c
+ * @brief Gestor del bus I2C compartido: una tarea ejecuta las transacciones
+ *        de todos los dispositivos por orden de prioridad.
+ *
+ * Cada dispositivo tiene a lo sumo una petición en vuelo (su mutex
+ * serializa a quienes lo usan), así que las colas por prioridad nunca se
+ * llenan con I2C_BUS_MAX_DEVICES entradas. La petición vive en el propio
+ * dispositivo y la tarea del bus avisa del final con su semáforo `done`.
+ *
+ * Con ESP-IDF >= 5.2 se usa el driver i2c_master (un handle por
+ * dispositivo, con su propia velocidad); si no, el driver clásico con un
+ * enlace de comandos estático que solo usa la tarea del bus.
+ *
+ * El handle de un dispositivo solo se sustituye (cambio de velocidad) con
+ * su mutex tomado o desde la tarea del bus mientras ejecuta su petición:
+ * en ambos casos nadie más lo está usando.
+ *
+ * La recuperación del bus también la hace la tarea del bus, entre dos
+ * transacciones: nadie más toca el periférico.
+ *
+ * La vigilancia de velocidad solo cuenta errores que apuntan a la señal:
+ * timeouts y NACK aislados (uno seguido de una transacción correcta). Un
+ * dispositivo desconectado da NACK seguidos, que no cuentan, y mientras
+ * su driver lo marca ausente no se vigila. Las bajadas se guardan en NVS
+ * desde un esp_timer, no desde la tarea del bus: el commit la bloquearía
+ * con todos los dispositivos esperando.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#include "i2c_bus.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_idf_version.h"
+#include "nvs.h"
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+#include "driver/i2c_master.h"
+#define I2C_BUS_USE_MASTER 1
+#else
+#include "driver/i2c.h"
+#include "driver/gpio.h"
+#include "esp_rom_sys.h"
+#define I2C_BUS_USE_MASTER 0
+#endif
+
+static const char *TAG = "I2C_BUS";
+
+typedef struct {
+    i2c_bus_device_t *dev;
+    const uint8_t *write;
+    size_t write_len;
+    uint8_t *read;
+    size_t read_len;
+    int64_t queued_at;
+    uint32_t bus_us;          /* Duración de esta transacción */
+    esp_err_t result;
+} i2c_bus_request_t;
+
+struct i2c_bus_device {
+    i2c_bus_device_stats_t stats;
+    uint32_t timeout_ms;
+    uint32_t base_hz;         /* Velocidad de configuración: suelo de las bajadas */
+    uint16_t window_count;    /* Ventana de vigilancia de errores */
+    uint16_t window_errors;
+    uint8_t nack_streak;      /* NACK seguidos (tarea del bus) */
+    bool tuning;              /* Calibrando: sin bajadas automáticas */
+    volatile bool absent;     /* Marcado por su driver: sin vigilancia */
+    volatile bool save_pending; /* Velocidad por guardar (s_save_timer) */
+    SemaphoreHandle_t lock;   /* Una petición en vuelo por dispositivo */
+    SemaphoreHandle_t done;   /* La tarea del bus la da al terminar */
+    i2c_bus_request_t req;
+#if I2C_BUS_USE_MASTER
+    i2c_master_dev_handle_t handle;
+#endif
+};
+
+static const uint32_t s_speed_steps[] = I2C_BUS_TUNE_STEPS_HZ;
+#define NUM_SPEED_STEPS (sizeof(s_speed_steps) / sizeof(s_speed_steps[0]))
+
+static i2c_bus_device_t s_devices[I2C_BUS_MAX_DEVICES];
+static size_t s_device_count = 0;
+static SemaphoreHandle_t s_devices_mutex = NULL;
+
+static QueueHandle_t s_queues[I2C_BUS_PRIO_COUNT];   /* i2c_bus_request_t * */
+static SemaphoreHandle_t s_pending = NULL;           /* Peticiones encoladas */
+static TaskHandle_t s_task = NULL;
+static uint32_t s_recoveries = 0;
+static esp_timer_handle_t s_save_timer = NULL;       /* Guarda las bajadas en NVS */
+
+#if I2C_BUS_USE_MASTER
+static i2c_master_bus_handle_t s_bus = NULL;
+#else
+/* START, dirección, escritura, START, dirección, lectura, STOP */
+#define I2C_BUS_LINK_CMDS 7
+static uint8_t s_link_buf[I2C_LINK_RECOMMENDED_SIZE(I2C_BUS_LINK_CMDS)];
+#endif
+
+
+#if !I2C_BUS_USE_MASTER
+/* Configura el puerto e instala el driver clásico (arranque y recuperación) */
+static esp_err_t i2c_bus_port_init(void)
+{
+    i2c_config_t conf = {
+        .mode = I2C_MODE_MASTER,
+        .sda_io_num = I2C_BUS_SDA_IO,
+        .scl_io_num = I2C_BUS_SCL_IO,
+        .sda_pullup_en = GPIO_PULLUP_ENABLE,
+        .scl_pullup_en = GPIO_PULLUP_ENABLE,
+        .master.clk_speed = I2C_BUS_FREQ_HZ,
+    };
+    esp_err_t ret = i2c_param_config(I2C_BUS_PORT, &conf);
+    if (ret == ESP_OK) {
+        ret = i2c_driver_install(I2C_BUS_PORT, conf.mode, 0, 0, 0);
+    }
+    return ret;
+}
+
+/*
+ * Libera SDA a mano: con el driver desinstalado, pulsos de SCL (medio
+ * periodo de 5 us, ~100 kHz) hasta que el esclavo suelta SDA, y una
+ * condición STOP para que vuelva a reposo.
+ */
+static void i2c_bus_clock_out(void)
+{
+    gpio_config_t io = {
+        .pin_bit_mask = (1ULL << I2C_BUS_SDA_IO) | (1ULL << I2C_BUS_SCL_IO),
+        .mode = GPIO_MODE_INPUT_OUTPUT_OD,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    gpio_config(&io);
+    gpio_set_level(I2C_BUS_SDA_IO, 1);
+    gpio_set_level(I2C_BUS_SCL_IO, 1);
+    esp_rom_delay_us(5);
+
+    for (int i = 0; i < I2C_BUS_RECOVER_PULSES && gpio_get_level(I2C_BUS_SDA_IO) == 0; i++) {
+        gpio_set_level(I2C_BUS_SCL_IO, 0);
+        esp_rom_delay_us(5);
+        gpio_set_level(I2C_BUS_SCL_IO, 1);
+        esp_rom_delay_us(5);
+    }
+
+    /* STOP: SDA sube con SCL alto */
+    gpio_set_level(I2C_BUS_SCL_IO, 0);
+    esp_rom_delay_us(5);
+    gpio_set_level(I2C_BUS_SDA_IO, 0);
+    esp_rom_delay_us(5);
+    gpio_set_level(I2C_BUS_SCL_IO, 1);
+    esp_rom_delay_us(5);
+    gpio_set_level(I2C_BUS_SDA_IO, 1);
+    esp_rom_delay_us(5);
+}
+#endif
+
+/*
+ * Recupera el bus tras un timeout (tarea del bus): libera SDA si un
+ * esclavo lo retiene y reinicia la máquina de estados del periférico.
+ * Los handles de los dispositivos siguen siendo válidos.
+ */
+static void i2c_bus_recover(const i2c_bus_device_t *dev)
+{
+#if I2C_BUS_USE_MASTER
+    /* Genera los pulsos de liberación y reinicia el controlador */
+    esp_err_t ret = i2c_master_bus_reset(s_bus);
+#else
+    i2c_driver_delete(I2C_BUS_PORT);
+    i2c_bus_clock_out();
+    esp_err_t ret = i2c_bus_port_init();
+#endif
+    s_recoveries++;
+    if (ret == ESP_OK) {
+        ESP_LOGW(TAG, "Timeout con %s: bus recuperado", dev->stats.name);
+    } else {
+        ESP_LOGE(TAG, "Timeout con %s: error recuperando el bus: %s", dev->stats.name,
+                 esp_err_to_name(ret));
+    }
+}
+
+
+/* Velocidad --------------------------------------------------------------- */
+#if I2C_BUS_USE_MASTER
+static uint32_t i2c_bus_load_speed(const char *name)
+{
+    nvs_handle_t handle;
+    uint32_t hz = 0;
+
+    if (nvs_open(I2C_BUS_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return 0;
+    }
+    if (nvs_get_u32(handle, name, &hz) != ESP_OK) {
+        hz = 0;
+    }
+    nvs_close(handle);
+    return hz;
+}
+#endif
+
+static void i2c_bus_save_speed(const i2c_bus_device_t *dev)
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(I2C_BUS_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret == ESP_OK) {
+        ret = nvs_set_u32(handle, dev->stats.name, dev->stats.scl_hz);
+        if (ret == ESP_OK) {
+            ret = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "%s: no se pudo guardar la velocidad: %s", dev->stats.name, esp_err_to_name(ret));
+    }
+}
+
+/* Cambia la velocidad del dispositivo (acceso exclusivo a su handle) */
+static esp_err_t i2c_bus_apply_speed(i2c_bus_device_t *dev, uint32_t hz)
+{
+    if (hz == dev->stats.scl_hz) {
+        return ESP_OK;
+    }
+#if I2C_BUS_USE_MASTER
+    /* Primero el nuevo handle: si falla, el dispositivo sigue con el anterior */
+    i2c_device_config_t dev_cfg = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = dev->stats.address,
+        .scl_speed_hz = hz,
+    };
+    i2c_master_dev_handle_t handle = NULL;
+    esp_err_t ret = i2c_master_bus_add_device(s_bus, &dev_cfg, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    i2c_master_bus_rm_device(dev->handle);
+    dev->handle = handle;
+    dev->stats.scl_hz = hz;
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+/* Guarda las velocidades pendientes (tarea de esp_timer) */
+static void i2c_bus_save_timer_cb(void *arg)
+{
+    for (size_t i = 0; i < s_device_count; i++) {
+        i2c_bus_device_t *dev = &s_devices[i];
+        if (dev->save_pending) {
+            dev->save_pending = false;
+            i2c_bus_save_speed(dev);
+        }
+    }
+}
+
+/* NACK (a la dirección o a un dato) o dispositivo que no responde */
+static bool i2c_bus_is_nack(esp_err_t result)
+{
+#if I2C_BUS_USE_MASTER
+    return result == ESP_ERR_INVALID_STATE || result == ESP_ERR_INVALID_RESPONSE ||
+           result == ESP_ERR_NOT_FOUND;
+#else
+    return result == ESP_FAIL || result == ESP_ERR_NOT_FOUND;
+#endif
+}
+
+/*
+ * Vigilancia en marcha (tarea del bus, tras cada transacción): demasiados
+ * errores de señal en la ventana bajan un paso de velocidad, sin pasar de
+ * la de configuración. Un NACK se decide con la transacción siguiente:
+ * si es correcta, el dispositivo estaba y cuenta como error; si también
+ * es NACK, lo más probable es que no esté y no cuenta ninguno.
+ */
+static void i2c_bus_monitor(i2c_bus_device_t *dev, esp_err_t result)
+{
+    if (dev->tuning || dev->absent) {
+        dev->nack_streak = 0;
+        dev->window_count = 0;
+        dev->window_errors = 0;
+        return;
+    }
+
+    bool error;
+    if (result == ESP_OK) {
+        error = (dev->nack_streak == 1);
+        dev->nack_streak = 0;
+    } else if (i2c_bus_is_nack(result)) {
+        if (dev->nack_streak < UINT8_MAX) {
+            dev->nack_streak++;
+        }
+        return;
+    } else if (result == ESP_ERR_TIMEOUT) {
+        error = true;
+        dev->nack_streak = 0;
+    } else {
+        return;   /* Error del driver, no del bus */
+    }
+
+    dev->window_count++;
+    if (error) {
+        dev->window_errors++;
+    }
+
+    if (dev->window_errors >= I2C_BUS_ERR_MAX) {
+        uint32_t lower = dev->base_hz;
+        for (size_t i = 0; i < NUM_SPEED_STEPS; i++) {
+            if (s_speed_steps[i] < dev->stats.scl_hz && s_speed_steps[i] > lower) {
+                lower = s_speed_steps[i];
+            }
+        }
+        if (lower < dev->stats.scl_hz && i2c_bus_apply_speed(dev, lower) == ESP_OK) {
+            dev->stats.speed_fallbacks++;
+            ESP_LOGW(TAG, "%s: %u errores en %u transacciones, baja a %lu Hz", dev->stats.name,
+                     dev->window_errors, dev->window_count, (unsigned long)lower);
+            dev->save_pending = true;
+            if (s_save_timer != NULL && !esp_timer_is_active(s_save_timer)) {
+                esp_timer_start_once(s_save_timer, (uint64_t)I2C_BUS_SAVE_DELAY_MS * 1000);
+            }
+        }
+        dev->window_count = 0;
+        dev->window_errors = 0;
+    } else if (dev->window_count >= I2C_BUS_ERR_WINDOW) {
+        dev->window_count = 0;
+        dev->window_errors = 0;
+    }
+}
+
+
+/* Tarea del bus ----------------------------------------------------------- */
+static esp_err_t i2c_bus_execute(const i2c_bus_request_t *req)
+{
+    i2c_bus_device_t *dev = req->dev;
+
+#if I2C_BUS_USE_MASTER
+    if (req->read_len == 0) {
+        return i2c_master_transmit(dev->handle, req->write, req->write_len, dev->timeout_ms);
+    }
+    if (req->write_len == 0) {
+        return i2c_master_receive(dev->handle, req->read, req->read_len, dev->timeout_ms);
+    }
+    return i2c_master_transmit_receive(dev->handle, req->write, req->write_len,
+                                       req->read, req->read_len, dev->timeout_ms);
+#else
+    uint8_t addr = dev->stats.address;
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(s_link_buf, sizeof(s_link_buf));
+    i2c_master_start(cmd);
+    if (req->write_len > 0) {
+        i2c_master_write_byte(cmd, (addr << 1) | I2C_MASTER_WRITE, true);
+        i2c_master_write(cmd, req->write, req->write_len, true);
+    }
+    if (req->read_len > 0) {
+        if (req->write_len > 0) {
+            i2c_master_start(cmd);   /* Repeated START */
+        }
+        i2c_master_write_byte(cmd, (addr << 1) | I2C_MASTER_READ, true);
+        i2c_master_read(cmd, req->read, req->read_len, I2C_MASTER_LAST_NACK);
+    }
+    i2c_master_stop(cmd);
+    esp_err_t ret = i2c_master_cmd_begin(I2C_BUS_PORT, cmd, pdMS_TO_TICKS(dev->timeout_ms));
+    i2c_cmd_link_delete_static(cmd);
+    return ret;
+#endif
+}
+
+static void i2c_bus_task(void *arg)
+{
+    for (;;) {
+        xSemaphoreTake(s_pending, portMAX_DELAY);
+
+        /* La pendiente de mayor prioridad; la transacción en curso nunca
+         * se interrumpe, así que se adelanta en las fronteras */
+        i2c_bus_request_t *req = NULL;
+        for (int prio = 0; prio < I2C_BUS_PRIO_COUNT; prio++) {
+            if (xQueueReceive(s_queues[prio], &req, 0) == pdTRUE) {
+                break;
+            }
+            req = NULL;
+        }
+        if (req == NULL) {
+            continue;
+        }
+
+        i2c_bus_device_t *dev = req->dev;
+        int64_t start = esp_timer_get_time();
+        req->result = i2c_bus_execute(req);
+        int64_t end = esp_timer_get_time();
+
+        i2c_bus_device_stats_t *st = &dev->stats;
+        uint32_t wait_us = (uint32_t)(start - req->queued_at);
+        req->bus_us = (uint32_t)(end - start);
+        st->transactions++;
+        st->bus_us += req->bus_us;
+        st->wait_us_total += wait_us;
+        if (st->wait_us_max < wait_us) {
+            st->wait_us_max = wait_us;
+        }
+        if (req->result == ESP_OK) {
+            st->bytes_written += req->write_len;
+            st->bytes_read += req->read_len;
+        } else {
+            st->errors++;
+        }
+        i2c_bus_monitor(dev, req->result);
+        if (req->result == ESP_ERR_TIMEOUT) {
+            i2c_bus_recover(dev);
+        }
+
+        xSemaphoreGive(dev->done);
+    }
+}
+
+
+/* API pública ------------------------------------------------------------- */
+esp_err_t i2c_bus_init(void)
+{
+    if (s_task != NULL) {
+        return ESP_OK;
+    }
+
+#if I2C_BUS_USE_MASTER
+    i2c_master_bus_config_t bus_cfg = {
+        .i2c_port = I2C_BUS_PORT,
+        .sda_io_num = I2C_BUS_SDA_IO,
+        .scl_io_num = I2C_BUS_SCL_IO,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .flags.enable_internal_pullup = true,
+    };
+    esp_err_t ret = i2c_new_master_bus(&bus_cfg, &s_bus);
+#else
+    esp_err_t ret = i2c_bus_port_init();
+#endif
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error inicializando el puerto I2C: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    const esp_timer_create_args_t save_args = {
+        .callback = i2c_bus_save_timer_cb,
+        .name = "i2c_bus_save",
+    };
+    ret = esp_timer_create(&save_args, &s_save_timer);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    s_devices_mutex = xSemaphoreCreateMutex();
+    s_pending = xSemaphoreCreateCounting(I2C_BUS_MAX_DEVICES, 0);
+    for (int prio = 0; prio < I2C_BUS_PRIO_COUNT; prio++) {
+        s_queues[prio] = xQueueCreate(I2C_BUS_MAX_DEVICES, sizeof(i2c_bus_request_t *));
+        if (s_queues[prio] == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (s_devices_mutex == NULL || s_pending == NULL ||
+        xTaskCreate(i2c_bus_task, "i2c_bus", I2C_BUS_TASK_STACK, NULL,
+                    I2C_BUS_TASK_PRIORITY, &s_task) != pdPASS) {
+        ESP_LOGE(TAG, "No se pudo crear la tarea del bus");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Bus I2C: SDA=%d SCL=%d, %d Hz", I2C_BUS_SDA_IO, I2C_BUS_SCL_IO, I2C_BUS_FREQ_HZ);
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_add_device(const i2c_bus_device_config_t *config, i2c_bus_device_t **out)
+{
+    if (config == NULL || out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_task == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_devices_mutex, portMAX_DELAY);
+    if (s_device_count >= I2C_BUS_MAX_DEVICES) {
+        xSemaphoreGive(s_devices_mutex);
+        ESP_LOGE(TAG, "Sin hueco para el dispositivo %s", config->name ? config->name : "?");
+        return ESP_ERR_NO_MEM;
+    }
+
+    i2c_bus_device_t *dev = &s_devices[s_device_count];
+    memset(dev, 0, sizeof(*dev));
+    dev->stats.name = config->name ? config->name : "?";
+    dev->stats.address = config->address;
+    dev->timeout_ms = config->timeout_ms ? config->timeout_ms : I2C_BUS_TIMEOUT_MS;
+    dev->base_hz = config->scl_speed_hz ? config->scl_speed_hz : I2C_BUS_FREQ_HZ;
+    uint32_t speed = dev->base_hz;
+
+    esp_err_t ret = ESP_OK;
+    dev->lock = xSemaphoreCreateMutex();
+    dev->done = xSemaphoreCreateBinary();
+    if (dev->lock == NULL || dev->done == NULL) {
+        ret = ESP_ERR_NO_MEM;
+    }
+#if I2C_BUS_USE_MASTER
+    /* Velocidad calibrada en un arranque anterior, si está dentro de los pasos */
+    uint32_t saved = i2c_bus_load_speed(dev->stats.name);
+    if (saved > speed && saved <= s_speed_steps[NUM_SPEED_STEPS - 1]) {
+        speed = saved;
+    }
+    if (ret == ESP_OK) {
+        i2c_device_config_t dev_cfg = {
+            .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+            .device_address = config->address,
+            .scl_speed_hz = speed,
+        };
+        ret = i2c_master_bus_add_device(s_bus, &dev_cfg, &dev->handle);
+    }
+#else
+    if (speed != I2C_BUS_FREQ_HZ) {
+        ESP_LOGW(TAG, "%s: el driver clásico usa %d Hz para todo el bus",
+                 dev->stats.name, I2C_BUS_FREQ_HZ);
+    }
+#endif
+    if (ret != ESP_OK) {
+        xSemaphoreGive(s_devices_mutex);
+        ESP_LOGE(TAG, "Error registrando %s: %s", dev->stats.name, esp_err_to_name(ret));
+        return ret;
+    }
+
+    dev->stats.scl_hz = speed;
+    s_device_count++;
+    xSemaphoreGive(s_devices_mutex);
+
+    ESP_LOGI(TAG, "Dispositivo %s en 0x%02X, %lu Hz", dev->stats.name, config->address,
+             (unsigned long)speed);
+    *out = dev;
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_transfer(i2c_bus_device_t *dev, i2c_bus_prio_t prio,
+                           const uint8_t *write, size_t write_len,
+                           uint8_t *read, size_t read_len)
+{
+    return i2c_bus_transfer_timed(dev, prio, write, write_len, read, read_len, NULL);
+}
+
+esp_err_t i2c_bus_transfer_timed(i2c_bus_device_t *dev, i2c_bus_prio_t prio,
+                                 const uint8_t *write, size_t write_len,
+                                 uint8_t *read, size_t read_len, uint32_t *bus_us)
+{
+    if (dev == NULL || prio >= I2C_BUS_PRIO_COUNT || (write_len == 0 && read_len == 0) ||
+        (write_len > 0 && write == NULL) || (read_len > 0 && read == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(dev->lock, portMAX_DELAY);
+
+    i2c_bus_request_t *req = &dev->req;
+    req->dev = dev;
+    req->write = write;
+    req->write_len = write_len;
+    req->read = read;
+    req->read_len = read_len;
+    req->queued_at = esp_timer_get_time();
+
+    /* Nunca bloquea: como mucho una petición por dispositivo en las colas */
+    xQueueSend(s_queues[prio], &req, portMAX_DELAY);
+    xSemaphoreGive(s_pending);
+    xSemaphoreTake(dev->done, portMAX_DELAY);
+
+    esp_err_t ret = req->result;
+    if (bus_us) {
+        *bus_us = req->bus_us;
+    }
+    xSemaphoreGive(dev->lock);
+    return ret;
+}
+
+esp_err_t i2c_bus_write(i2c_bus_device_t *dev, i2c_bus_prio_t prio, const uint8_t *buf, size_t len)
+{
+    return i2c_bus_transfer(dev, prio, buf, len, NULL, 0);
+}
+
+esp_err_t i2c_bus_calibrate(i2c_bus_device_t *dev, const uint8_t *probe, size_t len, uint32_t *out_hz)
+{
+    if (dev == NULL || probe == NULL || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if !I2C_BUS_USE_MASTER
+    return ESP_ERR_NOT_SUPPORTED;
+#else
+    uint32_t best = dev->base_hz;
+    dev->tuning = true;
+
+    for (size_t i = 0; i < NUM_SPEED_STEPS; i++) {
+        uint32_t hz = s_speed_steps[i];
+        if (hz < dev->base_hz) {
+            continue;
+        }
+
+        xSemaphoreTake(dev->lock, portMAX_DELAY);
+        esp_err_t ret = i2c_bus_apply_speed(dev, hz);
+        xSemaphoreGive(dev->lock);
+        if (ret != ESP_OK) {
+            break;
+        }
+
+        /* Todas deben recibir ACK: al primer error se descarta el paso */
+        int ok = 0;
+        while (ok < I2C_BUS_TUNE_TRIALS && i2c_bus_write(dev, I2C_BUS_PRIO_NORMAL, probe, len) == ESP_OK) {
+            ok++;
+        }
+        ESP_LOGI(TAG, "%s: %lu Hz, %d/%d transacciones correctas", dev->stats.name,
+                 (unsigned long)hz, ok, I2C_BUS_TUNE_TRIALS);
+        if (ok < I2C_BUS_TUNE_TRIALS) {
+            break;
+        }
+        best = hz;
+    }
+
+    xSemaphoreTake(dev->lock, portMAX_DELAY);
+    esp_err_t ret = i2c_bus_apply_speed(dev, best);
+    dev->window_count = 0;
+    dev->window_errors = 0;
+    dev->tuning = false;
+    xSemaphoreGive(dev->lock);
+
+    if (ret == ESP_OK) {
+        i2c_bus_save_speed(dev);
+        ESP_LOGI(TAG, "%s: velocidad calibrada %lu Hz", dev->stats.name, (unsigned long)best);
+    }
+    if (out_hz) {
+        *out_hz = dev->stats.scl_hz;
+    }
+    return ret;
+#endif
+}
+
+void i2c_bus_set_absent(i2c_bus_device_t *dev, bool absent)
+{
+    if (dev != NULL) {
+        dev->absent = absent;
+    }
+}
+
+uint32_t i2c_bus_get_speed(const i2c_bus_device_t *dev)
+{
+    return dev ? dev->stats.scl_hz : 0;
+}
+
+uint32_t i2c_bus_get_bus_us(const i2c_bus_device_t *dev)
+{
+    return dev ? dev->stats.bus_us : 0;
+}
+
+uint32_t i2c_bus_get_recoveries(void)
+{
+    return s_recoveries;
+}
+
+size_t i2c_bus_get_device_count(void)
+{
+    return s_device_count;
+}
+
+esp_err_t i2c_bus_get_device_stats(size_t index, i2c_bus_device_stats_t *out)
+{
+    if (out == NULL || index >= s_device_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out = s_devices[index].stats;
+    return ESP_OK;
+}
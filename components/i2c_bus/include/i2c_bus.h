@@ -0,0 +1,179 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @file i2c_bus.h
+ * @brief Gestor del bus I2C compartido: cola de transacciones con prioridad.
+ *
+ * El componente es el único dueño del puerto I2C. Los drivers de cada
+ * dispositivo (OLED, sensores...) registran su dispositivo y piden
+ * transacciones con una prioridad; una tarea del bus las ejecuta de una
+ * en una, siempre la pendiente de mayor prioridad. Así una lectura de un
+ * sensor adelanta a las transacciones de una trama de la pantalla que
+ * aún no salieron (la transacción en curso no se interrumpe).
+ *
+ * Cada llamada bloquea a quien la hace hasta que su transacción termina.
+ * Por dispositivo se contabilizan transacciones, bytes, errores, tiempo
+ * de bus y espera en cola.
+ *
+ * Velocidad por dispositivo: i2c_bus_calibrate() la sube por
+ * I2C_BUS_TUNE_STEPS_HZ mientras las transacciones de prueba reciben ACK
+ * y la guarda en NVS (se aplica al registrar el dispositivo en el
+ * siguiente arranque). En marcha, si los errores de señal (timeouts y
+ * NACK aislados) de una ventana de I2C_BUS_ERR_WINDOW transacciones
+ * llegan a I2C_BUS_ERR_MAX, baja un paso (nunca por debajo de la
+ * velocidad de configuración) y lo guarda. Los NACK seguidos de un
+ * dispositivo desconectado no cuentan, ni nada mientras su driver lo
+ * marque ausente (i2c_bus_set_absent).
+ *
+ * Recuperación: si una transacción agota su timeout (bus colgado, p.ej.
+ * un esclavo que retiene SDA a mitad de un byte), la tarea del bus libera
+ * SDA con hasta I2C_BUS_RECOVER_PULSES pulsos de SCL y una condición STOP
+ * y reinicia el periférico antes de atender la siguiente. Así el peor
+ * caso de una transacción queda acotado por su timeout más la
+ * recuperación, y un dispositivo colgado no bloquea a los demás.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+/* -----------------------------
+ * Configuración
+ * ----------------------------- */
+#define I2C_BUS_PORT            I2C_NUM_0
+#define I2C_BUS_SDA_IO          5          /* Pin SDA */
+#define I2C_BUS_SCL_IO          6          /* Pin SCL */
+#define I2C_BUS_FREQ_HZ         400000     /* Velocidad por defecto */
+#define I2C_BUS_MAX_DEVICES     4
+#define I2C_BUS_TIMEOUT_MS      50         /* Timeout por defecto por transacción */
+#define I2C_BUS_TASK_STACK      3072
+#define I2C_BUS_TASK_PRIORITY   6          /* Por encima de quienes encolan */
+#define I2C_BUS_RECOVER_PULSES  9          /* Pulsos SCL para liberar SDA */
+
+/* Ajuste de velocidad */
+#define I2C_BUS_TUNE_STEPS_HZ   { 400000, 600000, 800000, 1000000 }
+#define I2C_BUS_TUNE_TRIALS     50         /* Transacciones de prueba por paso */
+#define I2C_BUS_ERR_WINDOW      64         /* Transacciones por ventana de vigilancia */
+#define I2C_BUS_ERR_MAX         3          /* Errores en una ventana para bajar un paso */
+#define I2C_BUS_SAVE_DELAY_MS   1000       /* Guardado en NVS de una bajada, fuera de la tarea del bus */
+#define I2C_BUS_NVS_NAMESPACE   "i2c_bus"  /* Clave = nombre del dispositivo */
+
+/** Prioridad de una transacción (menor valor = antes) */
+typedef enum {
+    I2C_BUS_PRIO_HIGH = 0,   /* Lecturas de sensores, control */
+    I2C_BUS_PRIO_NORMAL,
+    I2C_BUS_PRIO_LOW,        /* Tramas de pantalla */
+    I2C_BUS_PRIO_COUNT,
+} i2c_bus_prio_t;
+
+/** Dispositivo registrado (opaco) */
+typedef struct i2c_bus_device i2c_bus_device_t;
+
+typedef struct {
+    const char *name;        /* Estadísticas, logs y clave NVS (máx. 15 caracteres) */
+    uint8_t address;         /* Dirección de 7 bits */
+    uint32_t scl_speed_hz;   /* 0 = I2C_BUS_FREQ_HZ (driver clásico: siempre la del bus) */
+    uint32_t timeout_ms;     /* 0 = I2C_BUS_TIMEOUT_MS */
+} i2c_bus_device_config_t;
+
+/** Contabilidad por dispositivo */
+typedef struct {
+    const char *name;
+    uint8_t address;
+    uint32_t transactions;
+    uint32_t errors;
+    uint32_t bytes_written;
+    uint32_t bytes_read;
+    uint32_t bus_us;         /* Tiempo total ejecutando sus transacciones */
+    uint32_t wait_us_max;    /* Mayor espera en cola (latencia añadida por otros) */
+    uint32_t wait_us_total;
+    uint32_t scl_hz;         /* Velocidad actual */
+    uint32_t speed_fallbacks; /* Bajadas de velocidad por tasa de errores */
+} i2c_bus_device_stats_t;
+
+/**
+ * @brief Configura el puerto y arranca la tarea del bus. Idempotente.
+ */
+esp_err_t i2c_bus_init(void);
+
+/**
+ * @brief Registra un dispositivo en el bus.
+ *
+ * @param config Dirección, velocidad y timeout.
+ * @param out    Recibe el handle del dispositivo.
+ * @return ESP_ERR_NO_MEM si ya hay I2C_BUS_MAX_DEVICES.
+ */
+esp_err_t i2c_bus_add_device(const i2c_bus_device_config_t *config, i2c_bus_device_t **out);
+
+/**
+ * @brief Ejecuta una transacción: escribe `write` (si write_len > 0) y,
+ * con repeated START, lee `read_len` bytes en `read` (si read_len > 0).
+ *
+ * Bloquea hasta que la tarea del bus la completa. Las de un mismo
+ * dispositivo se ejecutan en orden de llamada.
+ */
+esp_err_t i2c_bus_transfer(i2c_bus_device_t *dev, i2c_bus_prio_t prio,
+                           const uint8_t *write, size_t write_len,
+                           uint8_t *read, size_t read_len);
+
+/**
+ * @brief Como i2c_bus_transfer(), y devuelve en `bus_us` (puede ser NULL)
+ * lo que ocupó el bus esta transacción, sin la espera en cola.
+ *
+ * Para repartir tiempo de bus entre varios llamantes del mismo
+ * dispositivo: la diferencia de i2c_bus_get_bus_us() antes y después
+ * incluye las transacciones de los demás que se colaron entre medias.
+ */
+esp_err_t i2c_bus_transfer_timed(i2c_bus_device_t *dev, i2c_bus_prio_t prio,
+                                 const uint8_t *write, size_t write_len,
+                                 uint8_t *read, size_t read_len, uint32_t *bus_us);
+
+/** Escritura simple (atajo de i2c_bus_transfer) */
+esp_err_t i2c_bus_write(i2c_bus_device_t *dev, i2c_bus_prio_t prio, const uint8_t *buf, size_t len);
+
+/**
+ * @brief Busca la velocidad estable más alta del dispositivo.
+ *
+ * Desde su velocidad de configuración, prueba cada paso de
+ * I2C_BUS_TUNE_STEPS_HZ con I2C_BUS_TUNE_TRIALS escrituras de `probe`
+ * (debe ser inocua para el dispositivo, p.ej. comandos NOP) y se detiene
+ * en el primero con algún error. Aplica el último paso sin errores y lo
+ * guarda en NVS.
+ *
+ * @param out_hz Recibe la velocidad elegida (puede ser NULL).
+ * @return ESP_ERR_NOT_SUPPORTED con el driver clásico (velocidad única
+ *         para todo el bus).
+ */
+esp_err_t i2c_bus_calibrate(i2c_bus_device_t *dev, const uint8_t *probe, size_t len, uint32_t *out_hz);
+
+/**
+ * @brief Marca el dispositivo como ausente (p.ej. el disyuntor de su
+ * driver lo dio por desconectado) o presente de nuevo. Mientras está
+ * ausente sus errores no cuentan para bajar la velocidad.
+ */
+void i2c_bus_set_absent(i2c_bus_device_t *dev, bool absent);
+
+/** Velocidad SCL actual del dispositivo, en Hz */
+uint32_t i2c_bus_get_speed(const i2c_bus_device_t *dev);
+
+/** Tiempo de bus acumulado por el dispositivo, en us */
+uint32_t i2c_bus_get_bus_us(const i2c_bus_device_t *dev);
+
+/** Recuperaciones del bus (SDA liberado y periférico reiniciado) */
+uint32_t i2c_bus_get_recoveries(void);
+
+/** Número de dispositivos registrados */
+size_t i2c_bus_get_device_count(void);
+
+/**
+ * @brief Copia la contabilidad del dispositivo `index` (0..count-1).
+ * @return ESP_ERR_INVALID_ARG si no existe.
+ */
+esp_err_t i2c_bus_get_device_stats(size_t index, i2c_bus_device_stats_t *out);
+
+#endif /* I2C_BUS_H */
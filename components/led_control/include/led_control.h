@@ -2,22 +2,43 @@
 #define LED_CONTROL_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 /**
  * @file led_control.h
- * @brief API para el control de un LED conectado a GPIO2.
+ * @brief API para el control de las salidas digitales (LED en GPIO2 y canales extra).
  *
- * Proporciona inicialización y funciones para leer/modificar el estado
- * del LED. La implementación mantiene un estado interno en RAM.
+ * Las salidas se definen en una tabla de pines (LED_CONTROL_CHANNEL_PINS);
+ * el canal 0 es el LED original en GPIO2. Cada canal es un bit de una
+ * máscara y los cambios de varios canales se aplican con una única
+ * escritura del registro de salida GPIO, de modo que conmutan a la vez.
+ *
+ * Todas las transiciones son atómicas (sección crítica) y pueden llamarse
+ * desde cualquier tarea. Cada transición que cambia la máscara incrementa
+ * una versión del estado; las funciones _from_isr son seguras en ISR y
+ * difieren a una tarea el seguimiento PWM y el guardado en NVS.
  *
  * Autor: migbertweb
  * Fecha: 2025-11-09
  */
 
+/* -----------------------------
+ * Configuración de canales
+ * ----------------------------- */
+/* Pines GPIO de cada canal, en orden (máx. LED_CONTROL_MAX_CHANNELS, GPIO < 32) */
+#ifndef LED_CONTROL_CHANNEL_PINS
+#define LED_CONTROL_CHANNEL_PINS  { 2, 3, 7, 10 }
+#endif
+
+#define LED_CONTROL_MAX_CHANNELS  16  /* Canales direccionables por máscara */
+#define LED_CONTROL_LED_CHANNEL   0   /* Canal del LED "principal" (GPIO2) */
+
 /**
- * @brief Inicializa el control del LED en GPIO2.
+ * @brief Inicializa el control del LED en GPIO2 y del resto de canales.
  *
- * Configura el pin como salida y pone el LED en estado apagado.
+ * Configura los pines de la tabla como salida con el último estado
+ * guardado (ver led_persist.h); sin estado válido arrancan apagados.
+ * Llamar después de nvs_flash_init().
  */
 void led_control_init(void);
 
@@ -30,12 +51,113 @@ bool led_control_get_state(void);
 /**
  * @brief Establece el estado del LED
  * @param state true para encender, false para apagar
+ * @return Versión del estado tras la transición
  */
-void led_control_set_state(bool state);
+uint32_t led_control_set_state(bool state);
 
 /**
  * @brief Cambia el estado del LED (toggle)
+ * @return Versión del estado tras la transición
+ */
+uint32_t led_control_toggle(void);
+
+
+/* -----------------------------
+ * Canales y grupos (máscaras)
+ * ----------------------------- */
+/**
+ * @brief Número de canales configurados en la tabla de pines.
+ */
+int led_control_get_channel_count(void);
+
+/**
+ * @brief GPIO asignado a un canal, o -1 si el canal no existe.
+ */
+int led_control_get_channel_pin(int channel);
+
+/**
+ * @brief Máscara con todos los canales configurados (bit i = canal i).
  */
-void led_control_toggle(void);
+uint32_t led_control_get_all_mask(void);
+
+/**
+ * @brief Máscara de canales encendidos (bit i = canal i).
+ */
+uint32_t led_control_get_mask(void);
+
+/**
+ * @brief Versión actual del estado (+1 en cada cambio de máscara).
+ */
+uint32_t led_control_get_version(void);
+
+/**
+ * @brief Lee de forma atómica la máscara y su versión.
+ */
+void led_control_get_snapshot(uint32_t *mask, uint32_t *version);
+
+/**
+ * @brief Compare-and-set: fija `new_mask` solo si la versión actual es
+ * `expected_version`.
+ *
+ * Permite read-modify-write optimistas: leer con led_control_get_snapshot(),
+ * calcular la nueva máscara y reintentar si otra transición se adelantó.
+ *
+ * @param version Si no es NULL, recibe la versión actual (la nueva si tuvo
+ *                éxito, la que provocó el fallo si no).
+ * @return true si se aplicó.
+ */
+bool led_control_compare_and_set(uint32_t expected_version, uint32_t new_mask, uint32_t *version);
+
+/**
+ * @brief Aplica a la vez un encendido y un apagado de canales.
+ *
+ * Primero se apagan los canales de `clear_mask` y luego se encienden los
+ * de `set_mask` (si un canal está en ambas, queda encendido). Todo el
+ * cambio se escribe en el hardware con una sola escritura de registro.
+ *
+ * @param set_mask   Canales a encender.
+ * @param clear_mask Canales a apagar.
+ * @return Máscara resultante.
+ */
+uint32_t led_control_apply_mask(uint32_t set_mask, uint32_t clear_mask);
+
+/**
+ * @brief Establece exactamente la máscara indicada (el resto se apaga).
+ * @return Máscara resultante.
+ */
+uint32_t led_control_write_mask(uint32_t mask);
+
+/**
+ * @brief Alterna a la vez todos los canales de `mask`.
+ * @return Máscara resultante.
+ */
+uint32_t led_control_toggle_mask(uint32_t mask);
+
+/**
+ * @brief Estado de un canal; false si el canal no existe.
+ */
+bool led_control_get_channel(int channel);
+
+/**
+ * @brief Enciende o apaga un canal individual.
+ * @return Versión del estado tras la transición.
+ */
+uint32_t led_control_set_channel(int channel, bool state);
+
+/**
+ * @brief Alterna un canal individual.
+ * @return Versión del estado tras la transición.
+ */
+uint32_t led_control_toggle_channel(int channel);
+
+
+/* -----------------------------
+ * Variantes seguras en ISR
+ * ----------------------------- */
+/* Devuelven la versión del estado tras la transición. */
+uint32_t led_control_apply_mask_from_isr(uint32_t set_mask, uint32_t clear_mask);
+uint32_t led_control_toggle_mask_from_isr(uint32_t mask);
+uint32_t led_control_set_channel_from_isr(int channel, bool state);
+uint32_t led_control_toggle_channel_from_isr(int channel);
 
 #endif // LED_CONTROL_H
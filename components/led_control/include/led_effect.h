@@ -0,0 +1,75 @@
+#ifndef LED_EFFECT_H
+#define LED_EFFECT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @file led_effect.h
+ * @brief Motor de efectos de LED (parpadeo, estroboscopio, latido, respiración).
+ *
+ * Los efectos de encendido/apagado se ejecutan con un único esp_timer
+ * que encadena los pasos del patrón con plazos absolutos (sin deriva);
+ * "BREATHE" programa un fundido LEDC por cada medio periodo, de modo que
+ * la rampa la hace el hardware; activa el PWM si hacía falta y al terminar
+ * devuelve el canal al modo en que estaba. Mientras un efecto corre no hay tráfico
+ * de red ni tareas dedicadas.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+/** Tipos de efecto disponibles */
+typedef enum {
+    LED_EFFECT_NONE = 0,
+    LED_EFFECT_BLINK,       /* on duty% del periodo, off el resto */
+    LED_EFFECT_STROBE,      /* destellos cortos y rápidos */
+    LED_EFFECT_HEARTBEAT,   /* doble pulso y pausa */
+    LED_EFFECT_BREATHE,     /* fundido arriba/abajo (requiere PWM, solo canal del LED) */
+} led_effect_type_t;
+
+/** Parámetros de un efecto; los campos a 0 toman el valor por defecto del tipo */
+typedef struct {
+    led_effect_type_t type;
+    uint32_t period_ms;     /* Duración de un ciclo del patrón (máx. ~71 min) */
+    uint8_t duty_pct;       /* Porcentaje del ciclo encendido (o de cada pulso) */
+    uint32_t repeat;        /* Ciclos a ejecutar; 0 = indefinido */
+    uint32_t channel_mask;  /* Canales afectados; 0 = canal del LED */
+} led_effect_params_t;
+
+/**
+ * @brief Arranca un efecto, sustituyendo al que esté en curso.
+ *
+ * Guarda el estado de los canales afectados y lo restaura al terminar
+ * (por repeticiones agotadas o por led_effect_stop()).
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG si los parámetros no son válidos
+ *         o el error de led_pwm_enable() para BREATHE.
+ */
+esp_err_t led_effect_start(const led_effect_params_t *params);
+
+/**
+ * @brief Detiene el efecto en curso (si lo hay) y restaura los canales.
+ */
+void led_effect_stop(void);
+
+/**
+ * @brief Consulta el efecto en curso.
+ * @param params  Si no es NULL, recibe los parámetros efectivos.
+ * @param cycles  Si no es NULL, recibe los ciclos completados.
+ * @return true si hay un efecto en ejecución.
+ */
+bool led_effect_get_state(led_effect_params_t *params, uint32_t *cycles);
+
+/**
+ * @brief Nombre en mayúsculas de un tipo ("BLINK", ...).
+ */
+const char *led_effect_name(led_effect_type_t type);
+
+/**
+ * @brief Tipo a partir de su nombre; LED_EFFECT_NONE si no existe.
+ */
+led_effect_type_t led_effect_from_name(const char *name);
+
+#endif // LED_EFFECT_H
@@ -0,0 +1,45 @@
+#ifndef LED_PERSIST_H
+#define LED_PERSIST_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @file led_persist.h
+ * @brief Persistencia en dos niveles del estado de los canales.
+ *
+ *  - Memoria RTC (RTC_NOINIT): se actualiza en cada transición, incluso
+ *    desde ISR, y sobrevive a reinicios en caliente (software, pánico,
+ *    watchdog, deep sleep).
+ *  - NVS: las escrituras se agrupan; la primera transición arranca una
+ *    ventana de LED_PERSIST_NVS_INTERVAL_MS y al cerrarse se guarda el
+ *    último estado (como mucho una escritura por ventana, y ninguna si
+ *    no cambió respecto a lo guardado). Los pasos de efectos y timelines
+ *    no abren la ventana; un efecto la abre una vez al terminar, con el
+ *    estado restaurado. Los trabajos de la planificación sí la abren.
+ *
+ * led_control_init() restaura primero desde RTC y, si no es válida, desde
+ * NVS. Requiere nvs_flash_init() previo.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#ifndef LED_PERSIST_RESTORE
+#define LED_PERSIST_RESTORE          1     /* 0: arrancar siempre apagado */
+#endif
+
+#ifndef LED_PERSIST_NVS_INTERVAL_MS
+#define LED_PERSIST_NVS_INTERVAL_MS  5000  /* Ventana de agrupación de escrituras NVS */
+#endif
+
+#define LED_PERSIST_NVS_NAMESPACE    "led_ctrl"
+#define LED_PERSIST_NVS_KEY          "mask"
+
+/**
+ * @brief Escribe ya en NVS el estado actual si difiere del guardado
+ * (p.ej. antes de un esp_restart() planificado).
+ */
+esp_err_t led_persist_flush(void);
+
+#endif // LED_PERSIST_H
@@ -0,0 +1,76 @@
+#ifndef LED_PWM_H
+#define LED_PWM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @file led_pwm.h
+ * @brief Modo PWM (LEDC) para el LED principal: brillo con corrección
+ * gamma y fundidos temporizados por hardware.
+ *
+ * Con el modo activo el pin del canal LED_CONTROL_LED_CHANNEL pasa al
+ * periférico LEDC. El brillo se expresa en 0..255 (perceptual) y se
+ * traduce a duty con una tabla gamma calculada al activar el modo.
+ * Encender/apagar el LED por la API de led_control sigue funcionando:
+ * "encendido" restaura el último brillo distinto de cero.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+/* -----------------------------
+ * Configuración LEDC
+ * ----------------------------- */
+#define LED_PWM_DUTY_RESOLUTION  13      /* Bits de duty (8..13) */
+#define LED_PWM_FREQUENCY_HZ     5000    /* Frecuencia PWM */
+#define LED_PWM_GAMMA            2.2f    /* Exponente de la curva de brillo */
+
+#if LED_PWM_DUTY_RESOLUTION < 8 || LED_PWM_DUTY_RESOLUTION > 13
+#error "LED_PWM_DUTY_RESOLUTION debe estar entre 8 y 13 bits"
+#endif
+
+/**
+ * @brief Activa el modo PWM en el LED principal.
+ *
+ * Configura timer y canal LEDC, instala el servicio de fundidos y
+ * aplica el brillo correspondiente al estado actual del LED.
+ */
+esp_err_t led_pwm_enable(void);
+
+/**
+ * @brief Vuelve al modo digital (GPIO) conservando el estado on/off.
+ */
+esp_err_t led_pwm_disable(void);
+
+/**
+ * @brief true si el modo PWM está activo.
+ */
+bool led_pwm_is_enabled(void);
+
+/**
+ * @brief Fija el brillo de inmediato (0 = apagado).
+ * @param level Brillo perceptual 0..255.
+ */
+esp_err_t led_pwm_set_brightness(uint8_t level);
+
+/**
+ * @brief Inicia un fundido por hardware hasta `level` en `duration_ms`.
+ *
+ * No bloquea: el LEDC avanza el duty por sí mismo y la CPU no interviene
+ * en cada paso. Un fundido nuevo sustituye al que esté en curso.
+ */
+esp_err_t led_pwm_fade_to(uint8_t level, uint32_t duration_ms);
+
+/**
+ * @brief Brillo objetivo actual (el del último set/fade).
+ */
+uint8_t led_pwm_get_brightness(void);
+
+/**
+ * @brief Duty LEDC correspondiente a un brillo (tabla gamma).
+ */
+uint32_t led_pwm_level_to_duty(uint8_t level);
+
+#endif // LED_PWM_H
@@ -0,0 +1,88 @@
+#ifndef LED_SCENE_H
+#define LED_SCENE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @file led_scene.h
+ * @brief Escenas y grupos de canales con nombre, guardados en NVS.
+ *
+ *  - Grupo: nombre -> máscara de canales ("salon" = canales 1 y 2).
+ *  - Escena: nombre -> (encender, apagar); aplicar una escena es una sola
+ *    transición de led_control, es decir, una escritura de registro.
+ *
+ * Las tablas se cargan de NVS a RAM en led_control_init(); aplicar no
+ * toca la flash, solo definir o borrar.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#define LED_SCENE_MAX        16   /* Escenas guardadas */
+#define LED_GROUP_MAX        16   /* Grupos guardados */
+#define LED_SCENE_NAME_MAX   16   /* Incluye el terminador */
+
+#define LED_SCENE_NVS_NAMESPACE  "led_scene"
+
+/** Escena: canales a encender y a apagar */
+typedef struct {
+    char name[LED_SCENE_NAME_MAX];
+    uint16_t set_mask;
+    uint16_t clear_mask;
+} led_scene_t;
+
+/** Grupo de canales */
+typedef struct {
+    char name[LED_SCENE_NAME_MAX];
+    uint16_t mask;
+} led_group_t;
+
+/**
+ * @brief Crea o sustituye una escena y la guarda en NVS.
+ * @return ESP_OK, ESP_ERR_INVALID_ARG (nombre inválido) o ESP_ERR_NO_MEM
+ *         (tabla llena).
+ */
+esp_err_t led_scene_define(const char *name, uint16_t set_mask, uint16_t clear_mask);
+
+/**
+ * @brief Borra una escena. ESP_ERR_NOT_FOUND si no existe.
+ */
+esp_err_t led_scene_delete(const char *name);
+
+/**
+ * @brief Aplica una escena en una única transición.
+ * @param version Si no es NULL, recibe la versión del estado resultante.
+ */
+esp_err_t led_scene_apply(const char *name, uint32_t *version);
+
+/**
+ * @brief Copia la escena `index` (0..led_scene_count()-1).
+ */
+bool led_scene_get(size_t index, led_scene_t *scene);
+size_t led_scene_count(void);
+
+/**
+ * @brief Crea o sustituye un grupo y lo guarda en NVS.
+ */
+esp_err_t led_group_define(const char *name, uint16_t mask);
+
+/**
+ * @brief Borra un grupo. ESP_ERR_NOT_FOUND si no existe.
+ */
+esp_err_t led_group_delete(const char *name);
+
+/**
+ * @brief Máscara de un grupo por nombre.
+ */
+esp_err_t led_group_find(const char *name, uint16_t *mask);
+
+/**
+ * @brief Copia el grupo `index` (0..led_group_count()-1).
+ */
+bool led_group_get(size_t index, led_group_t *group);
+size_t led_group_count(void);
+
+#endif // LED_SCENE_H
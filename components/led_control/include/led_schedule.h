@@ -0,0 +1,75 @@
+#ifndef LED_SCHEDULE_H
+#define LED_SCHEDULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @file led_schedule.h
+ * @brief Planificador de acciones diferidas sobre los canales (timer wheel).
+ *
+ * Rueda jerárquica de 4 niveles (256 + 3 x 64 ranuras) con tick de
+ * LED_SCHED_TICK_MS: alcance de ~7,7 días, inserción y cancelación O(1)
+ * y un único esp_timer periódico (parado mientras no hay trabajos).
+ * Los trabajos viven en un pool estático; no hay reservas de memoria ni
+ * tareas por temporizador. El orden entre trabajos que vencen en el mismo
+ * tick no está definido.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#define LED_SCHED_TICK_MS    10     /* Resolución del planificador */
+#define LED_SCHED_MAX_JOBS   2048   /* Trabajos pendientes simultáneos */
+
+/** Acción a ejecutar al vencer un trabajo */
+typedef enum {
+    LED_SCHED_APPLY = 0,    /* led_control_apply_mask(set, clear) */
+    LED_SCHED_TOGGLE,       /* led_control_toggle_mask(set) */
+} led_sched_action_t;
+
+/** Identificador de trabajo (0 = inválido) */
+typedef uint32_t led_sched_id_t;
+#define LED_SCHED_INVALID_ID 0
+
+/** Descripción de un trabajo pendiente (para listados) */
+typedef struct {
+    led_sched_id_t id;
+    uint32_t due_in_ms;
+    led_sched_action_t action;
+    uint16_t set_mask;
+    uint16_t clear_mask;
+} led_sched_job_info_t;
+
+/**
+ * @brief Programa una acción dentro de `delay_ms` milisegundos.
+ * @param id Si no es NULL, recibe el identificador para cancelarla.
+ * @return ESP_OK o ESP_ERR_NO_MEM si el pool está lleno.
+ */
+esp_err_t led_sched_add(uint32_t delay_ms, led_sched_action_t action,
+                        uint16_t set_mask, uint16_t clear_mask, led_sched_id_t *id);
+
+/**
+ * @brief Cancela un trabajo pendiente.
+ * @return ESP_OK o ESP_ERR_NOT_FOUND si ya venció o no existe.
+ */
+esp_err_t led_sched_cancel(led_sched_id_t id);
+
+/**
+ * @brief Cancela todos los trabajos pendientes.
+ */
+void led_sched_cancel_all(void);
+
+/**
+ * @brief Número de trabajos pendientes.
+ */
+size_t led_sched_count(void);
+
+/**
+ * @brief Copia hasta `max` trabajos pendientes (orden del pool, no temporal).
+ * @return Número de entradas escritas.
+ */
+size_t led_sched_list(led_sched_job_info_t *out, size_t max);
+
+#endif // LED_SCHEDULE_H
@@ -0,0 +1,102 @@
+#ifndef LED_TIMELINE_H
+#define LED_TIMELINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @file led_timeline.h
+ * @brief Reproducción de secuencias grabadas (timelines) sobre los canales.
+ *
+ * Formato binario (little-endian), subido como frame WebSocket binario:
+ *
+ *   offset 0  char[4]  magic "LTL1"
+ *   offset 4  uint16   número de eventos (<= LED_TIMELINE_MAX_EVENTS)
+ *   offset 6  uint8    flags (LED_TIMELINE_FLAG_LOOP)
+ *   offset 7  uint8    reservado (0)
+ *   offset 8  eventos: { uint32 delta_us; uint16 set_mask; uint16 clear_mask; }
+ *
+ * `delta_us` es el tiempo desde el evento anterior (el primero, desde el
+ * arranque); un delta 0 se aplica en la misma interrupción que el anterior.
+ * La reproducción la hace la ISR de alarma de un gptimer a 1 MHz, que
+ * escribe las máscaras con una sola escritura de registro y programa la
+ * siguiente alarma. Si el canal del LED está en modo PWM, el LEDC sigue a
+ * los eventos con la latencia de la tarea del timer de FreeRTOS; los pasos
+ * no abren la ventana de guardado en NVS. Al terminar una secuencia sin
+ * bucle el gptimer se detiene desde esa tarea. Hay dos buffers: la carga escribe en el inactivo y el
+ * cambio se hace al instante si no se está reproduciendo, o al final de la
+ * vuelta en curso si se está reproduciendo en bucle.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#define LED_TIMELINE_MAGIC        "LTL1"
+#define LED_TIMELINE_HEADER_SIZE  8
+#define LED_TIMELINE_MAX_EVENTS   1024
+#define LED_TIMELINE_FLAG_LOOP    0x01
+
+/** Evento de la secuencia (8 bytes, tal cual viaja en el formato binario) */
+typedef struct __attribute__((packed)) {
+    uint32_t delta_us;
+    uint16_t set_mask;
+    uint16_t clear_mask;
+} led_timeline_event_t;
+
+/** Estadísticas de reproducción y jitter (retardo alarma -> ISR) */
+typedef struct {
+    uint32_t events_played;
+    uint32_t loops;
+    uint32_t late_events;     /* eventos cuya alarma ya había pasado al programarla */
+    uint32_t jitter_min_us;
+    uint32_t jitter_max_us;
+    uint32_t jitter_avg_us;
+} led_timeline_stats_t;
+
+/**
+ * @brief Valida y carga una secuencia en el buffer inactivo.
+ * @return ESP_OK, ESP_ERR_INVALID_ARG (formato) o ESP_ERR_INVALID_SIZE.
+ */
+esp_err_t led_timeline_load(const uint8_t *data, size_t len);
+
+/**
+ * @brief Inicia la reproducción del buffer activo.
+ * @param sync_ms Si es > 0, el primer evento se alinea con el siguiente
+ *                múltiplo de `sync_ms` del reloj esp_timer (arranque
+ *                sincronizado de varias secuencias o dispositivos).
+ */
+esp_err_t led_timeline_start(uint32_t sync_ms);
+
+/**
+ * @brief Detiene la reproducción (las salidas quedan como estén).
+ */
+void led_timeline_stop(void);
+
+/**
+ * @brief true mientras la secuencia se está reproduciendo.
+ */
+bool led_timeline_is_playing(void);
+
+/**
+ * @brief Número de eventos del buffer activo.
+ */
+size_t led_timeline_get_event_count(void);
+
+/**
+ * @brief Copia las estadísticas de la última reproducción.
+ */
+void led_timeline_get_stats(led_timeline_stats_t *stats);
+
+/**
+ * @brief Guarda el buffer activo en un fichero (p.ej. en SPIFFS).
+ */
+esp_err_t led_timeline_save(const char *path);
+
+/**
+ * @brief Carga una secuencia desde fichero (mismo formato binario).
+ */
+esp_err_t led_timeline_load_file(const char *path);
+
+#endif // LED_TIMELINE_H
@@ -1,42 +1,276 @@
 /**
  * @file led_control.c
- * @brief Control sencillo de un LED conectado a GPIO2.
+ * @brief Control de las salidas digitales: LED en GPIO2 y canales adicionales.
  *
- * Proporciona inicialización, lectura, escritura y toggle del estado del LED.
- * Mantiene un estado en memoria para evitar leer el pin cada vez.
+ * Proporciona inicialización, lectura, escritura y toggle del estado del LED
+ * y de los canales definidos en LED_CONTROL_CHANNEL_PINS. Mantiene el estado
+ * en memoria como una máscara de canales para evitar leer los pines.
+ *
+ * Las actualizaciones traducen la máscara de canales a máscara de pines con
+ * dos tablas de 256 entradas (coste constante) y escriben GPIO_OUT_REG una
+ * sola vez dentro de una sección crítica: todos los canales afectados
+ * conmutan en el mismo ciclo de bus. El ESP32-C3 es mono-núcleo, así que la
+ * sección crítica basta para que el read-modify-write del registro no pise
+ * las escrituras de gpio_set_level() de otros pines.
  *
  * Autor: migbertweb
  * Fecha: 2025-11-09
  */
 
 #include "led_control.h"
+#include "led_pwm.h"
+#include "led_persist.h"
+#include "led_internal.h"
 #include "driver/gpio.h"
+#include "soc/gpio_reg.h"
+#include "soc/soc.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/timers.h"
 
 /* Tag para logs */
 static const char *TAG = "LED_CONTROL";
 
-/* Estado interno del LED: true = encendido, false = apagado. */
-static bool led_state = false;
+/* Tabla de pines de los canales */
+static const gpio_num_t s_channel_pins[] = LED_CONTROL_CHANNEL_PINS;
+#define CHANNEL_COUNT ((int)(sizeof(s_channel_pins) / sizeof(s_channel_pins[0])))
+
+_Static_assert(CHANNEL_COUNT <= LED_CONTROL_MAX_CHANNELS, "Demasiados canales en LED_CONTROL_CHANNEL_PINS");
+
+/* Máscara con todos los canales configurados */
+#define ALL_CHANNELS_MASK ((uint32_t)((1UL << CHANNEL_COUNT) - 1))
+
+/* Traducción canal->pin: byte bajo y byte alto de la máscara de canales */
+static DRAM_ATTR uint32_t s_pins_lo[256];
+static DRAM_ATTR uint32_t s_pins_hi[256];
+
+/* Máscara de pines de todos los canales (bits de GPIO_OUT_REG que nos pertenecen) */
+static DRAM_ATTR uint32_t s_owned_pins = 0;
+
+/* Estado interno: bit i = canal i encendido. */
+static DRAM_ATTR uint32_t s_channel_mask = 0;
+
+/* Versión del estado: +1 en cada transición que cambia la máscara */
+static DRAM_ATTR uint32_t s_version = 0;
+
+/* Protege s_channel_mask, s_version y la escritura de GPIO_OUT_REG */
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Canales cambiados desde ISR pendientes de sincronizar en tarea (PWM/NVS) */
+static DRAM_ATTR uint32_t s_isr_changed = 0;
+static DRAM_ATTR bool s_isr_sync_pending = false;
+static DRAM_ATTR bool s_isr_persist = false;   /* Alguno abre la ventana de NVS */
+
+
+/* Funciones privadas ------------------------------------------------------ */
+
+/* Máscara de pines correspondiente a una máscara de canales */
+static inline IRAM_ATTR uint32_t channels_to_pins(uint32_t mask)
+{
+    return s_pins_lo[mask & 0xFF] | s_pins_hi[(mask >> 8) & 0xFF];
+}
+
+/* Escribe `mask` en hardware y en el estado (con s_lock tomado) */
+static inline IRAM_ATTR uint32_t commit_locked(uint32_t before, uint32_t mask)
+{
+    uint32_t out = REG_READ(GPIO_OUT_REG);
+    REG_WRITE(GPIO_OUT_REG, (out & ~s_owned_pins) | channels_to_pins(mask));
+    s_channel_mask = mask;
+    if (mask != before) {
+        s_version++;
+    }
+    led_persist_mirror(mask);
+    return s_version;
+}
+
+/**
+ * @brief Núcleo de todas las transiciones: nuevo = ((actual & ~clr) | set) ^ tgl.
+ *
+ * Una única escritura de GPIO_OUT_REG aplica el cambio completo. Lectura,
+ * cálculo y escritura ocurren en la misma sección crítica, así que dos
+ * transiciones concurrentes (tareas o ISR) nunca se pisan.
+ * Puede llamarse desde tarea o ISR (usa la variante _SAFE de la sección crítica).
+ *
+ * @return Máscara resultante.
+ */
+IRAM_ATTR uint32_t led_control_update_raw(uint32_t set, uint32_t clr, uint32_t tgl,
+                                          uint32_t *previous, uint32_t *version)
+{
+    portENTER_CRITICAL_SAFE(&s_lock);
+    uint32_t before = s_channel_mask;
+    uint32_t mask = (((before & ~clr) | set) ^ tgl) & ALL_CHANNELS_MASK;
+    uint32_t ver = commit_locked(before, mask);
+    portEXIT_CRITICAL_SAFE(&s_lock);
+
+    if (previous) {
+        *previous = before;
+    }
+    if (version) {
+        *version = ver;
+    }
+    return mask;
+}
+
+/**
+ * @brief Parte "de tarea" de una transición: si el canal del LED cambió con
+ * el modo PWM activo actualiza el duty del LEDC y, si `persist`, abre la
+ * ventana de guardado en NVS.
+ */
+static void after_transition(uint32_t before, uint32_t mask, bool persist)
+{
+    uint32_t led_bit = 1UL << LED_CONTROL_LED_CHANNEL;
+    if (((before ^ mask) & led_bit) && led_pwm_is_enabled()) {
+        led_pwm_follow_state((mask & led_bit) != 0);
+    }
+    if (persist && before != mask) {
+        led_persist_note_change();
+    }
+}
+
+/**
+ * @brief Transición desde tarea (ver after_transition).
+ * @return Máscara resultante.
+ */
+uint32_t led_control_update(uint32_t set, uint32_t clr, uint32_t tgl)
+{
+    uint32_t before;
+    uint32_t mask = led_control_update_raw(set, clr, tgl, &before, NULL);
+    after_transition(before, mask, true);
+    return mask;
+}
+
+/* Igual que led_control_update() pero sin abrir la ventana de NVS */
+uint32_t led_control_update_transient(uint32_t set, uint32_t clr, uint32_t tgl)
+{
+    uint32_t before;
+    uint32_t mask = led_control_update_raw(set, clr, tgl, &before, NULL);
+    after_transition(before, mask, false);
+    return mask;
+}
+
+/* Igual que led_control_update() pero devuelve la versión resultante */
+uint32_t led_control_update_versioned(uint32_t set, uint32_t clr, uint32_t tgl, uint32_t *mask)
+{
+    uint32_t before, version;
+    uint32_t after = led_control_update_raw(set, clr, tgl, &before, &version);
+    after_transition(before, after, true);
+    if (mask) {
+        *mask = after;
+    }
+    return version;
+}
+
+/* Sincroniza en la tarea del timer de FreeRTOS los cambios hechos desde ISR */
+static void isr_sync_deferred(void *arg1, uint32_t arg2)
+{
+    portENTER_CRITICAL(&s_lock);
+    uint32_t changed = s_isr_changed;
+    bool persist = s_isr_persist;
+    s_isr_changed = 0;
+    s_isr_persist = false;
+    s_isr_sync_pending = false;
+    uint32_t mask = s_channel_mask;
+    portEXIT_CRITICAL(&s_lock);
+
+    after_transition(mask ^ changed, mask, persist);
+}
+
+/* Difiere la parte de tarea de los canales `changed` cambiados en ISR */
+IRAM_ATTR void led_control_sync_from_isr(uint32_t changed, bool persist)
+{
+    if (changed == 0) {
+        return;
+    }
+
+    /* Un solo aviso pendiente a la vez: las ISR siguientes solo acumulan */
+    portENTER_CRITICAL_ISR(&s_lock);
+    s_isr_changed ^= changed;
+    s_isr_persist |= persist;
+    bool post = !s_isr_sync_pending;
+    s_isr_sync_pending = true;
+    portEXIT_CRITICAL_ISR(&s_lock);
+
+    if (post) {
+        BaseType_t woken = pdFALSE;
+        if (xTimerPendFunctionCallFromISR(isr_sync_deferred, NULL, 0, &woken) != pdPASS) {
+            s_isr_sync_pending = false;
+        }
+        if (woken) {
+            portYIELD_FROM_ISR();
+        }
+    }
+}
+
+/* Transición desde ISR: aplica el cambio y difiere la parte de tarea */
+static IRAM_ATTR uint32_t update_from_isr(uint32_t set, uint32_t clr, uint32_t tgl)
+{
+    uint32_t before, version;
+    uint32_t mask = led_control_update_raw(set, clr, tgl, &before, &version);
+    led_control_sync_from_isr(before ^ mask, true);
+    return version;
+}
+
+/* Precalcula las tablas de traducción canal->pin */
+static void build_pin_tables(void)
+{
+    for (int v = 0; v < 256; v++) {
+        uint32_t lo = 0, hi = 0;
+        for (int bit = 0; bit < 8; bit++) {
+            if (!(v & (1 << bit))) {
+                continue;
+            }
+            if (bit < CHANNEL_COUNT) {
+                lo |= 1UL << s_channel_pins[bit];
+            }
+            if (bit + 8 < CHANNEL_COUNT) {
+                hi |= 1UL << s_channel_pins[bit + 8];
+            }
+        }
+        s_pins_lo[v] = lo;
+        s_pins_hi[v] = hi;
+    }
+    s_owned_pins = channels_to_pins(ALL_CHANNELS_MASK);
+}
+
+
+/* API pública ------------------------------------------------------------- */
 
 /**
- * @brief Inicializa el GPIO2 para controlar el LED.
+ * @brief Inicializa los GPIO de la tabla de canales.
  *
- * Configura el pin como salida y deja el LED apagado.
+ * Restaura el último estado guardado (RTC o NVS, ver led_persist.h) y
+ * configura los pines como salida.
  */
 void led_control_init(void)
 {
-    ESP_LOGI(TAG, "Inicializando LED en GPIO2");
+    ESP_LOGI(TAG, "Inicializando %d canales (LED en GPIO%d)",
+             CHANNEL_COUNT, s_channel_pins[LED_CONTROL_LED_CHANNEL]);
+
+    build_pin_tables();
+
+    /* Cargar el estado en GPIO_OUT_REG antes de habilitar las salidas,
+     * para que los pines arranquen ya en su nivel final (sin pulso) */
+    uint32_t restored = led_persist_restore();
+    led_control_update_raw(restored, ALL_CHANNELS_MASK, 0, NULL, NULL);
 
-    /* Configurar el GPIO2 como salida */
-    gpio_reset_pin(GPIO_NUM_2);
-    gpio_set_direction(GPIO_NUM_2, GPIO_MODE_OUTPUT);
+    /* Configurar todos los pines de la tabla como salida */
+    gpio_config_t io_conf = {
+        .pin_bit_mask = s_owned_pins,
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    gpio_config(&io_conf);
 
-    /* Apagar el LED inicialmente */
-    gpio_set_level(GPIO_NUM_2, 0);
-    led_state = false;
+    led_effect_init();
+    led_timeline_init();
+    led_sched_init();
+    led_scene_init();
 
-    ESP_LOGI(TAG, "LED control inicializado en GPIO2 - Estado: APAGADO");
+    ESP_LOGI(TAG, "LED control inicializado - Máscara: 0x%04lX",
+             (unsigned long)s_channel_mask);
 }
 
 /**
@@ -45,30 +279,163 @@ void led_control_init(void)
  */
 bool led_control_get_state(void)
 {
-    return led_state;
+    return led_control_get_channel(LED_CONTROL_LED_CHANNEL);
 }
 
 /**
  * @brief Establece el estado del LED y actualiza el GPIO.
  * @param state true para encender, false para apagar.
+ * @return Versión del estado tras la transición.
  */
-void led_control_set_state(bool state)
+uint32_t led_control_set_state(bool state)
 {
-    led_state = state;
-    gpio_set_level(GPIO_NUM_2, state ? 1 : 0);
-    ESP_LOGI(TAG, "LED %s - GPIO2 nivel: %d",
+    uint32_t version = led_control_set_channel(LED_CONTROL_LED_CHANNEL, state);
+    ESP_LOGI(TAG, "LED %s - GPIO%d nivel: %d",
              state ? "ENCENDIDO" : "APAGADO",
+             s_channel_pins[LED_CONTROL_LED_CHANNEL],
              state ? 1 : 0);
+    return version;
 }
 
 /**
  * @brief Alterna el estado del LED (toggle) y actualiza el GPIO.
+ * @return Versión del estado tras la transición.
  */
-void led_control_toggle(void)
-{
-    led_state = !led_state;
-    gpio_set_level(GPIO_NUM_2, led_state ? 1 : 0);
-    ESP_LOGI(TAG, "LED %s (toggle) - GPIO2 nivel: %d",
-             led_state ? "ENCENDIDO" : "APAGADO",
-             led_state ? 1 : 0);
-}
\ No newline at end of file
+uint32_t led_control_toggle(void)
+{
+    uint32_t mask;
+    uint32_t version = led_control_update_versioned(0, 0, 1UL << LED_CONTROL_LED_CHANNEL, &mask);
+    bool state = (mask >> LED_CONTROL_LED_CHANNEL) & 1;
+    ESP_LOGI(TAG, "LED %s (toggle) - GPIO%d nivel: %d",
+             state ? "ENCENDIDO" : "APAGADO",
+             s_channel_pins[LED_CONTROL_LED_CHANNEL],
+             state ? 1 : 0);
+    return version;
+}
+
+int led_control_get_channel_count(void)
+{
+    return CHANNEL_COUNT;
+}
+
+int led_control_get_channel_pin(int channel)
+{
+    if (channel < 0 || channel >= CHANNEL_COUNT) {
+        return -1;
+    }
+    return s_channel_pins[channel];
+}
+
+uint32_t led_control_get_all_mask(void)
+{
+    return ALL_CHANNELS_MASK;
+}
+
+uint32_t led_control_get_mask(void)
+{
+    return s_channel_mask;
+}
+
+uint32_t led_control_get_version(void)
+{
+    return s_version;
+}
+
+void led_control_get_snapshot(uint32_t *mask, uint32_t *version)
+{
+    portENTER_CRITICAL(&s_lock);
+    *mask = s_channel_mask;
+    *version = s_version;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+bool led_control_compare_and_set(uint32_t expected_version, uint32_t new_mask, uint32_t *version)
+{
+    new_mask &= ALL_CHANNELS_MASK;
+
+    portENTER_CRITICAL(&s_lock);
+    uint32_t before = s_channel_mask;
+    bool ok = (s_version == expected_version);
+    uint32_t ver = ok ? commit_locked(before, new_mask) : s_version;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (ok) {
+        after_transition(before, new_mask, true);
+    }
+    if (version) {
+        *version = ver;
+    }
+    return ok;
+}
+
+uint32_t led_control_apply_mask(uint32_t set_mask, uint32_t clear_mask)
+{
+    return led_control_update(set_mask, clear_mask, 0);
+}
+
+uint32_t led_control_write_mask(uint32_t mask)
+{
+    return led_control_update(mask, ALL_CHANNELS_MASK, 0);
+}
+
+uint32_t led_control_toggle_mask(uint32_t mask)
+{
+    return led_control_update(0, 0, mask);
+}
+
+bool led_control_get_channel(int channel)
+{
+    if (channel < 0 || channel >= CHANNEL_COUNT) {
+        return false;
+    }
+    return (s_channel_mask >> channel) & 1;
+}
+
+uint32_t led_control_set_channel(int channel, bool state)
+{
+    if (channel < 0 || channel >= CHANNEL_COUNT) {
+        ESP_LOGW(TAG, "Canal inexistente: %d", channel);
+        return s_version;
+    }
+    uint32_t bit = 1UL << channel;
+    return led_control_update_versioned(state ? bit : 0, state ? 0 : bit, 0, NULL);
+}
+
+uint32_t led_control_toggle_channel(int channel)
+{
+    if (channel < 0 || channel >= CHANNEL_COUNT) {
+        ESP_LOGW(TAG, "Canal inexistente: %d", channel);
+        return s_version;
+    }
+    return led_control_update_versioned(0, 0, 1UL << channel, NULL);
+}
+
+
+/* Variantes para ISR ------------------------------------------------------ */
+
+IRAM_ATTR uint32_t led_control_apply_mask_from_isr(uint32_t set_mask, uint32_t clear_mask)
+{
+    return update_from_isr(set_mask, clear_mask, 0);
+}
+
+IRAM_ATTR uint32_t led_control_toggle_mask_from_isr(uint32_t mask)
+{
+    return update_from_isr(0, 0, mask);
+}
+
+IRAM_ATTR uint32_t led_control_set_channel_from_isr(int channel, bool state)
+{
+    if (channel < 0 || channel >= CHANNEL_COUNT) {
+        return s_version;
+    }
+    uint32_t bit = 1UL << channel;
+    return update_from_isr(state ? bit : 0, state ? 0 : bit, 0);
+}
+
+IRAM_ATTR uint32_t led_control_toggle_channel_from_isr(int channel)
+{
+    if (channel < 0 || channel >= CHANNEL_COUNT) {
+        return s_version;
+    }
+    return update_from_isr(0, 0, 1UL << channel);
+}
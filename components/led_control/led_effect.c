@@ -0,0 +1,265 @@
+/**
+ * @file led_effect.c
+ * @brief Motor de efectos de LED guiado por esp_timer y fundidos LEDC.
+ *
+ * Cada efecto se describe como una lista corta de pasos (encendido/apagado
+ * y duración). Un esp_timer one-shot aplica el paso actual y se reprograma
+ * para el siguiente con plazos absolutos, así que la latencia del callback
+ * no se acumula. Un mutex serializa el callback con start/stop.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#include "led_effect.h"
+#include "led_control.h"
+#include "led_pwm.h"
+#include "led_internal.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "LED_EFFECT";
+
+#define EFFECT_MAX_STEPS      4
+#define EFFECT_MIN_PERIOD_MS  20
+#define EFFECT_MAX_PERIOD_MS  (UINT32_MAX / 1000)   /* Los pasos se miden en us de 32 bits */
+
+/* Paso de un patrón */
+typedef struct {
+    bool on;
+    uint32_t duration_us;
+} effect_step_t;
+
+/* Valores por defecto de cada tipo (índice = led_effect_type_t) */
+static const struct {
+    const char *name;
+    uint32_t period_ms;
+    uint8_t duty_pct;
+} s_defaults[] = {
+    [LED_EFFECT_NONE]      = { "NONE",      0,    0  },
+    [LED_EFFECT_BLINK]     = { "BLINK",     1000, 50 },
+    [LED_EFFECT_STROBE]    = { "STROBE",    200,  10 },
+    [LED_EFFECT_HEARTBEAT] = { "HEARTBEAT", 1200, 10 },
+    [LED_EFFECT_BREATHE]   = { "BREATHE",   3000, 50 },
+};
+#define EFFECT_TYPE_COUNT ((int)(sizeof(s_defaults) / sizeof(s_defaults[0])))
+
+static SemaphoreHandle_t s_mutex = NULL;
+static esp_timer_handle_t s_timer = NULL;
+
+/* Estado del efecto en curso (protegido por s_mutex) */
+static bool s_running = false;
+static led_effect_params_t s_params;
+static effect_step_t s_steps[EFFECT_MAX_STEPS];
+static int s_step_count = 0;
+static int s_step = 0;
+static uint32_t s_cycles = 0;
+static int64_t s_deadline = 0;
+
+/* Estado previo de los canales, para restaurarlo al terminar */
+static uint32_t s_saved_mask = 0;
+static uint8_t s_saved_level = 0;
+static bool s_saved_pwm = false;     /* BREATHE: PWM ya activo antes del efecto */
+
+
+/* Funciones privadas ------------------------------------------------------ */
+
+/* Construye la lista de pasos de un patrón ya validado */
+static void build_steps(const led_effect_params_t *p)
+{
+    uint32_t period_us = p->period_ms * 1000;
+    uint32_t pulse_us = period_us / 100 * p->duty_pct;
+
+    switch (p->type) {
+    case LED_EFFECT_HEARTBEAT:
+        s_steps[0] = (effect_step_t) { true,  pulse_us };
+        s_steps[1] = (effect_step_t) { false, pulse_us };
+        s_steps[2] = (effect_step_t) { true,  pulse_us };
+        s_steps[3] = (effect_step_t) { false, period_us - 3 * pulse_us };
+        s_step_count = 4;
+        break;
+    case LED_EFFECT_BREATHE:
+        s_steps[0] = (effect_step_t) { true,  period_us / 2 };
+        s_steps[1] = (effect_step_t) { false, period_us - period_us / 2 };
+        s_step_count = 2;
+        break;
+    default:
+        s_steps[0] = (effect_step_t) { true,  pulse_us };
+        s_steps[1] = (effect_step_t) { false, period_us - pulse_us };
+        s_step_count = 2;
+        break;
+    }
+}
+
+/* Aplica el paso actual y programa el temporizador para el siguiente */
+static void apply_step(void)
+{
+    const effect_step_t *step = &s_steps[s_step];
+    uint32_t mask = s_params.channel_mask;
+
+    if (s_params.type == LED_EFFECT_BREATHE) {
+        led_pwm_fade_to(step->on ? 255 : 0, step->duration_us / 1000);
+    } else {
+        /* Pasos transitorios: solo la restauración final se guarda en NVS */
+        led_control_update_transient(step->on ? mask : 0, step->on ? 0 : mask, 0);
+    }
+
+    s_deadline += step->duration_us;
+    int64_t delay = s_deadline - esp_timer_get_time();
+    esp_timer_start_once(s_timer, delay > 0 ? delay : 0);
+}
+
+/* Termina el efecto y restaura los canales (con s_mutex tomado) */
+static void finish_locked(void)
+{
+    esp_timer_stop(s_timer);
+    s_running = false;
+
+    if (s_params.type == LED_EFFECT_BREATHE) {
+        led_pwm_set_brightness(s_saved_level);
+        /* Si el canal estaba en modo digital, vuelve a él */
+        if (!s_saved_pwm) {
+            led_pwm_disable();
+        }
+    } else {
+        uint32_t mask = s_params.channel_mask;
+        led_control_apply_mask(s_saved_mask & mask, ~s_saved_mask & mask);
+        /* Por si una ventana abierta antes guardó un paso intermedio */
+        led_persist_note_change();
+    }
+    ESP_LOGI(TAG, "Efecto %s terminado tras %lu ciclos",
+             s_defaults[s_params.type].name, (unsigned long)s_cycles);
+}
+
+static void effect_timer_cb(void *arg)
+{
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (s_running) {
+        if (++s_step >= s_step_count) {
+            s_step = 0;
+            s_cycles++;
+        }
+        if (s_step == 0 && s_params.repeat && s_cycles >= s_params.repeat) {
+            finish_locked();
+        } else {
+            apply_step();
+        }
+    }
+    xSemaphoreGive(s_mutex);
+}
+
+
+/* API pública ------------------------------------------------------------- */
+
+void led_effect_init(void)
+{
+    s_mutex = xSemaphoreCreateMutex();
+
+    const esp_timer_create_args_t args = {
+        .callback = effect_timer_cb,
+        .name = "led_effect",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &s_timer));
+}
+
+esp_err_t led_effect_start(const led_effect_params_t *params)
+{
+    if (params == NULL || params->type <= LED_EFFECT_NONE || params->type >= EFFECT_TYPE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    led_effect_params_t p = *params;
+    if (p.period_ms == 0) {
+        p.period_ms = s_defaults[p.type].period_ms;
+    }
+    if (p.duty_pct == 0) {
+        p.duty_pct = s_defaults[p.type].duty_pct;
+    }
+    if (p.type == LED_EFFECT_BREATHE || p.channel_mask == 0) {
+        p.channel_mask = 1UL << LED_CONTROL_LED_CHANNEL;
+    }
+    p.channel_mask &= led_control_get_all_mask();
+
+    int max_duty = (p.type == LED_EFFECT_HEARTBEAT) ? 33 : 99;
+    if (p.period_ms < EFFECT_MIN_PERIOD_MS || p.period_ms > EFFECT_MAX_PERIOD_MS ||
+        p.duty_pct > max_duty || p.channel_mask == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (s_running) {
+        finish_locked();
+    }
+
+    /* Con el anterior ya terminado: el modo que hay que restaurar es este */
+    s_saved_pwm = led_pwm_is_enabled();
+    if (p.type == LED_EFFECT_BREATHE) {
+        esp_err_t ret = led_pwm_enable();
+        if (ret != ESP_OK) {
+            xSemaphoreGive(s_mutex);
+            return ret;
+        }
+    }
+
+    s_params = p;
+    s_saved_mask = led_control_get_mask();
+    s_saved_level = led_pwm_get_brightness();
+    build_steps(&p);
+    s_step = 0;
+    s_cycles = 0;
+    s_deadline = esp_timer_get_time();
+    s_running = true;
+    apply_step();
+    xSemaphoreGive(s_mutex);
+
+    ESP_LOGI(TAG, "Efecto %s: periodo %lu ms, duty %u%%, repeticiones %lu, canales 0x%04lX",
+             s_defaults[p.type].name, (unsigned long)p.period_ms, p.duty_pct,
+             (unsigned long)p.repeat, (unsigned long)p.channel_mask);
+    return ESP_OK;
+}
+
+void led_effect_stop(void)
+{
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (s_running) {
+        finish_locked();
+    }
+    xSemaphoreGive(s_mutex);
+}
+
+bool led_effect_get_state(led_effect_params_t *params, uint32_t *cycles)
+{
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool running = s_running;
+    if (running && params) {
+        *params = s_params;
+    }
+    if (running && cycles) {
+        *cycles = s_cycles;
+    }
+    xSemaphoreGive(s_mutex);
+    return running;
+}
+
+const char *led_effect_name(led_effect_type_t type)
+{
+    if (type < 0 || type >= EFFECT_TYPE_COUNT) {
+        return "NONE";
+    }
+    return s_defaults[type].name;
+}
+
+led_effect_type_t led_effect_from_name(const char *name)
+{
+    for (int i = LED_EFFECT_NONE + 1; i < EFFECT_TYPE_COUNT; i++) {
+        if (strcmp(name, s_defaults[i].name) == 0) {
+            return (led_effect_type_t)i;
+        }
+    }
+    return LED_EFFECT_NONE;
+}
@@ -0,0 +1,98 @@
+/*
+ * led_internal.h
+ *
+ * Funciones compartidas entre los ficheros del componente led_control.
+ * No forma parte de la API pública.
+ */
+
+#ifndef LED_INTERNAL_H
+#define LED_INTERNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Transición de la máscara de canales sin efectos secundarios:
+ * nuevo = ((actual & ~clr) | set) ^ tgl, escrito con un solo acceso a
+ * GPIO_OUT_REG. Segura en ISR. Si `previous` / `version` no son NULL
+ * reciben la máscara anterior y la versión resultante.
+ */
+uint32_t led_control_update_raw(uint32_t set, uint32_t clr, uint32_t tgl,
+                                uint32_t *previous, uint32_t *version);
+
+/**
+ * Igual que led_control_update_raw() pero, si cambia el canal del LED con
+ * el modo PWM activo, actualiza también el LEDC (solo desde tarea).
+ */
+uint32_t led_control_update(uint32_t set, uint32_t clr, uint32_t tgl);
+
+/**
+ * Igual que led_control_update() pero sin abrir la ventana de guardado en
+ * NVS (la copia RTC sí se actualiza): para los pasos de los efectos, que
+ * de otro modo escribirían la flash cada pocos segundos mientras duren.
+ * La planificación usa led_control_update(): sus trabajos son puntuales.
+ */
+uint32_t led_control_update_transient(uint32_t set, uint32_t clr, uint32_t tgl);
+
+/**
+ * Desde ISR, tras una o varias led_control_update_raw(): difiere a la
+ * tarea del timer de FreeRTOS la parte de tarea de los canales `changed`
+ * (seguimiento PWM y, si `persist`, la ventana de NVS).
+ */
+void led_control_sync_from_isr(uint32_t changed, bool persist);
+
+/**
+ * Igual que led_control_update() pero devuelve la versión resultante;
+ * `mask` (si no es NULL) recibe la máscara resultante.
+ */
+uint32_t led_control_update_versioned(uint32_t set, uint32_t clr, uint32_t tgl, uint32_t *mask);
+
+/**
+ * Con el modo PWM activo, traslada un encendido/apagado del canal del LED
+ * al duty del LEDC (solo desde tarea).
+ */
+void led_pwm_follow_state(bool on);
+
+/**
+ * Crea el temporizador y el mutex del motor de efectos (llamada desde
+ * led_control_init).
+ */
+void led_effect_init(void);
+
+/**
+ * Crea y habilita el gptimer de reproducción de timelines (llamada desde
+ * led_control_init).
+ */
+void led_timeline_init(void);
+
+/**
+ * Prepara la rueda de planificación y su esp_timer (llamada desde
+ * led_control_init).
+ */
+void led_sched_init(void);
+
+/**
+ * Copia la máscara en la memoria RTC (desde la sección crítica de
+ * led_control_update_raw; segura en ISR).
+ */
+void led_persist_mirror(uint32_t mask);
+
+/**
+ * Notifica un cambio de estado: abre la ventana de guardado en NVS si no
+ * hay una abierta (solo desde tarea).
+ */
+void led_persist_note_change(void);
+
+/**
+ * Crea el temporizador de guardado y devuelve la máscara a restaurar
+ * (RTC si es válida, si no NVS, si no 0).
+ */
+uint32_t led_persist_restore(void);
+
+/**
+ * Carga de NVS las tablas de escenas y grupos (llamada desde
+ * led_control_init).
+ */
+void led_scene_init(void);
+
+#endif /* LED_INTERNAL_H */
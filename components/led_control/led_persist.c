@@ -0,0 +1,155 @@
+/**
+ * @file led_persist.c
+ * @brief Copia del estado de los canales en memoria RTC y en NVS.
+ *
+ * La copia RTC guarda la máscara junto con su complemento y un número
+ * mágico; tras un arranque en frío su contenido es aleatorio y la
+ * comprobación lo descarta. La escritura NVS la hace un esp_timer
+ * one-shot, nunca la ruta de conmutación.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#include "led_persist.h"
+#include "led_control.h"
+#include "led_internal.h"
+
+#include "esp_attr.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+static const char *TAG = "LED_PERSIST";
+
+#define RTC_MAGIC  0x4C454431  /* "LED1" */
+
+/* Copia en memoria RTC (no se inicializa al arrancar) */
+typedef struct {
+    uint32_t magic;
+    uint32_t mask;
+    uint32_t mask_inv;
+} rtc_state_t;
+
+static RTC_NOINIT_ATTR rtc_state_t s_rtc;
+
+static esp_timer_handle_t s_timer = NULL;
+static uint32_t s_nvs_mask = 0;      /* Último valor escrito/leído en NVS */
+static bool s_nvs_valid = false;
+
+
+/* Funciones privadas ------------------------------------------------------ */
+
+static bool rtc_valid(void)
+{
+    return s_rtc.magic == RTC_MAGIC && s_rtc.mask == ~s_rtc.mask_inv;
+}
+
+static esp_err_t nvs_read_mask(uint32_t *mask)
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(LED_PERSIST_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = nvs_get_u32(handle, LED_PERSIST_NVS_KEY, mask);
+    nvs_close(handle);
+    return ret;
+}
+
+static esp_err_t nvs_write_mask(uint32_t mask)
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(LED_PERSIST_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = nvs_set_u32(handle, LED_PERSIST_NVS_KEY, mask);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return ret;
+}
+
+static void persist_timer_cb(void *arg)
+{
+    esp_err_t ret = led_persist_flush();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Error guardando estado en NVS: %s", esp_err_to_name(ret));
+    }
+}
+
+
+/* Funciones internas del componente --------------------------------------- */
+
+IRAM_ATTR void led_persist_mirror(uint32_t mask)
+{
+    s_rtc.mask = mask;
+    s_rtc.mask_inv = ~mask;
+    s_rtc.magic = RTC_MAGIC;
+}
+
+void led_persist_note_change(void)
+{
+    /* Ventana ya abierta: el cambio se guardará al cerrarla */
+    if (s_timer == NULL || esp_timer_is_active(s_timer)) {
+        return;
+    }
+    esp_timer_start_once(s_timer, (uint64_t)LED_PERSIST_NVS_INTERVAL_MS * 1000);
+}
+
+uint32_t led_persist_restore(void)
+{
+    const esp_timer_create_args_t args = {
+        .callback = persist_timer_cb,
+        .name = "led_persist",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &s_timer));
+
+    uint32_t nvs_mask = 0;
+    esp_err_t ret = nvs_read_mask(&nvs_mask);
+    s_nvs_valid = (ret == ESP_OK);
+    s_nvs_mask = s_nvs_valid ? nvs_mask : 0;
+
+#if LED_PERSIST_RESTORE
+    esp_reset_reason_t reason = esp_reset_reason();
+    if (reason != ESP_RST_POWERON && rtc_valid()) {
+        ESP_LOGI(TAG, "Estado restaurado de RTC: 0x%04lX (reset %d)",
+                 (unsigned long)s_rtc.mask, reason);
+        return s_rtc.mask;
+    }
+    if (s_nvs_valid) {
+        ESP_LOGI(TAG, "Estado restaurado de NVS: 0x%04lX", (unsigned long)nvs_mask);
+        return nvs_mask;
+    }
+    if (ret != ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGW(TAG, "No se pudo leer NVS: %s", esp_err_to_name(ret));
+    }
+#endif
+    return 0;
+}
+
+
+/* API pública ------------------------------------------------------------- */
+
+esp_err_t led_persist_flush(void)
+{
+    if (s_timer) {
+        esp_timer_stop(s_timer);
+    }
+
+    uint32_t mask = led_control_get_mask();
+    if (s_nvs_valid && mask == s_nvs_mask) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = nvs_write_mask(mask);
+    if (ret == ESP_OK) {
+        s_nvs_mask = mask;
+        s_nvs_valid = true;
+        ESP_LOGD(TAG, "Estado guardado en NVS: 0x%04lX", (unsigned long)mask);
+    }
+    return ret;
+}
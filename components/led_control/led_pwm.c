@@ -0,0 +1,223 @@
+/**
+ * @file led_pwm.c
+ * @brief Brillo PWM del LED principal con el periférico LEDC.
+ *
+ * La tabla gamma (256 entradas) se calcula una vez al activar el modo.
+ * Los fundidos usan el motor de fade del LEDC: una llamada programa el
+ * duty final y la duración, y el hardware avanza el duty sin CPU. Un
+ * cambio de brillo directo aborta antes el fundido en curso.
+ * El fade del LEDC es lineal en duty, no en brillo percibido.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#include "led_pwm.h"
+#include "led_control.h"
+#include "led_internal.h"
+
+#include <math.h>
+
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "esp_log.h"
+
+static const char *TAG = "LED_PWM";
+
+/* Recursos LEDC usados (el C3 solo tiene modo de baja velocidad) */
+#define PWM_SPEED_MODE  LEDC_LOW_SPEED_MODE
+#define PWM_TIMER       LEDC_TIMER_0
+#define PWM_CHANNEL     LEDC_CHANNEL_0
+
+/* Duty para el 100 %: 2^resolución */
+#define PWM_DUTY_MAX    (1UL << LED_PWM_DUTY_RESOLUTION)
+
+/* Tabla brillo (0..255) -> duty */
+static uint16_t s_gamma[256];
+
+static bool s_enabled = false;
+static bool s_fade_installed = false;
+
+/* Brillo objetivo actual y último brillo distinto de cero ("encendido") */
+static uint8_t s_level = 0;
+static uint8_t s_on_level = 255;
+
+
+/* Funciones privadas ------------------------------------------------------ */
+
+static void build_gamma_table(void)
+{
+    for (int i = 0; i < 256; i++) {
+        float norm = i / 255.0f;
+        s_gamma[i] = (uint16_t)lroundf(powf(norm, LED_PWM_GAMMA) * PWM_DUTY_MAX);
+    }
+    /* Cualquier brillo > 0 debe dar algo de luz */
+    for (int i = 1; i < 256 && s_gamma[i] == 0; i++) {
+        s_gamma[i] = 1;
+    }
+}
+
+/* Refleja el brillo en el bit del canal del LED (sin volver a tocar el LEDC) */
+static void sync_led_bit(uint8_t level)
+{
+    uint32_t bit = 1UL << LED_CONTROL_LED_CHANNEL;
+    led_control_update_raw(level ? bit : 0, level ? 0 : bit, 0, NULL, NULL);
+}
+
+/* Aborta un fundido en curso para que el nuevo duty se aplique ya */
+static void stop_fade(void)
+{
+    if (s_fade_installed) {
+        ledc_fade_stop(PWM_SPEED_MODE, PWM_CHANNEL);
+    }
+}
+
+static void remember_level(uint8_t level)
+{
+    s_level = level;
+    if (level) {
+        s_on_level = level;
+    }
+}
+
+
+/* API pública ------------------------------------------------------------- */
+
+esp_err_t led_pwm_enable(void)
+{
+    if (s_enabled) {
+        return ESP_OK;
+    }
+
+    build_gamma_table();
+
+    ledc_timer_config_t timer_conf = {
+        .speed_mode = PWM_SPEED_MODE,
+        .duty_resolution = (ledc_timer_bit_t)LED_PWM_DUTY_RESOLUTION,
+        .timer_num = PWM_TIMER,
+        .freq_hz = LED_PWM_FREQUENCY_HZ,
+        .clk_cfg = LEDC_AUTO_CLK,
+    };
+    esp_err_t ret = ledc_timer_config(&timer_conf);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error configurando timer LEDC: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    uint8_t level = led_control_get_state() ? s_on_level : 0;
+    ledc_channel_config_t channel_conf = {
+        .gpio_num = led_control_get_channel_pin(LED_CONTROL_LED_CHANNEL),
+        .speed_mode = PWM_SPEED_MODE,
+        .channel = PWM_CHANNEL,
+        .intr_type = LEDC_INTR_DISABLE,
+        .timer_sel = PWM_TIMER,
+        .duty = s_gamma[level],
+        .hpoint = 0,
+    };
+    ret = ledc_channel_config(&channel_conf);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error configurando canal LEDC: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    if (!s_fade_installed) {
+        ret = ledc_fade_func_install(0);
+        if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+            ESP_LOGE(TAG, "Error instalando servicio de fade: %s", esp_err_to_name(ret));
+            return ret;
+        }
+        s_fade_installed = true;
+    }
+
+    s_level = level;
+    s_enabled = true;
+    ESP_LOGI(TAG, "PWM activo: %d bits, %d Hz, brillo %u",
+             LED_PWM_DUTY_RESOLUTION, LED_PWM_FREQUENCY_HZ, level);
+    return ESP_OK;
+}
+
+esp_err_t led_pwm_disable(void)
+{
+    if (!s_enabled) {
+        return ESP_OK;
+    }
+
+    ledc_stop(PWM_SPEED_MODE, PWM_CHANNEL, 0);
+
+    /* Devolver el pin a la matriz GPIO como salida simple */
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << led_control_get_channel_pin(LED_CONTROL_LED_CHANNEL),
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    gpio_config(&io_conf);
+
+    s_enabled = false;
+    /* Reescribir el registro de salida con el estado actual */
+    led_control_update_raw(0, 0, 0, NULL, NULL);
+
+    ESP_LOGI(TAG, "PWM desactivado, LED en modo digital");
+    return ESP_OK;
+}
+
+bool led_pwm_is_enabled(void)
+{
+    return s_enabled;
+}
+
+esp_err_t led_pwm_set_brightness(uint8_t level)
+{
+    if (!s_enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    stop_fade();
+    esp_err_t ret = ledc_set_duty_and_update(PWM_SPEED_MODE, PWM_CHANNEL, s_gamma[level], 0);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    remember_level(level);
+    sync_led_bit(level);
+    return ESP_OK;
+}
+
+esp_err_t led_pwm_fade_to(uint8_t level, uint32_t duration_ms)
+{
+    if (!s_enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    stop_fade();
+    esp_err_t ret = ledc_set_fade_time_and_start(PWM_SPEED_MODE, PWM_CHANNEL, s_gamma[level],
+                                                 duration_ms, LEDC_FADE_NO_WAIT);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error iniciando fade: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    remember_level(level);
+    sync_led_bit(level);
+    ESP_LOGD(TAG, "Fade a brillo %u en %lu ms", level, (unsigned long)duration_ms);
+    return ESP_OK;
+}
+
+uint8_t led_pwm_get_brightness(void)
+{
+    return s_level;
+}
+
+uint32_t led_pwm_level_to_duty(uint8_t level)
+{
+    return s_gamma[level];
+}
+
+void led_pwm_follow_state(bool on)
+{
+    uint8_t level = on ? s_on_level : 0;
+    s_level = level;
+    stop_fade();
+    ledc_set_duty_and_update(PWM_SPEED_MODE, PWM_CHANNEL, s_gamma[level], 0);
+}
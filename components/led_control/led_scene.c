@@ -0,0 +1,315 @@
+/**
+ * @file led_scene.c
+ * @brief Tablas de escenas y grupos en RAM con copia en NVS.
+ *
+ * Cada tabla se guarda como un blob (array de entradas) bajo su propia
+ * clave; cualquier alta o baja reescribe el blob completo. Si la
+ * escritura falla, la tabla en RAM vuelve a su estado anterior: RAM y NVS
+ * nunca divergen. Un mutex protege las tablas frente a lecturas desde
+ * otras tareas.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#include "led_scene.h"
+#include "led_control.h"
+#include "led_internal.h"
+
+#include <ctype.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+static const char *TAG = "LED_SCENE";
+
+#define NVS_KEY_SCENES  "scenes"
+#define NVS_KEY_GROUPS  "groups"
+
+static led_scene_t s_scenes[LED_SCENE_MAX];
+static size_t s_scene_count = 0;
+
+static led_group_t s_groups[LED_GROUP_MAX];
+static size_t s_group_count = 0;
+
+static SemaphoreHandle_t s_mutex = NULL;
+
+
+/* Funciones privadas ------------------------------------------------------ */
+
+/* Nombres: 1..15 caracteres [A-Za-z0-9_-] */
+static bool valid_name(const char *name)
+{
+    size_t len = name ? strlen(name) : 0;
+    if (len == 0 || len >= LED_SCENE_NAME_MAX) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (!isalnum((unsigned char)name[i]) && name[i] != '_' && name[i] != '-') {
+            return false;
+        }
+    }
+    return true;
+}
+
+static esp_err_t save_blob(const char *key, const void *data, size_t len)
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(LED_SCENE_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = len ? nvs_set_blob(handle, key, data, len) : nvs_erase_key(handle, key);
+    if (ret == ESP_ERR_NVS_NOT_FOUND) {
+        ret = ESP_OK;
+    }
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error guardando %s: %s", key, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/* Carga un blob de entradas de tamaño fijo; devuelve el número leído */
+static size_t load_blob(nvs_handle_t handle, const char *key, void *data,
+                        size_t entry_size, size_t max_entries)
+{
+    size_t len = entry_size * max_entries;
+    if (nvs_get_blob(handle, key, data, &len) != ESP_OK || len % entry_size != 0) {
+        return 0;
+    }
+    return len / entry_size;
+}
+
+static int find_scene(const char *name)
+{
+    for (size_t i = 0; i < s_scene_count; i++) {
+        if (strcmp(s_scenes[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int find_group(const char *name)
+{
+    for (size_t i = 0; i < s_group_count; i++) {
+        if (strcmp(s_groups[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+/* Funciones internas del componente --------------------------------------- */
+
+void led_scene_init(void)
+{
+    s_mutex = xSemaphoreCreateMutex();
+
+    nvs_handle_t handle;
+    if (nvs_open(LED_SCENE_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+    s_scene_count = load_blob(handle, NVS_KEY_SCENES, s_scenes, sizeof(led_scene_t), LED_SCENE_MAX);
+    s_group_count = load_blob(handle, NVS_KEY_GROUPS, s_groups, sizeof(led_group_t), LED_GROUP_MAX);
+    nvs_close(handle);
+
+    /* Asegurar nombres terminados aunque el blob esté corrupto */
+    for (size_t i = 0; i < s_scene_count; i++) {
+        s_scenes[i].name[LED_SCENE_NAME_MAX - 1] = '\0';
+    }
+    for (size_t i = 0; i < s_group_count; i++) {
+        s_groups[i].name[LED_SCENE_NAME_MAX - 1] = '\0';
+    }
+    ESP_LOGI(TAG, "%u escenas y %u grupos cargados de NVS",
+             (unsigned)s_scene_count, (unsigned)s_group_count);
+}
+
+
+/* API pública: escenas ---------------------------------------------------- */
+
+esp_err_t led_scene_define(const char *name, uint16_t set_mask, uint16_t clear_mask)
+{
+    if (!valid_name(name)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    led_scene_t scene = { 0 };
+    strcpy(scene.name, name);
+    scene.set_mask = set_mask;
+    scene.clear_mask = clear_mask;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    size_t old_count = s_scene_count;
+    int idx = find_scene(name);
+    if (idx < 0) {
+        if (s_scene_count >= LED_SCENE_MAX) {
+            xSemaphoreGive(s_mutex);
+            return ESP_ERR_NO_MEM;
+        }
+        idx = s_scene_count++;
+    }
+    led_scene_t old = s_scenes[idx];
+    s_scenes[idx] = scene;
+    esp_err_t ret = save_blob(NVS_KEY_SCENES, s_scenes, s_scene_count * sizeof(led_scene_t));
+    if (ret != ESP_OK) {
+        s_scenes[idx] = old;
+        s_scene_count = old_count;
+    }
+    xSemaphoreGive(s_mutex);
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Escena %s: encender 0x%04X, apagar 0x%04X", name, set_mask, clear_mask);
+    }
+    return ret;
+}
+
+esp_err_t led_scene_delete(const char *name)
+{
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    int idx = find_scene(name);
+    if (idx < 0) {
+        xSemaphoreGive(s_mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+    led_scene_t removed = s_scenes[idx];
+    s_scenes[idx] = s_scenes[--s_scene_count];
+    esp_err_t ret = save_blob(NVS_KEY_SCENES, s_scenes, s_scene_count * sizeof(led_scene_t));
+    if (ret != ESP_OK) {
+        s_scenes[s_scene_count++] = s_scenes[idx];
+        s_scenes[idx] = removed;
+    }
+    xSemaphoreGive(s_mutex);
+    return ret;
+}
+
+esp_err_t led_scene_apply(const char *name, uint32_t *version)
+{
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    int idx = find_scene(name);
+    led_scene_t scene;
+    if (idx >= 0) {
+        scene = s_scenes[idx];
+    }
+    xSemaphoreGive(s_mutex);
+
+    if (idx < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint32_t mask;
+    uint32_t ver = led_control_update_versioned(scene.set_mask, scene.clear_mask, 0, &mask);
+    if (version) {
+        *version = ver;
+    }
+    ESP_LOGI(TAG, "Escena %s aplicada: 0x%04lX", name, (unsigned long)mask);
+    return ESP_OK;
+}
+
+bool led_scene_get(size_t index, led_scene_t *scene)
+{
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool ok = index < s_scene_count;
+    if (ok) {
+        *scene = s_scenes[index];
+    }
+    xSemaphoreGive(s_mutex);
+    return ok;
+}
+
+size_t led_scene_count(void)
+{
+    return s_scene_count;
+}
+
+
+/* API pública: grupos ----------------------------------------------------- */
+
+esp_err_t led_group_define(const char *name, uint16_t mask)
+{
+    if (!valid_name(name) || mask == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    led_group_t group = { 0 };
+    strcpy(group.name, name);
+    group.mask = mask;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    size_t old_count = s_group_count;
+    int idx = find_group(name);
+    if (idx < 0) {
+        if (s_group_count >= LED_GROUP_MAX) {
+            xSemaphoreGive(s_mutex);
+            return ESP_ERR_NO_MEM;
+        }
+        idx = s_group_count++;
+    }
+    led_group_t old = s_groups[idx];
+    s_groups[idx] = group;
+    esp_err_t ret = save_blob(NVS_KEY_GROUPS, s_groups, s_group_count * sizeof(led_group_t));
+    if (ret != ESP_OK) {
+        s_groups[idx] = old;
+        s_group_count = old_count;
+    }
+    xSemaphoreGive(s_mutex);
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Grupo %s: 0x%04X", name, mask);
+    }
+    return ret;
+}
+
+esp_err_t led_group_delete(const char *name)
+{
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    int idx = find_group(name);
+    if (idx < 0) {
+        xSemaphoreGive(s_mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+    led_group_t removed = s_groups[idx];
+    s_groups[idx] = s_groups[--s_group_count];
+    esp_err_t ret = save_blob(NVS_KEY_GROUPS, s_groups, s_group_count * sizeof(led_group_t));
+    if (ret != ESP_OK) {
+        s_groups[s_group_count++] = s_groups[idx];
+        s_groups[idx] = removed;
+    }
+    xSemaphoreGive(s_mutex);
+    return ret;
+}
+
+esp_err_t led_group_find(const char *name, uint16_t *mask)
+{
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    int idx = find_group(name);
+    if (idx >= 0) {
+        *mask = s_groups[idx].mask;
+    }
+    xSemaphoreGive(s_mutex);
+    return idx >= 0 ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+bool led_group_get(size_t index, led_group_t *group)
+{
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool ok = index < s_group_count;
+    if (ok) {
+        *group = s_groups[index];
+    }
+    xSemaphoreGive(s_mutex);
+    return ok;
+}
+
+size_t led_group_count(void)
+{
+    return s_group_count;
+}
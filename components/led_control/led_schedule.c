@@ -0,0 +1,350 @@
+/**
+ * @file led_schedule.c
+ * @brief Planificador de acciones diferidas con una rueda jerárquica.
+ *
+ * Cuatro niveles: el nivel 0 tiene 256 ranuras de un tick y los niveles
+ * 1..3 tienen 64 ranuras que cubren 256, 256*64 y 256*64^2 ticks. Un
+ * trabajo se enlaza en la ranura del nivel más bajo que alcanza su
+ * vencimiento; cada vez que el índice de un nivel da la vuelta, la ranura
+ * siguiente del nivel superior se redistribuye ("cascada") hacia abajo.
+ * Insertar y cancelar son O(1): listas doblemente enlazadas de índices
+ * sobre un pool estático, con un identificador índice+generación que
+ * detecta cancelaciones de trabajos ya vencidos.
+ *
+ * Un único esp_timer periódico avanza la rueda y se detiene cuando no
+ * quedan trabajos. Los trabajos que vencen en el mismo tick se combinan
+ * en una sola transición de canales (una escritura de registro).
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#include "led_schedule.h"
+#include "led_internal.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "LED_SCHED";
+
+#define TICK_US        ((int64_t)LED_SCHED_TICK_MS * 1000)
+
+/* Geometría de la rueda */
+#define L0_BITS        8
+#define LN_BITS        6
+#define L0_SIZE        (1 << L0_BITS)
+#define LN_SIZE        (1 << LN_BITS)
+#define LEVELS         4
+#define SLOT_COUNT     (L0_SIZE + (LEVELS - 1) * LN_SIZE)
+#define LEVEL_SHIFT(l) (L0_BITS + ((l) - 1) * LN_BITS)
+#define LEVEL_BASE(l)  (L0_SIZE + ((l) - 1) * LN_SIZE)
+
+/* Retardo máximo representable (~7,7 días con tick de 10 ms) */
+#define MAX_TICKS      ((1UL << (L0_BITS + (LEVELS - 1) * LN_BITS)) - 1)
+
+#define NIL            0xFFFF
+#define SLOT_FREE      0xFFFF
+
+_Static_assert(LED_SCHED_MAX_JOBS < NIL, "LED_SCHED_MAX_JOBS debe caber en 16 bits");
+
+/* Nodo de trabajo (16 bytes) */
+typedef struct {
+    uint32_t expires;       /* Tick absoluto de vencimiento */
+    uint16_t next;
+    uint16_t prev;
+    uint16_t slot;          /* Ranura donde está enlazado o SLOT_FREE */
+    uint8_t gen;            /* Generación (nunca 0) */
+    uint8_t action;
+    uint16_t set_mask;
+    uint16_t clear_mask;
+} sched_node_t;
+
+static sched_node_t s_nodes[LED_SCHED_MAX_JOBS];
+static uint16_t s_heads[SLOT_COUNT];
+static uint16_t s_free = NIL;
+static size_t s_count = 0;
+
+/* Siguiente tick por procesar y origen de tiempos de la rueda */
+static uint32_t s_now = 0;
+static int64_t s_base_us = 0;
+
+static SemaphoreHandle_t s_mutex = NULL;
+static esp_timer_handle_t s_timer = NULL;
+static bool s_timer_running = false;
+
+
+/* Funciones privadas (con s_mutex tomado) --------------------------------- */
+
+static inline led_sched_id_t make_id(uint16_t idx)
+{
+    return ((uint32_t)s_nodes[idx].gen << 16) | idx;
+}
+
+/* Ranura que corresponde a un vencimiento, relativa a s_now */
+static uint16_t slot_for(uint32_t expires)
+{
+    int32_t delta = (int32_t)(expires - s_now);
+
+    if (delta < 0) {
+        /* Ya vencido (no debería ocurrir): siguiente tick */
+        return s_now & (L0_SIZE - 1);
+    }
+    if (delta < L0_SIZE) {
+        return expires & (L0_SIZE - 1);
+    }
+    for (int level = 1; level < LEVELS - 1; level++) {
+        if ((uint32_t)delta < (1UL << LEVEL_SHIFT(level + 1))) {
+            return LEVEL_BASE(level) + ((expires >> LEVEL_SHIFT(level)) & (LN_SIZE - 1));
+        }
+    }
+    return LEVEL_BASE(LEVELS - 1) + ((expires >> LEVEL_SHIFT(LEVELS - 1)) & (LN_SIZE - 1));
+}
+
+static void link_node(uint16_t idx)
+{
+    sched_node_t *n = &s_nodes[idx];
+    uint16_t slot = slot_for(n->expires);
+
+    n->slot = slot;
+    n->prev = NIL;
+    n->next = s_heads[slot];
+    if (n->next != NIL) {
+        s_nodes[n->next].prev = idx;
+    }
+    s_heads[slot] = idx;
+}
+
+static void unlink_node(uint16_t idx)
+{
+    sched_node_t *n = &s_nodes[idx];
+
+    if (n->prev != NIL) {
+        s_nodes[n->prev].next = n->next;
+    } else {
+        s_heads[n->slot] = n->next;
+    }
+    if (n->next != NIL) {
+        s_nodes[n->next].prev = n->prev;
+    }
+}
+
+static void free_node(uint16_t idx)
+{
+    s_nodes[idx].slot = SLOT_FREE;
+    s_nodes[idx].next = s_free;
+    s_free = idx;
+    s_count--;
+}
+
+/* Redistribuye una ranura de un nivel superior; devuelve su índice */
+static uint32_t cascade(int level)
+{
+    uint32_t index = (s_now >> LEVEL_SHIFT(level)) & (LN_SIZE - 1);
+    uint16_t slot = LEVEL_BASE(level) + index;
+    uint16_t idx = s_heads[slot];
+
+    s_heads[slot] = NIL;
+    while (idx != NIL) {
+        uint16_t next = s_nodes[idx].next;
+        link_node(idx);
+        idx = next;
+    }
+    return index;
+}
+
+/*
+ * Procesa el tick s_now: cascadas, y después todos los trabajos de la
+ * ranura del nivel 0, combinados en una sola transición
+ * nuevo = ((m & ~clr) | set) ^ tgl.
+ */
+static void advance_tick(void)
+{
+    if ((s_now & (L0_SIZE - 1)) == 0) {
+        int level = 1;
+        while (level < LEVELS && cascade(level) == 0) {
+            level++;
+        }
+    }
+
+    uint16_t slot = s_now & (L0_SIZE - 1);
+    uint16_t idx = s_heads[slot];
+    uint32_t set = 0, clr = 0, tgl = 0;
+    int ran = 0;
+
+    s_heads[slot] = NIL;
+    while (idx != NIL) {
+        sched_node_t *n = &s_nodes[idx];
+        uint16_t next = n->next;
+
+        if (n->action == LED_SCHED_TOGGLE) {
+            tgl ^= n->set_mask;
+        } else {
+            /* Componer (set, clr) tras la transición acumulada */
+            set = (set & ~n->clear_mask) | n->set_mask;
+            clr |= n->clear_mask;
+            tgl &= ~(n->clear_mask | n->set_mask);
+        }
+        free_node(idx);
+        ran++;
+        idx = next;
+    }
+
+    /* Trabajos puntuales: su resultado debe sobrevivir a un corte (p.ej.
+     * el OFF de un PULSE); la ventana de NVS agrupa las escrituras */
+    if (ran) {
+        led_control_update(set, clr, tgl);
+        ESP_LOGD(TAG, "Tick %lu: %d trabajos", (unsigned long)s_now, ran);
+    }
+    s_now++;
+}
+
+static void sched_timer_cb(void *arg)
+{
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+
+    /* Ponerse al día si el callback se retrasó más de un tick */
+    uint32_t target = (uint32_t)((esp_timer_get_time() - s_base_us) / TICK_US);
+    while ((int32_t)(target - s_now) >= 0 && s_count > 0) {
+        advance_tick();
+    }
+
+    if (s_count == 0 && s_timer_running) {
+        esp_timer_stop(s_timer);
+        s_timer_running = false;
+    }
+    xSemaphoreGive(s_mutex);
+}
+
+
+/* API pública ------------------------------------------------------------- */
+
+void led_sched_init(void)
+{
+    s_mutex = xSemaphoreCreateMutex();
+
+    for (int i = 0; i < SLOT_COUNT; i++) {
+        s_heads[i] = NIL;
+    }
+    for (int i = 0; i < LED_SCHED_MAX_JOBS; i++) {
+        s_nodes[i].slot = SLOT_FREE;
+        s_nodes[i].gen = 1;
+        s_nodes[i].next = (i + 1 < LED_SCHED_MAX_JOBS) ? i + 1 : NIL;
+    }
+    s_free = 0;
+
+    const esp_timer_create_args_t args = {
+        .callback = sched_timer_cb,
+        .name = "led_sched",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &s_timer));
+}
+
+esp_err_t led_sched_add(uint32_t delay_ms, led_sched_action_t action,
+                        uint16_t set_mask, uint16_t clear_mask, led_sched_id_t *id)
+{
+    if (action != LED_SCHED_APPLY && action != LED_SCHED_TOGGLE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t ticks = (delay_ms + LED_SCHED_TICK_MS - 1) / LED_SCHED_TICK_MS;
+    if (ticks > MAX_TICKS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (s_free == NIL) {
+        xSemaphoreGive(s_mutex);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (!s_timer_running) {
+        /* Rueda parada: el tick s_now pasa a ser "ahora" */
+        s_base_us = esp_timer_get_time() - (int64_t)s_now * TICK_US;
+    }
+
+    uint16_t idx = s_free;
+    sched_node_t *n = &s_nodes[idx];
+    s_free = n->next;
+    s_count++;
+
+    n->expires = s_now + ticks;
+    n->action = action;
+    n->set_mask = set_mask;
+    n->clear_mask = clear_mask;
+    if (++n->gen == 0) {
+        n->gen = 1;
+    }
+    link_node(idx);
+
+    if (!s_timer_running) {
+        esp_timer_start_periodic(s_timer, TICK_US);
+        s_timer_running = true;
+    }
+    if (id) {
+        *id = make_id(idx);
+    }
+    xSemaphoreGive(s_mutex);
+
+    ESP_LOGD(TAG, "Trabajo 0x%08lX en %lu ms", (unsigned long)make_id(idx), (unsigned long)delay_ms);
+    return ESP_OK;
+}
+
+esp_err_t led_sched_cancel(led_sched_id_t id)
+{
+    uint32_t idx = id & 0xFFFF;
+    if (idx >= LED_SCHED_MAX_JOBS) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (s_nodes[idx].slot != SLOT_FREE && make_id(idx) == id) {
+        unlink_node(idx);
+        free_node(idx);
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(s_mutex);
+    return ret;
+}
+
+void led_sched_cancel_all(void)
+{
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    for (int i = 0; i < LED_SCHED_MAX_JOBS; i++) {
+        if (s_nodes[i].slot != SLOT_FREE) {
+            unlink_node(i);
+            free_node(i);
+        }
+    }
+    xSemaphoreGive(s_mutex);
+    ESP_LOGI(TAG, "Todos los trabajos cancelados");
+}
+
+size_t led_sched_count(void)
+{
+    return s_count;
+}
+
+size_t led_sched_list(led_sched_job_info_t *out, size_t max)
+{
+    size_t n = 0;
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    for (int i = 0; i < LED_SCHED_MAX_JOBS && n < max; i++) {
+        const sched_node_t *node = &s_nodes[i];
+        if (node->slot == SLOT_FREE) {
+            continue;
+        }
+        out[n++] = (led_sched_job_info_t) {
+            .id = make_id(i),
+            .due_in_ms = (node->expires - s_now) * LED_SCHED_TICK_MS,
+            .action = node->action,
+            .set_mask = node->set_mask,
+            .clear_mask = node->clear_mask,
+        };
+    }
+    xSemaphoreGive(s_mutex);
+    return n;
+}
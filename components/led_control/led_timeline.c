@@ -0,0 +1,365 @@
+/**
+ * @file led_timeline.c
+ * @brief Reproducción de timelines con la ISR de alarma de un gptimer.
+ *
+ * El gptimer cuenta a 1 MHz desde el arranque de la reproducción. La ISR
+ * aplica el evento actual (y los siguientes con delta 0), programa la
+ * alarma absoluta del siguiente y mide el jitter como la diferencia entre
+ * la cuenta al entrar en la ISR y el valor de alarma.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#include "led_timeline.h"
+#include "led_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/timers.h"
+#include "driver/gptimer.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "LED_TIMELINE";
+
+/* Resolución del gptimer: 1 tick = 1 us */
+#define TIMELINE_RESOLUTION_HZ  1000000
+
+/* Duración mínima de una vuelta en bucle (evita ISR en bucle cerrado) */
+#define TIMELINE_MIN_LOOP_US    100
+
+/* Buffer de eventos (dos instancias: activo y de carga) */
+typedef struct {
+    led_timeline_event_t events[LED_TIMELINE_MAX_EVENTS];
+    uint16_t count;
+    uint8_t flags;
+} timeline_buffer_t;
+
+static timeline_buffer_t s_buffers[2];
+static volatile int s_active = 0;
+static volatile bool s_swap_pending = false;
+static volatile bool s_playing = false;
+
+static gptimer_handle_t s_timer = NULL;
+static bool s_timer_running = false;   /* gptimer en marcha (bajo s_lock) */
+
+/* Estado de la ISR */
+static uint32_t s_index = 0;
+static uint64_t s_next_alarm = 0;
+
+/* Estadísticas (escritas por la ISR, leídas bajo s_lock) */
+static led_timeline_stats_t s_stats;
+static uint64_t s_jitter_sum = 0;
+static uint32_t s_jitter_samples = 0;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+
+/* ISR --------------------------------------------------------------------- */
+
+/*
+ * Para el gptimer si está en marcha. gptimer_stop() con el timer parado
+ * devuelve error y el driver lo registra con ESP_LOGE; con el estado
+ * propio solo se llama una vez por arranque. Con `only_idle`, no lo para
+ * si entretanto arrancó otra reproducción (el timer es suyo).
+ */
+static void timeline_timer_stop(bool only_idle)
+{
+    portENTER_CRITICAL(&s_lock);
+    bool stop = s_timer_running && !(only_idle && s_playing);
+    if (stop) {
+        s_timer_running = false;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (stop) {
+        gptimer_stop(s_timer);
+    }
+}
+
+/* Fin de una secuencia sin bucle: el gptimer se para fuera de la ISR */
+static void timeline_stop_deferred(void *arg1, uint32_t arg2)
+{
+    timeline_timer_stop(true);
+}
+
+static bool IRAM_ATTR timeline_on_alarm(gptimer_handle_t timer,
+                                        const gptimer_alarm_event_data_t *edata,
+                                        void *user_ctx)
+{
+    uint32_t jitter = (uint32_t)(edata->count_value - edata->alarm_value);
+
+    portENTER_CRITICAL_ISR(&s_lock);
+    if (jitter < s_stats.jitter_min_us) {
+        s_stats.jitter_min_us = jitter;
+    }
+    if (jitter > s_stats.jitter_max_us) {
+        s_stats.jitter_max_us = jitter;
+    }
+    s_jitter_sum += jitter;
+    s_jitter_samples++;
+
+    timeline_buffer_t *buf = &s_buffers[s_active];
+    uint32_t applied = 0;
+    uint32_t changed = 0;
+    bool finished = false;
+
+    /* Aplicar el evento actual y los que le siguen con delta 0 */
+    do {
+        const led_timeline_event_t *ev = &buf->events[s_index];
+        uint32_t before;
+        uint32_t mask = led_control_update_raw(ev->set_mask, ev->clear_mask, 0, &before, NULL);
+        changed ^= before ^ mask;
+        s_stats.events_played++;
+        applied++;
+
+        if (++s_index >= buf->count) {
+            if (!(buf->flags & LED_TIMELINE_FLAG_LOOP)) {
+                s_playing = false;
+                finished = true;
+                break;
+            }
+            s_stats.loops++;
+            if (s_swap_pending) {
+                s_active ^= 1;
+                s_swap_pending = false;
+                buf = &s_buffers[s_active];
+            }
+            s_index = 0;
+        }
+    } while (buf->events[s_index].delta_us == 0 && applied < buf->count);
+
+    if (!finished) {
+        s_next_alarm += buf->events[s_index].delta_us;
+    }
+    portEXIT_CRITICAL_ISR(&s_lock);
+
+    /* Canal del LED en modo PWM: el LEDC sigue al evento desde tarea. Los
+     * pasos de una secuencia no se guardan en NVS */
+    led_control_sync_from_isr(changed, false);
+
+    if (finished) {
+        BaseType_t woken = pdFALSE;
+        xTimerPendFunctionCallFromISR(timeline_stop_deferred, NULL, 0, &woken);
+        return woken == pdTRUE;
+    }
+
+    uint64_t now = 0;
+    gptimer_get_raw_count(timer, &now);
+    if (s_next_alarm <= now) {
+        /* La alarma en el pasado salta de inmediato; se contabiliza */
+        s_stats.late_events++;
+    }
+
+    gptimer_alarm_config_t alarm = {
+        .alarm_count = s_next_alarm,
+    };
+    gptimer_set_alarm_action(timer, &alarm);
+    return false;
+}
+
+
+/* API pública ------------------------------------------------------------- */
+
+void led_timeline_init(void)
+{
+    gptimer_config_t config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = TIMELINE_RESOLUTION_HZ,
+    };
+    ESP_ERROR_CHECK(gptimer_new_timer(&config, &s_timer));
+
+    gptimer_event_callbacks_t cbs = {
+        .on_alarm = timeline_on_alarm,
+    };
+    ESP_ERROR_CHECK(gptimer_register_event_callbacks(s_timer, &cbs, NULL));
+    ESP_ERROR_CHECK(gptimer_enable(s_timer));
+}
+
+esp_err_t led_timeline_load(const uint8_t *data, size_t len)
+{
+    if (data == NULL || len < LED_TIMELINE_HEADER_SIZE ||
+        memcmp(data, LED_TIMELINE_MAGIC, 4) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint16_t count = data[4] | (data[5] << 8);
+    uint8_t flags = data[6];
+    if (count == 0 || count > LED_TIMELINE_MAX_EVENTS) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (len != LED_TIMELINE_HEADER_SIZE + count * sizeof(led_timeline_event_t)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const led_timeline_event_t *events = (const led_timeline_event_t *)(data + LED_TIMELINE_HEADER_SIZE);
+    if (flags & LED_TIMELINE_FLAG_LOOP) {
+        uint64_t total_us = 0;
+        for (int i = 0; i < count; i++) {
+            total_us += events[i].delta_us;
+        }
+        if (total_us < TIMELINE_MIN_LOOP_US) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    /* Invalidar un cambio pendiente mientras se escribe el buffer inactivo */
+    portENTER_CRITICAL(&s_lock);
+    s_swap_pending = false;
+    int back = s_active ^ 1;
+    portEXIT_CRITICAL(&s_lock);
+
+    memcpy(s_buffers[back].events, events, count * sizeof(led_timeline_event_t));
+    s_buffers[back].count = count;
+    s_buffers[back].flags = flags;
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_playing) {
+        /* La ISR cambia de buffer al terminar la vuelta en curso */
+        s_swap_pending = true;
+    } else {
+        s_active = back;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "Timeline cargado: %u eventos%s", count,
+             (flags & LED_TIMELINE_FLAG_LOOP) ? " (bucle)" : "");
+    return ESP_OK;
+}
+
+esp_err_t led_timeline_start(uint32_t sync_ms)
+{
+    led_timeline_stop();
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_swap_pending) {
+        s_active ^= 1;
+        s_swap_pending = false;
+    }
+    const timeline_buffer_t *buf = &s_buffers[s_active];
+    portEXIT_CRITICAL(&s_lock);
+
+    if (buf->count == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.jitter_min_us = UINT32_MAX;
+    s_jitter_sum = 0;
+    s_jitter_samples = 0;
+    s_index = 0;
+
+    /* Arranque sincronizado: esperar al siguiente múltiplo de sync_ms */
+    uint64_t offset_us = 0;
+    if (sync_ms > 0) {
+        uint64_t period_us = (uint64_t)sync_ms * 1000;
+        offset_us = period_us - ((uint64_t)esp_timer_get_time() % period_us);
+    }
+
+    s_next_alarm = offset_us + buf->events[0].delta_us;
+    gptimer_alarm_config_t alarm = {
+        .alarm_count = s_next_alarm,
+    };
+    gptimer_set_raw_count(s_timer, 0);
+    gptimer_set_alarm_action(s_timer, &alarm);
+
+    s_playing = true;
+    esp_err_t ret = gptimer_start(s_timer);
+    if (ret != ESP_OK) {
+        s_playing = false;
+        return ret;
+    }
+    portENTER_CRITICAL(&s_lock);
+    s_timer_running = true;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "Reproduciendo %u eventos (inicio en %llu us)",
+             buf->count, (unsigned long long)offset_us);
+    return ESP_OK;
+}
+
+void led_timeline_stop(void)
+{
+    timeline_timer_stop(false);
+    s_playing = false;
+}
+
+bool led_timeline_is_playing(void)
+{
+    return s_playing;
+}
+
+size_t led_timeline_get_event_count(void)
+{
+    return s_buffers[s_active].count;
+}
+
+void led_timeline_get_stats(led_timeline_stats_t *stats)
+{
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    stats->jitter_avg_us = s_jitter_samples ? (uint32_t)(s_jitter_sum / s_jitter_samples) : 0;
+    if (s_jitter_samples == 0) {
+        stats->jitter_min_us = 0;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t led_timeline_save(const char *path)
+{
+    const timeline_buffer_t *buf = &s_buffers[s_active];
+    if (buf->count == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        ESP_LOGE(TAG, "No se pudo crear %s", path);
+        return ESP_FAIL;
+    }
+
+    uint8_t header[LED_TIMELINE_HEADER_SIZE] = {
+        'L', 'T', 'L', '1',
+        buf->count & 0xFF, buf->count >> 8,
+        buf->flags, 0,
+    };
+    size_t body = buf->count * sizeof(led_timeline_event_t);
+    bool ok = fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+              fwrite(buf->events, 1, body, file) == body;
+    fclose(file);
+
+    if (!ok) {
+        ESP_LOGE(TAG, "Error escribiendo %s", path);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Timeline guardado en %s", path);
+    return ESP_OK;
+}
+
+esp_err_t led_timeline_load_file(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    size_t max_len = LED_TIMELINE_HEADER_SIZE + LED_TIMELINE_MAX_EVENTS * sizeof(led_timeline_event_t);
+    uint8_t *data = malloc(max_len);
+    if (data == NULL) {
+        fclose(file);
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t len = fread(data, 1, max_len, file);
+    fclose(file);
+
+    esp_err_t ret = led_timeline_load(data, len);
+    free(data);
+    return ret;
+}
@@ -6,8 +6,10 @@
  * textos y estados combinados (por ejemplo: IP, estado del sensor DHT y botón).
  *
  * Notas:
- *  - Las macros de configuración I2C y dimensiones de pantalla están
- *    definidas aquí para facilitar su modificación.
+ *  - El puerto, los pines y la velocidad por defecto del bus I2C son del
+ *    bus compartido (i2c_bus.h); aquí solo la dirección, la velocidad
+ *    mínima, la prioridad y los tiempos de la pantalla. Las dimensiones
+ *    están en oled_gfx.h.
  *  - Este fichero contiene únicamente la interfaz pública; la
  *    implementación está en el componente correspondiente.
  */
@@ -19,89 +21,122 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+#include "esp_err.h"
 #include "fonts.h" /* Tipografías utilizadas por las funciones de texto */
+#include "oled_gfx.h" /* Framebuffer, primitivas de dibujo y texto */
+#include "oled_widgets.h" /* Widgets en modo retenido */
+#include "i2c_bus.h"      /* Bus I2C compartido */
 
 /* -----------------------------
  * Configuración I2C (puede adaptarse según el hardware)
+ * Puerto y pines son del bus compartido (ver i2c_bus.h).
  * ----------------------------- */
-#define I2C_MASTER_SCL_IO      6         /* Pin SCL del maestro I2C */
-#define I2C_MASTER_SDA_IO      5         /* Pin SDA del maestro I2C */
-#define I2C_MASTER_NUM         I2C_NUM_0 /* Núm. del periférico I2C */
-#define I2C_MASTER_FREQ_HZ     400000    /* Frecuencia I2C en Hz */
+#define I2C_MASTER_FREQ_HZ     400000    /* Frecuencia I2C de la pantalla en Hz (mínima) */
 #define OLED_ADDRESS           0x3C      /* Dirección I2C del módulo OLED */
-
-
-/* -----------------------------
- * Dimensiones de la pantalla OLED
- * Modelos pequeños como 0.42" pueden requerir offsets para centrar
- * el contenido en la memoria framebuffer del controlador.
- * ----------------------------- */
-#define SCREEN_WIDTH  72
-#define SCREEN_HEIGHT 40
-#define X_OFFSET      28
-#define Y_OFFSET      12
+#define OLED_I2C_TIMEOUT_MS    50        /* Timeout por transacción (cota de bloqueo del bus) */
+#define OLED_I2C_PRIORITY      I2C_BUS_PRIO_LOW  /* Cede el bus a los sensores */
+#define OLED_CMD_BATCH_MAX     32        /* Comandos por transacción */
+#define OLED_FAIL_MAX          3         /* Fallos seguidos para dar el panel por ausente */
+#define OLED_PROBE_MS          2000      /* Sondeo del panel ausente */
+#define OLED_RETRY_MS          20        /* Reintento de una trama fallida */
+
+/* Tarea que hace las transferencias a la pantalla */
+#define OLED_TASK_STACK        3072
+#define OLED_TASK_PRIORITY     3
+
+/* Ritmo de tramas (oled_pacer_start) */
+#define OLED_FPS_TARGET        10    /* Renders por segundo sin peticiones */
+#define OLED_FPS_MAX           25    /* Tope aunque lleguen peticiones */
+#define OLED_BUS_BUDGET_PCT    30    /* % máximo de tiempo de bus para la pantalla */
+#define OLED_BUS_BURST_MS      100   /* Crédito de bus acumulable, ms */
+#define OLED_PACER_TASK_STACK  3072
+#define OLED_PACER_TASK_PRIORITY 2   /* Por debajo de la tarea de pantalla */
 
 
 /* -----------------------------
  * Inicialización y configuración
  * ----------------------------- */
 /**
- * Inicializa el driver OLED y la interfaz I2C.
- * Debe llamarse antes de cualquier operación de dibujo.
+ * Envía la secuencia de inicialización del controlador y arranca la tarea
+ * de pantalla. Llamar después de i2c_master_init() y antes de
+ * cualquier oled_update().
  */
 void oled_init(void);
 
 /**
- * Inicializa el periférico I2C (configuración de pines y velocidad).
- * Se expone por si se quiere inicializar I2C de forma separada.
+ * Inicializa el bus I2C compartido (i2c_bus_init) y registra la pantalla
+ * en él. Se expone por si se quiere inicializar I2C de forma separada.
  */
 void i2c_master_init(void);
 
+/**
+ * Calibra la velocidad I2C de la pantalla (i2c_bus_calibrate con comandos
+ * NOP): sube desde I2C_MASTER_FREQ_HZ mientras todas las transacciones de
+ * prueba reciben ACK y guarda la más rápida estable en NVS, que se aplica
+ * en los siguientes arranques. Si en marcha aumentan los errores, el bus
+ * baja la velocidad solo. `hz` (puede ser NULL) recibe la elegida.
+ */
+esp_err_t oled_tune_bus(uint32_t *hz);
+
 
 /* -----------------------------
  * Control básico de pantalla
  * ----------------------------- */
 /**
- * Borra el framebuffer interno (no actualiza la pantalla hasta llamar a
- * oled_update()).
+ * Entrega el framebuffer a la tarea de pantalla y vuelve sin esperar al
+ * bus. La tarea transmite siempre la trama más reciente (las que no
+ * llegaron a salir se descartan) y solo la ventana (páginas x columnas)
+ * que cambió respecto a la última transmisión; sin cambios no hay
+ * tráfico I2C.
  */
-void oled_clear(void);
+void oled_update(void);
 
 /**
- * Envía el framebuffer al controlador OLED para actualizar la pantalla.
+ * Fuerza que la próxima oled_update() envíe el framebuffer completo
+ * (p.ej. si el panel se reinició y perdió su contenido).
  */
-void oled_update(void);
+void oled_invalidate(void);
+
+/** Contadores de oled_update() y de la tarea de pantalla */
+typedef struct {
+    uint32_t updates;      /* Llamadas a oled_update() */
+    uint32_t dropped;      /* Tramas sustituidas por otra antes de salir */
+    uint32_t skipped;      /* Sin cambios: no se transmitió nada */
+    uint32_t frames_sent;  /* Tramas (ventanas) transmitidas */
+    uint32_t bytes_sent;   /* Bytes de datos de imagen transmitidos */
+    uint32_t transactions; /* Transacciones I2C (comandos + datos) */
+    uint32_t bus_us;       /* Tiempo total en el bus, us */
+    uint32_t frame_us_last; /* Bus de la última trama (direccionamiento + datos) */
+    uint32_t frame_us_max;
+    uint32_t errors;       /* Transacciones fallidas */
+    uint32_t absent;       /* Veces que el panel se dio por ausente */
+} oled_stats_t;
+
+void oled_get_stats(oled_stats_t *stats);
 
 /**
- * Controla la alimentación del panel (0 = apagar, !=0 = encender).
+ * false si el panel no responde (OLED_FAIL_MAX fallos seguidos o sin
+ * respuesta al iniciar). Mientras tanto no se renderiza ni se transmite;
+ * la tarea lo sondea cada OLED_PROBE_MS y, al volver, lo reinicializa y
+ * envía la trama más reciente.
  */
-void oled_set_power(int on);
-
-
-/* -----------------------------
- * Primitivas de dibujo
- * (coordenadas en píxeles, origen en la esquina superior izquierda)
- * ----------------------------- */
-void oled_draw_pixel(int x, int y);
-void oled_draw_line(int x0, int y0, int x1, int y1);
-void oled_draw_rect(int x, int y, int w, int h);
-void oled_draw_fill_rect(int x, int y, int w, int h);
-
+bool oled_is_present(void);
 
-/* -----------------------------
- * Texto y utilidades de presentación
- * ----------------------------- */
 /**
- * Dibuja una cadena en la posición (x,y). Usa las fuentes definidas en
- * `fonts.h`.
+ * Envía `count` bytes de comandos SSD1306 (con sus parámetros) en una
+ * sola transacción I2C con un único byte de control, en lugar de una
+ * transacción por byte. Máximo OLED_CMD_BATCH_MAX.
+ *
+ * Uso directo solo para comandos que no alteran el direccionamiento
+ * (la tarea de pantalla programa COLUMNADDR/PAGEADDR en cada trama).
  */
-void oled_draw_text(int x, int y, const char *text);
+esp_err_t oled_write_commands(const uint8_t *cmds, size_t count);
 
 /**
- * Dibuja texto centrado por líneas lógicas (útil para menús simples).
- * `line` es un índice de línea (implementación decidirá altura por línea).
+ * Controla la alimentación del panel (0 = apagar, !=0 = encender). El
+ * comando lo envía la tarea de pantalla.
  */
-void oled_draw_text_centered(int line, const char *text);
+void oled_set_power(int on);
 
 
 /* -----------------------------
@@ -125,5 +160,57 @@ void oled_show_welcome_screen(void);
  */
 void oled_show_combined_status(bool button_pressed, const char *ip, const char *dht_status);
 
+/**
+ * Refresca la escena de widgets (ver oled_widgets.h, p.ej.
+ * oled_widgets_build_status()) y entrega la trama solo si algún widget
+ * cambió. Sustituye a oled_show_combined_status() en el bucle periódico.
+ */
+void oled_show_widgets(void);
+
+
+/* -----------------------------
+ * Ritmo de tramas
+ * ----------------------------- */
+/** Dibuja en el framebuffer; devuelve true si cambió (hay que enviarlo) */
+typedef bool (*oled_render_fn_t)(void *arg);
+
+/**
+ * Arranca la tarea que marca el ritmo de la pantalla: llama a `render`
+ * OLED_FPS_TARGET veces por segundo (o antes si hay oled_request_frame(),
+ * sin pasar de OLED_FPS_MAX) y entrega la trama solo si cambió. Si el
+ * bus usado por la pantalla supera OLED_BUS_BUDGET_PCT, aplaza el render
+ * hasta recuperar crédito. Con `render` NULL usa oled_widgets_refresh().
+ */
+esp_err_t oled_pacer_start(oled_render_fn_t render, void *arg);
+
+/** Pide un render cuanto antes (p.ej. tras un cambio de estado) */
+void oled_request_frame(void);
+
+/**
+ * Con el ritmo de tramas en marcha, el framebuffer y la escena de widgets
+ * son de su tarea. `pause` true espera a que acabe el render en curso y
+ * lo retiene para que la tarea que llama dibuje o entregue tramas por su
+ * cuenta (p.ej. los micro-benchmarks); false lo devuelve y pide un render
+ * para repintar la escena. Ambas llamadas desde la misma tarea. Sin
+ * oled_pacer_start() no hace nada.
+ */
+void oled_pacer_pause(bool pause);
+
+/** Métricas del ritmo de tramas */
+typedef struct {
+    uint32_t renders;        /* Llamadas a render */
+    uint32_t frames;         /* Renders con cambios, entregados a la tarea */
+    uint32_t idle;           /* Renders sin cambios (sin tráfico) */
+    uint32_t deferred;       /* Aplazados por presupuesto de bus */
+    uint32_t rate_limited;   /* Peticiones retrasadas por OLED_FPS_MAX */
+    uint32_t absent;         /* Ciclos sin render por panel ausente */
+    uint32_t render_us_last;
+    uint32_t render_us_max;
+    uint32_t fps;            /* Tramas entregadas en el último segundo */
+    uint32_t bus_pct;        /* % de tiempo de bus en el último segundo */
+} oled_frame_stats_t;
+
+void oled_get_frame_stats(oled_frame_stats_t *stats);
+
 
 #endif /* OLED_H */
\ No newline at end of file
@@ -0,0 +1,112 @@
+/**
+ * @file oled_gfx.h
+ * @brief Capa de dibujo de la OLED 72x40: framebuffer, primitivas, texto y
+ *        composición de pantallas.
+ *
+ * No depende de ESP-IDF ni de FreeRTOS: solo escribe en el framebuffer en
+ * memoria. La transferencia al panel es cosa de oled.h (oled_update()).
+ * Así puede compilarse también en el host (tools/oled_host) para generar
+ * imágenes de referencia y medir las primitivas.
+ *
+ * Formato del framebuffer (el de la GDDRAM del SSD1306): OLED_PAGES
+ * páginas de SCREEN_WIDTH bytes; cada byte es una columna de 8 filas con
+ * el bit 0 arriba.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#ifndef OLED_GFX_H
+#define OLED_GFX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* -----------------------------
+ * Dimensiones de la pantalla OLED
+ * Modelos pequeños como 0.42" pueden requerir offsets para centrar
+ * el contenido en la memoria framebuffer del controlador.
+ * ----------------------------- */
+#define SCREEN_WIDTH  72
+#define SCREEN_HEIGHT 40
+#define X_OFFSET      28
+#define Y_OFFSET      12
+
+#define OLED_PAGES       (SCREEN_HEIGHT / 8)
+#define OLED_FRAME_BYTES (SCREEN_WIDTH * OLED_PAGES)
+
+/* Tamaño de una imagen PBM binaria (P4) del framebuffer: cabecera
+ * "P4\n72 40\n" y filas de (SCREEN_WIDTH + 7) / 8 bytes */
+#define OLED_PBM_HEADER_BYTES 9
+#define OLED_PBM_BYTES (OLED_PBM_HEADER_BYTES + ((SCREEN_WIDTH + 7) / 8) * SCREEN_HEIGHT)
+
+
+/* -----------------------------
+ * Framebuffer
+ * ----------------------------- */
+/**
+ * Borra el framebuffer interno (no actualiza la pantalla hasta llamar a
+ * oled_update()).
+ */
+void oled_clear(void);
+
+/** Framebuffer actual (OLED_FRAME_BYTES bytes, formato de página) */
+const uint8_t *oled_get_buffer(void);
+
+/**
+ * Exporta el framebuffer como PBM binario (P4, 1 = píxel encendido).
+ * Devuelve los bytes escritos (OLED_PBM_BYTES) o 0 si `size` no basta.
+ */
+size_t oled_export_pbm(uint8_t *out, size_t size);
+
+
+/* -----------------------------
+ * Primitivas de dibujo
+ * (coordenadas en píxeles, origen en la esquina superior izquierda)
+ * ----------------------------- */
+void oled_draw_pixel(int x, int y);
+void oled_draw_line(int x0, int y0, int x1, int y1);
+
+/* Tramos horizontales / verticales de `w` / `h` píxeles (por páginas) */
+void oled_draw_hline(int x, int y, int w);
+void oled_draw_vline(int x, int y, int h);
+
+/* Contorno con esquinas (x, y) y (x + w, y + h), ambas incluidas */
+void oled_draw_rect(int x, int y, int w, int h);
+
+/* Operaciones sobre el área [x, x + w) x [y, y + h), por bytes y palabras */
+void oled_draw_fill_rect(int x, int y, int w, int h);
+void oled_invert_rect(int x, int y, int w, int h);   /* XOR */
+void oled_clear_rect(int x, int y, int w, int h);
+
+/* Copia el área de `src` (trama completa, mismo formato) al framebuffer */
+void oled_copy_rect(const uint8_t *src, int x, int y, int w, int h);
+
+
+/* -----------------------------
+ * Texto
+ * ----------------------------- */
+/**
+ * Dibuja una cadena en la posición (x,y). Usa las fuentes definidas en
+ * `fonts.h`.
+ */
+void oled_draw_text(int x, int y, const char *text);
+
+/**
+ * Dibuja texto centrado por líneas lógicas (útil para menús simples).
+ * `line` es un índice de línea (implementación decidirá altura por línea).
+ */
+void oled_draw_text_centered(int line, const char *text);
+
+
+/* -----------------------------
+ * Composición de pantallas (solo framebuffer, sin oled_update())
+ * ----------------------------- */
+void oled_render_splash_screen(void);
+void oled_render_welcome_screen(void);
+
+/** Contenido de oled_show_combined_status() con el estado del LED dado */
+void oled_render_combined_status(bool led_on, bool button_pressed, const char *ip, const char *dht_status);
+
+#endif /* OLED_GFX_H */
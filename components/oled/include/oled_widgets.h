@@ -0,0 +1,116 @@
+/**
+ * @file oled_widgets.h
+ * @brief Capa de widgets en modo retenido sobre oled_gfx.
+ *
+ * Una escena se compone una vez: etiquetas fijas (se pintan en una capa de
+ * fondo pre-renderizada) y widgets de valor (texto, indicador, barra)
+ * enlazados a una función que lee el valor actual. En cada refresco solo
+ * se redibujan los widgets cuyo valor cambió: se restaura su área desde
+ * el fondo y se pintan encima. Junto con la ventana sucia de
+ * oled_update(), una trama típica queda en unos pocos bytes de I2C.
+ *
+ * Las áreas de los widgets no deben solaparse entre sí. Si otro código
+ * dibuja en el framebuffer entre refrescos, el siguiente refresco lo
+ * detecta y repinta la escena completa.
+ *
+ * Como oled_gfx, es C estándar (se compila también en tools/oled_host).
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#ifndef OLED_WIDGETS_H
+#define OLED_WIDGETS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define OLED_WIDGETS_MAX      12   /* Widgets de valor por escena */
+#define OLED_WIDGET_TEXT_MAX  16   /* Texto de un campo, con el '\0' */
+
+/* Fuentes de valor: leen el estado actual (p.ej. led_control_get_state) */
+typedef int32_t (*oled_widget_int_fn)(void *arg);
+typedef void (*oled_widget_text_fn)(char *buf, size_t size, void *arg);
+
+/* -----------------------------
+ * Composición de la escena
+ * ----------------------------- */
+/**
+ * Empieza una escena nueva: descarta los widgets anteriores y borra el
+ * framebuffer para pintar las etiquetas fijas.
+ */
+void oled_widgets_begin(void);
+
+/* Etiquetas fijas: se pintan una vez y pasan a la capa de fondo */
+void oled_widget_label(int x, int y, const char *text);
+void oled_widget_label_centered(int line, const char *text);
+
+/**
+ * Campo de texto de hasta `max_chars` caracteres en (x, y). Con
+ * `line` >= 0 se centra en esa línea lógica (como
+ * oled_draw_text_centered) y ocupa todo el ancho; x e y se ignoran.
+ * Devuelve el índice del widget o -1 si no caben más.
+ */
+int oled_widget_text(int x, int y, int max_chars, int line, oled_widget_text_fn get, void *arg);
+
+/**
+ * Indicador cuadrado de lado `size`: relleno si el valor es distinto de
+ * 0, solo contorno si es 0.
+ */
+int oled_widget_box(int x, int y, int size, oled_widget_int_fn get, void *arg);
+
+/**
+ * Barra horizontal de w x h con contorno, rellena en proporción a
+ * (valor - min) / (max - min).
+ */
+int oled_widget_bar(int x, int y, int w, int h, int32_t min, int32_t max, oled_widget_int_fn get, void *arg);
+
+/**
+ * Cierra la escena: guarda el framebuffer (solo etiquetas) como capa de
+ * fondo. El primer refresco pinta todos los widgets.
+ */
+void oled_widgets_end(void);
+
+
+/* -----------------------------
+ * Refresco
+ * ----------------------------- */
+/**
+ * Lee el valor de cada widget y redibuja en el framebuffer los que
+ * cambiaron. Devuelve true si el framebuffer cambió (hay que llamar a
+ * oled_update()).
+ */
+bool oled_widgets_refresh(void);
+
+/** Fuerza que el próximo refresco repinte la escena completa */
+void oled_widgets_invalidate(void);
+
+typedef struct {
+    uint32_t refreshes;     /* Llamadas a oled_widgets_refresh() */
+    uint32_t full_redraws;  /* Escena completa (primera vez o framebuffer ajeno) */
+    uint32_t widgets_drawn; /* Widgets redibujados */
+} oled_widgets_stats_t;
+
+void oled_widgets_get_stats(oled_widgets_stats_t *stats);
+
+
+/* -----------------------------
+ * Escena de estado combinado
+ * ----------------------------- */
+/**
+ * Fuentes de la pantalla de estado (misma disposición que
+ * oled_render_combined_status). Todas reciben `arg`.
+ */
+typedef struct {
+    oled_widget_text_fn ip;
+    oled_widget_int_fn led_on;
+    oled_widget_int_fn button_pressed;
+    oled_widget_text_fn dht_status;
+    void *arg;
+} oled_status_bindings_t;
+
+/** Compone la escena de estado combinado enlazada a `bindings` */
+void oled_widgets_build_status(const oled_status_bindings_t *bindings);
+
+#endif /* OLED_WIDGETS_H */
@@ -1,8 +1,23 @@
 /*
  * oled.c
  *
- * Driver simple para una pantalla SSD1306 modificada a 72x40 (pequeños OLEDs)
- * Con soporte para primitivas de dibujo, texto y pantallas de estado.
+ * Driver simple para una pantalla SSD1306 modificada a 72x40 (pequeños OLEDs).
+ * El framebuffer, las primitivas de dibujo y el texto están en oled_gfx.c;
+ * aquí queda el transporte al panel y las pantallas de estado.
+ *
+ * Las transferencias I2C las hace una tarea propia (oled_task): quien
+ * dibuja entrega el framebuffer con oled_update() y sigue sin esperar al
+ * bus. El bus es del componente i2c_bus: la pantalla encola sus
+ * transacciones con prioridad baja, de modo que las de los sensores
+ * pasan por delante entre una y otra.
+ *
+ * Disyuntor: tras OLED_FAIL_MAX transacciones fallidas seguidas el panel
+ * se da por ausente. Mientras lo está no se renderiza ni se transmite
+ * nada; la tarea solo lo sondea cada OLED_PROBE_MS reenviando la
+ * secuencia de inicialización (pudo perder la alimentación) y, si
+ * responde, retoma con la trama más reciente completa. Un fallo aislado
+ * por debajo del umbral no pierde la trama: se reintenta al cabo de
+ * OLED_RETRY_MS salvo que llegue antes otra más nueva.
  */
 
 #include "oled.h"
@@ -10,13 +25,13 @@
 #include "led_control.h"
 
 #include <string.h>
-#include <stdlib.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "esp_system.h"
-#include "driver/i2c.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 static const char *TAG = "OLED";
 
@@ -41,52 +56,400 @@ static const char *TAG = "OLED";
 #define SSD1306_NORMALDISPLAY       0xA6
 #define SSD1306_COLUMNADDR          0x21
 #define SSD1306_PAGEADDR            0x22
+#define SSD1306_NOP                 0xE3
+
+
+#define OLED_CTRL_CMD    0x00   /* Byte de control: siguen comandos */
+#define OLED_CTRL_DATA   0x40   /* Byte de control: siguen datos GDDRAM */
+
+/* Doble buffer de tramas entregadas: oled_update() copia en
+ * oled_frames[oled_submit_idx] y la tarea se queda con esa trama
+ * intercambiando el índice; solo se transmite la más reciente */
+static uint8_t oled_frames[2][OLED_FRAME_BYTES];
+static uint8_t oled_submit_idx = 0;
+static bool oled_frame_pending = false;
+static int oled_power_req = -1;            /* -1 = sin petición */
+static bool oled_invalidate_req = false;
+static SemaphoreHandle_t oled_frame_mutex = NULL;
+static TaskHandle_t oled_task_handle = NULL;
+
+/* Solo los usa la tarea: copia de lo último transmitido (contenido de la
+ * GDDRAM) y tramo de una página tras el byte de control */
+static uint8_t oled_shadow[OLED_FRAME_BYTES];
+static uint8_t oled_tx[1 + SCREEN_WIDTH];
+static bool oled_shadow_valid = false;
+
+static oled_stats_t oled_stats;
+
+/* Ritmo de tramas */
+static TaskHandle_t oled_pacer_handle = NULL;
+static oled_render_fn_t oled_pacer_render = NULL;
+static void *oled_pacer_arg = NULL;
+static SemaphoreHandle_t oled_render_mutex = NULL;   /* Render + entrega, ver oled_pacer_pause() */
+static oled_frame_stats_t oled_frame_stats;
+
+static i2c_bus_device_t *oled_dev = NULL;
+
+/* Disyuntor de panel ausente */
+static volatile bool oled_absent = false;
+static uint8_t oled_failures = 0;          /* Transacciones fallidas seguidas */
+static bool oled_power_on = true;          /* Último estado pedido */
+
+/* Secuencia de inicialización mínima para SSD1306, en una transacción */
+static const uint8_t oled_init_seq[] = {
+    SSD1306_DISPLAYOFF,
+    SSD1306_SETDISPLAYCLOCKDIV, 0x80,
+    SSD1306_SETMULTIPLEX, 0x27,         /* 39 = 0x27 (40-1) */
+    SSD1306_SETDISPLAYOFFSET, 0x00,
+    SSD1306_SETSTARTLINE | 0x00,
+    SSD1306_CHARGEPUMP, 0x14,
+    SSD1306_MEMORYMODE, 0x00,
+    SSD1306_SEGREMAP | 0x01,
+    SSD1306_COMSCANDEC,
+    SSD1306_SETCOMPINS, 0x12,
+    SSD1306_SETCONTRAST, 0xCF,
+    SSD1306_SETPRECHARGE, 0xF1,
+    SSD1306_SETVCOMDETECT, 0x40,
+    SSD1306_DISPLAYALLON_RESUME,
+    SSD1306_NORMALDISPLAY,
+    SSD1306_DISPLAYON,
+};
 
 
-/* Buffer para la pantalla (WIDTH x PAGES), páginas = height/8 */
-static uint8_t oled_buffer[SCREEN_WIDTH * (SCREEN_HEIGHT / 8)];
+/* Funciones privadas I2C -------------------------------------------------- */
 
+/*
+ * oled_stats y el disyuntor los tocan la tarea de pantalla, la de ritmo
+ * y quien use la API (benchmarks, calibración): van bajo
+ * oled_frame_mutex. Antes de oled_init() aún no existe y solo hay una
+ * tarea.
+ */
+static void oled_stats_lock(void)
+{
+    if (oled_frame_mutex != NULL) {
+        xSemaphoreTake(oled_frame_mutex, portMAX_DELAY);
+    }
+}
 
-/* Funciones privadas I2C -------------------------------------------------- */
-static void oled_write_cmd(uint8_t cmd)
+static void oled_stats_unlock(void)
 {
-    i2c_cmd_handle_t cmd_handle = i2c_cmd_link_create();
-    i2c_master_start(cmd_handle);
-    i2c_master_write_byte(cmd_handle, (OLED_ADDRESS << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd_handle, 0x00, true); /* comando */
-    i2c_master_write_byte(cmd_handle, cmd, true);
-    i2c_master_stop(cmd_handle);
-    i2c_master_cmd_begin(I2C_MASTER_NUM, cmd_handle, 1000 / portTICK_PERIOD_MS);
-    i2c_cmd_link_delete(cmd_handle);
+    if (oled_frame_mutex != NULL) {
+        xSemaphoreGive(oled_frame_mutex);
+    }
 }
 
-static void oled_write_data(uint8_t *data, size_t len)
+static void oled_set_absent(void)
 {
-    i2c_cmd_handle_t cmd_handle = i2c_cmd_link_create();
-    i2c_master_start(cmd_handle);
-    i2c_master_write_byte(cmd_handle, (OLED_ADDRESS << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd_handle, 0x40, true); /* datos */
-    i2c_master_write(cmd_handle, data, len, true);
-    i2c_master_stop(cmd_handle);
-    i2c_master_cmd_begin(I2C_MASTER_NUM, cmd_handle, 1000 / portTICK_PERIOD_MS);
-    i2c_cmd_link_delete(cmd_handle);
+    oled_stats_lock();
+    bool first = !oled_absent;
+    if (first) {
+        oled_absent = true;
+        oled_stats.absent++;
+    }
+    oled_stats_unlock();
+
+    if (first) {
+        /* Sus NACK no son problema de velocidad del bus */
+        i2c_bus_set_absent(oled_dev, true);
+        ESP_LOGW(TAG, "La pantalla no responde: se suspende hasta que vuelva");
+        /* Puede dispararse desde otra tarea (bancos de prueba): despertar
+         * a la de la pantalla para que pase a sondear */
+        if (oled_task_handle != NULL) {
+            xTaskNotifyGive(oled_task_handle);
+        }
+    }
 }
 
+/*
+ * Una transacción: START, dirección, `buf` (byte de control + carga),
+ * STOP. Si `bus_us` no es NULL, le suma el tiempo de bus que ocupó.
+ */
+static esp_err_t oled_i2c_write(const uint8_t *buf, size_t len, uint32_t *bus_us)
+{
+    if (oled_dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    /* Solo el tiempo de bus de esta transacción: ni la espera tras otros
+     * dispositivos ni las de otras tareas con la pantalla */
+    uint32_t tx_us = 0;
+    esp_err_t ret = i2c_bus_transfer_timed(oled_dev, OLED_I2C_PRIORITY, buf, len, NULL, 0, &tx_us);
+    if (bus_us) {
+        *bus_us += tx_us;
+    }
 
-/* Inicialización I2C pública (puede llamarse por separado) */
+    bool absent = false;
+    oled_stats_lock();
+    oled_stats.transactions++;
+    oled_stats.bus_us += tx_us;
+    if (ret == ESP_OK) {
+        oled_failures = 0;
+    } else {
+        oled_stats.errors++;
+        absent = (++oled_failures >= OLED_FAIL_MAX);
+    }
+    oled_stats_unlock();
+
+    if (absent) {
+        oled_set_absent();
+    }
+    return ret;
+}
+
+/* Comandos en una transacción; suma su tiempo de bus a `bus_us` (o NULL) */
+static esp_err_t oled_send_commands(const uint8_t *cmds, size_t count, uint32_t *bus_us)
+{
+    uint8_t buf[1 + OLED_CMD_BATCH_MAX];
+
+    if (cmds == NULL || count == 0 || count > OLED_CMD_BATCH_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    /* Un solo byte de control (Co = 0): todo lo que sigue son comandos */
+    buf[0] = OLED_CTRL_CMD;
+    memcpy(&buf[1], cmds, count);
+    return oled_i2c_write(buf, count + 1, bus_us);
+}
+
+static esp_err_t oled_write_cmd(uint8_t cmd)
+{
+    return oled_send_commands(&cmd, 1, NULL);
+}
+
+esp_err_t oled_write_commands(const uint8_t *cmds, size_t count)
+{
+    return oled_send_commands(cmds, count, NULL);
+}
+
+
+/* Inicialización I2C pública: bus compartido y registro de la pantalla */
 void i2c_master_init(void)
 {
-    i2c_config_t conf = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = I2C_MASTER_SDA_IO,
-        .scl_io_num = I2C_MASTER_SCL_IO,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = I2C_MASTER_FREQ_HZ,
+    if (oled_dev != NULL) {
+        return;
+    }
+
+    const i2c_bus_device_config_t dev_cfg = {
+        .name = "oled",
+        .address = OLED_ADDRESS,
+        .scl_speed_hz = I2C_MASTER_FREQ_HZ,
+        .timeout_ms = OLED_I2C_TIMEOUT_MS,
     };
+    esp_err_t ret = i2c_bus_init();
+    if (ret == ESP_OK) {
+        ret = i2c_bus_add_device(&dev_cfg, &oled_dev);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error inicializando I2C: %s", esp_err_to_name(ret));
+    }
+}
+
+
+/* Calibración de la velocidad del bus: ráfagas de NOP, que no alteran el
+ * estado del controlador, con la longitud de un tramo de datos típico */
+esp_err_t oled_tune_bus(uint32_t *hz)
+{
+    uint8_t probe[1 + OLED_CMD_BATCH_MAX];
+
+    if (oled_dev == NULL || oled_absent) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    probe[0] = OLED_CTRL_CMD;
+    memset(&probe[1], SSD1306_NOP, OLED_CMD_BATCH_MAX);
+
+    esp_err_t ret = i2c_bus_calibrate(oled_dev, probe, sizeof(probe), hz);
+    /* Si algún paso falló a mitad de una trama, la GDDRAM puede no
+     * coincidir con la copia: la siguiente trama va completa */
+    oled_invalidate();
+    return ret;
+}
+
+
+/* Tarea de pantalla ------------------------------------------------------- */
+
+/*
+ * Compara la trama con la copia de lo último transmitido y calcula la
+ * ventana (páginas y columnas) que contiene todos los cambios.
+ * Devuelve false si no hay cambios.
+ */
+static bool oled_dirty_window(const uint8_t *frame, int *page0, int *page1, int *col0, int *col1)
+{
+    int p0 = OLED_PAGES, p1 = -1, c0 = SCREEN_WIDTH, c1 = -1;
+
+    for (int page = 0; page < OLED_PAGES; page++) {
+        const uint8_t *cur = &frame[page * SCREEN_WIDTH];
+        const uint8_t *old = &oled_shadow[page * SCREEN_WIDTH];
+        if (memcmp(cur, old, SCREEN_WIDTH) == 0) {
+            continue;
+        }
+        int first = 0, last = SCREEN_WIDTH - 1;
+        while (cur[first] == old[first]) {
+            first++;
+        }
+        while (cur[last] == old[last]) {
+            last--;
+        }
+        if (p0 > page) {
+            p0 = page;
+        }
+        p1 = page;
+        if (c0 > first) {
+            c0 = first;
+        }
+        if (c1 < last) {
+            c1 = last;
+        }
+    }
+
+    *page0 = p0;
+    *page1 = p1;
+    *col0 = c0;
+    *col1 = c1;
+    return p1 >= 0;
+}
+
+/*
+ * Transmite la ventana modificada de `frame` (o nada si no cambió).
+ * Devuelve false si una transacción falló y la trama no llegó entera.
+ */
+static bool oled_transmit(const uint8_t *frame)
+{
+    int page0 = 0, page1 = OLED_PAGES - 1, col0 = 0, col1 = SCREEN_WIDTH - 1;
+
+    if (oled_shadow_valid && !oled_dirty_window(frame, &page0, &page1, &col0, &col1)) {
+        oled_stats_lock();
+        oled_stats.skipped++;
+        oled_stats_unlock();
+        return true;
+    }
+
+    uint32_t bus_us = 0;   /* Bus de esta trama (direccionamiento + datos) */
+
+    const uint8_t addressing[] = {
+        SSD1306_COLUMNADDR, X_OFFSET + col0, X_OFFSET + col1,
+        SSD1306_PAGEADDR, page0, page1,
+    };
+    if (oled_send_commands(addressing, sizeof(addressing), &bus_us) != ESP_OK) {
+        /* Contenido de la GDDRAM incierto: reenviar completo la próxima vez */
+        oled_shadow_valid = false;
+        return false;
+    }
+
+    /* Una transacción por página de la ventana: en modo horizontal el
+     * controlador sigue en la columna siguiente aunque cambie la
+     * transacción, y entre páginas el bus puede atender a otro
+     * dispositivo más prioritario */
+    int width = col1 - col0 + 1;
+    size_t bytes = 0;
+    oled_tx[0] = OLED_CTRL_DATA;
+    for (int page = page0; page <= page1; page++) {
+        memcpy(&oled_tx[1], &frame[page * SCREEN_WIDTH + col0], width);
+        if (oled_i2c_write(oled_tx, width + 1, &bus_us) != ESP_OK) {
+            oled_shadow_valid = false;
+            return false;
+        }
+        bytes += width;
+    }
+
+    memcpy(oled_shadow, frame, sizeof(oled_shadow));
+    oled_shadow_valid = true;
+
+    oled_stats_lock();
+    oled_stats.frames_sent++;
+    oled_stats.bytes_sent += bytes;
+    oled_stats.frame_us_last = bus_us;
+    if (oled_stats.frame_us_max < bus_us) {
+        oled_stats.frame_us_max = bus_us;
+    }
+    oled_stats_unlock();
+    return true;
+}
 
-    i2c_param_config(I2C_MASTER_NUM, &conf);
-    i2c_driver_install(I2C_MASTER_NUM, conf.mode, 0, 0, 0);
+/*
+ * Sondeo del panel ausente: reenvía la inicialización (y el apagado si se
+ * había pedido). Devuelve true si respondió; su GDDRAM queda incierta.
+ */
+static bool oled_probe(void)
+{
+    if (oled_write_commands(oled_init_seq, sizeof(oled_init_seq)) != ESP_OK) {
+        return false;
+    }
+    if (!oled_power_on && oled_write_cmd(SSD1306_DISPLAYOFF) != ESP_OK) {
+        return false;
+    }
+    oled_stats_lock();
+    oled_absent = false;
+    oled_failures = 0;
+    oled_stats_unlock();
+    i2c_bus_set_absent(oled_dev, false);
+    oled_shadow_valid = false;
+    ESP_LOGI(TAG, "La pantalla responde de nuevo");
+    return true;
+}
+
+static void oled_task(void *arg)
+{
+    int64_t next_probe = 0;
+    int last_idx = -1;   /* Última trama tomada: se reenvía al volver el panel */
+    bool retry = false;  /* La última transmisión falló sin disparar el disyuntor */
+
+    for (;;) {
+        /* Con el panel ausente solo se despierta para sondearlo; las
+         * peticiones quedan pendientes hasta que vuelva. Tras un fallo
+         * aislado reintenta la misma trama al cabo de OLED_RETRY_MS */
+        TickType_t wait = portMAX_DELAY;
+        if (oled_absent) {
+            wait = pdMS_TO_TICKS(OLED_PROBE_MS);
+        } else if (retry) {
+            wait = pdMS_TO_TICKS(OLED_RETRY_MS);
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        bool resend = false;
+        if (oled_absent) {
+            int64_t now = esp_timer_get_time();
+            if (now < next_probe) {
+                continue;
+            }
+            next_probe = now + (int64_t)OLED_PROBE_MS * 1000;
+            if (!oled_probe()) {
+                continue;
+            }
+            resend = true;
+        }
+
+        xSemaphoreTake(oled_frame_mutex, portMAX_DELAY);
+        int power = oled_power_req;
+        oled_power_req = -1;
+        if (oled_invalidate_req) {
+            oled_shadow_valid = false;
+            oled_invalidate_req = false;
+        }
+        bool pending = oled_frame_pending;
+        uint8_t idx = oled_submit_idx;
+        if (pending) {
+            /* La trama entregada pasa a ser de la tarea; las siguientes
+             * entregas van al otro buffer */
+            oled_submit_idx ^= 1;
+            oled_frame_pending = false;
+        }
+        xSemaphoreGive(oled_frame_mutex);
+
+        if (power >= 0) {
+            oled_power_on = power;
+            oled_write_cmd(power ? SSD1306_DISPLAYON : SSD1306_DISPLAYOFF);
+        }
+        /* La trama tomada no se sobrescribe hasta la siguiente entrega */
+        if (pending) {
+            last_idx = idx;
+        } else if ((resend || retry) && last_idx >= 0) {
+            idx = last_idx;
+            pending = true;
+        }
+        if (pending && !oled_absent) {
+            /* Con el disyuntor disparado el reenvío queda para el sondeo */
+            retry = !oled_transmit(oled_frames[idx]) && !oled_absent;
+        }
+    }
 }
 
 
@@ -95,204 +458,277 @@ void oled_init(void)
 {
     vTaskDelay(100 / portTICK_PERIOD_MS);
 
-    /* Secuencia de inicialización mínima para SSD1306 */
-    oled_write_cmd(SSD1306_DISPLAYOFF);
-    oled_write_cmd(SSD1306_SETDISPLAYCLOCKDIV);
-    oled_write_cmd(0x80);
-    oled_write_cmd(SSD1306_SETMULTIPLEX);
-    oled_write_cmd(0x27); /* 39 = 0x27 (40-1) */
-    oled_write_cmd(SSD1306_SETDISPLAYOFFSET);
-    oled_write_cmd(0x00);
-    oled_write_cmd(SSD1306_SETSTARTLINE | 0x00);
-    oled_write_cmd(SSD1306_CHARGEPUMP);
-    oled_write_cmd(0x14);
-    oled_write_cmd(SSD1306_MEMORYMODE);
-    oled_write_cmd(0x00);
-    oled_write_cmd(SSD1306_SEGREMAP | 0x01);
-    oled_write_cmd(SSD1306_COMSCANDEC);
-    oled_write_cmd(SSD1306_SETCOMPINS);
-    oled_write_cmd(0x12);
-    oled_write_cmd(SSD1306_SETCONTRAST);
-    oled_write_cmd(0xCF);
-    oled_write_cmd(SSD1306_SETPRECHARGE);
-    oled_write_cmd(0xF1);
-    oled_write_cmd(SSD1306_SETVCOMDETECT);
-    oled_write_cmd(0x40);
-    oled_write_cmd(SSD1306_DISPLAYALLON_RESUME);
-    oled_write_cmd(SSD1306_NORMALDISPLAY);
-    oled_write_cmd(SSD1306_DISPLAYON);
+    uint32_t bus_us = 0;
+    if (oled_send_commands(oled_init_seq, sizeof(oled_init_seq), &bus_us) != ESP_OK) {
+        /* Sin panel al arrancar: la tarea lo sondeará */
+        ESP_LOGE(TAG, "Error enviando la secuencia de inicialización");
+        oled_set_absent();
+    }
+    ESP_LOGI(TAG, "Inicialización: %u comandos en 1 transacción, %lu us de bus",
+             (unsigned)sizeof(oled_init_seq), (unsigned long)bus_us);
+
+    /* La GDDRAM tiene contenido indeterminado: la primera actualización es completa */
+    oled_shadow_valid = false;
+
+    if (oled_task_handle == NULL) {
+        oled_frame_mutex = xSemaphoreCreateMutex();
+        if (oled_frame_mutex == NULL ||
+            xTaskCreate(oled_task, "oled_task", OLED_TASK_STACK, NULL, OLED_TASK_PRIORITY,
+                        &oled_task_handle) != pdPASS) {
+            ESP_LOGE(TAG, "No se pudo crear la tarea de pantalla");
+            return;
+        }
+    }
 
     ESP_LOGI(TAG, "OLED 72x40 inicializado");
 }
 
 
 /* Control básico ---------------------------------------------------------- */
-void oled_clear(void)
+void oled_update(void)
 {
-    memset(oled_buffer, 0, sizeof(oled_buffer));
+    if (oled_task_handle == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(oled_frame_mutex, portMAX_DELAY);
+    if (oled_frame_pending) {
+        oled_stats.dropped++;   /* La anterior aún no salió: se sustituye */
+    }
+    memcpy(oled_frames[oled_submit_idx], oled_get_buffer(), OLED_FRAME_BYTES);
+    oled_frame_pending = true;
+    oled_stats.updates++;
+    xSemaphoreGive(oled_frame_mutex);
+
+    /* Panel ausente: la trama queda pendiente para cuando vuelva */
+    if (!oled_absent) {
+        xTaskNotifyGive(oled_task_handle);
+    }
 }
 
-void oled_update(void)
+bool oled_is_present(void)
 {
-    oled_write_cmd(SSD1306_COLUMNADDR);
-    oled_write_cmd(X_OFFSET);
-    oled_write_cmd(X_OFFSET + SCREEN_WIDTH - 1);
-    oled_write_cmd(SSD1306_PAGEADDR);
-    oled_write_cmd(0);
-    oled_write_cmd((SCREEN_HEIGHT / 8) - 1);
-    oled_write_data(oled_buffer, sizeof(oled_buffer));
+    return !oled_absent;
 }
 
-void oled_set_power(int on)
+void oled_invalidate(void)
 {
-    oled_write_cmd(on ? SSD1306_DISPLAYON : SSD1306_DISPLAYOFF);
+    if (oled_frame_mutex == NULL) {
+        oled_shadow_valid = false;
+        return;
+    }
+    xSemaphoreTake(oled_frame_mutex, portMAX_DELAY);
+    oled_invalidate_req = true;
+    xSemaphoreGive(oled_frame_mutex);
 }
 
+void oled_get_stats(oled_stats_t *stats)
+{
+    oled_stats_lock();
+    *stats = oled_stats;
+    oled_stats_unlock();
+}
 
-/* Primitivas de dibujo ---------------------------------------------------- */
-void oled_draw_pixel(int x, int y)
+void oled_set_power(int on)
 {
-    if (x < 0 || x >= SCREEN_WIDTH || y < 0 || y >= SCREEN_HEIGHT) {
+    if (oled_task_handle == NULL) {
+        oled_power_on = on;
+        oled_write_cmd(on ? SSD1306_DISPLAYON : SSD1306_DISPLAYOFF);
         return;
     }
-
-    int page = y / 8;
-    int bit = y % 8;
-    oled_buffer[x + page * SCREEN_WIDTH] |= (1 << bit);
+    xSemaphoreTake(oled_frame_mutex, portMAX_DELAY);
+    oled_power_req = on ? 1 : 0;
+    xSemaphoreGive(oled_frame_mutex);
+    xTaskNotifyGive(oled_task_handle);
 }
 
-void oled_draw_line(int x0, int y0, int x1, int y1)
+
+/* Ritmo de tramas --------------------------------------------------------- */
+static bool oled_render_widgets(void *arg)
 {
-    int dx = abs(x1 - x0);
-    int dy = abs(y1 - y0);
-    int sx = (x0 < x1) ? 1 : -1;
-    int sy = (y0 < y1) ? 1 : -1;
-    int err = dx - dy;
-
-    while (1) {
-        oled_draw_pixel(x0, y0);
-        if (x0 == x1 && y0 == y1) {
-            break;
-        }
-        int e2 = 2 * err;
-        if (e2 > -dy) {
-            err -= dy;
-            x0 += sx;
-        }
-        if (e2 < dx) {
-            err += dx;
-            y0 += sy;
-        }
-    }
+    return oled_widgets_refresh();
 }
 
-void oled_draw_rect(int x, int y, int w, int h)
+/* Tiempo de bus acumulado y coste de la última trama, tomados juntos */
+static void oled_pacer_read_bus(uint32_t *bus_us, uint32_t *frame_us_last)
 {
-    oled_draw_line(x, y, x + w, y);
-    oled_draw_line(x + w, y, x + w, y + h);
-    oled_draw_line(x + w, y + h, x, y + h);
-    oled_draw_line(x, y + h, x, y);
+    oled_stats_lock();
+    *bus_us = oled_stats.bus_us;
+    *frame_us_last = oled_stats.frame_us_last;
+    oled_stats_unlock();
 }
 
-void oled_draw_fill_rect(int x, int y, int w, int h)
+/*
+ * Presupuesto de bus como cubo de crédito: gana OLED_BUS_BUDGET_PCT % del
+ * tiempo transcurrido (hasta OLED_BUS_BURST_MS) y pierde el tiempo de bus
+ * que midió la tarea de pantalla. Solo se renderiza si el crédito cubre
+ * lo que costó la última trama; si una trama sale más cara, se paga con
+ * el crédito de las siguientes y la media no pasa del presupuesto.
+ */
+static void oled_pacer_task(void *arg)
 {
-    for (int i = x; i < x + w; i++) {
-        for (int j = y; j < y + h; j++) {
-            oled_draw_pixel(i, j);
+    const int64_t min_period_us = 1000000 / OLED_FPS_MAX;
+    const TickType_t period = pdMS_TO_TICKS(1000 / OLED_FPS_TARGET);
+    const int64_t burst_us = (int64_t)OLED_BUS_BURST_MS * 1000;
+
+    int64_t credit_us = burst_us;
+    int64_t last_tick = esp_timer_get_time();
+    int64_t last_frame = last_tick - min_period_us;
+    uint32_t last_bus = 0;
+    uint32_t frame_us_last = 0;
+    oled_pacer_read_bus(&last_bus, &frame_us_last);
+
+    /* Métricas propias; se publican una vez por ciclo (oled_get_frame_stats) */
+    oled_frame_stats_t fs = { 0 };
+
+    int64_t window_start = last_tick;
+    uint32_t window_bus = last_bus;
+    uint32_t window_frames = 0;
+
+    for (;;) {
+        oled_stats_lock();
+        oled_frame_stats = fs;
+        oled_stats_unlock();
+
+        bool requested = ulTaskNotifyTake(pdTRUE, period) > 0;
+
+        /* Tope de FPS: una petición no adelanta más allá del periodo mínimo */
+        int64_t wait_us = last_frame + min_period_us - esp_timer_get_time();
+        if (wait_us > 0) {
+            if (requested) {
+                fs.rate_limited++;
+            }
+            vTaskDelay(pdMS_TO_TICKS((wait_us + 999) / 1000) + 1);
         }
-    }
-}
 
+        int64_t now = esp_timer_get_time();
+        uint32_t bus;
+        oled_pacer_read_bus(&bus, &frame_us_last);
+        credit_us += (now - last_tick) * OLED_BUS_BUDGET_PCT / 100 - (int64_t)(bus - last_bus);
+        if (credit_us > burst_us) {
+            credit_us = burst_us;
+        }
+        last_tick = now;
+        last_bus = bus;
+
+        if (now - window_start >= 1000000) {
+            fs.bus_pct = (uint32_t)((int64_t)(bus - window_bus) * 100 / (now - window_start));
+            fs.fps = window_frames;
+            window_start = now;
+            window_bus = bus;
+            window_frames = 0;
+        }
 
-/* Texto ------------------------------------------------------------------- */
-void oled_draw_text(int x, int y, const char *text)
-{
-    const uint8_t (*font)[5] = font_5x7;
+        /* Panel ausente: ni se renderiza; al volver, el primer render
+         * recoge todo lo que cambió mientras tanto */
+        if (oled_absent) {
+            fs.absent++;
+            continue;
+        }
 
-    for (int i = 0; text[i] != '\0'; i++) {
-        char c = text[i];
-        if (c < 32 || c > 126) {
+        if (credit_us < (int64_t)frame_us_last) {
+            fs.deferred++;
             continue;
         }
 
-        int char_x = x + i * 6; /* 5px ancho + 1px espacio */
-        if (char_x >= SCREEN_WIDTH) {
-            break;
+        /* Framebuffer y escena son de esta tarea salvo con oled_pacer_pause() */
+        xSemaphoreTake(oled_render_mutex, portMAX_DELAY);
+        int64_t render_start = esp_timer_get_time();
+        bool changed = oled_pacer_render(oled_pacer_arg);
+        uint32_t render_us = (uint32_t)(esp_timer_get_time() - render_start);
+        if (changed) {
+            oled_update();
         }
+        xSemaphoreGive(oled_render_mutex);
 
-        const uint8_t *char_data = font[c - 32];
+        fs.renders++;
+        fs.render_us_last = render_us;
+        if (fs.render_us_max < render_us) {
+            fs.render_us_max = render_us;
+        }
 
-        for (int col = 0; col < 5; col++) {
-            uint8_t col_data = char_data[col];
-            for (int row = 0; row < 7; row++) {
-                if (col_data & (1 << row)) {
-                    oled_draw_pixel(char_x + col, y + row);
-                }
-            }
+        if (!changed) {
+            fs.idle++;
+            continue;
         }
+        fs.frames++;
+        window_frames++;
+        last_frame = now;
+    }
+}
+
+esp_err_t oled_pacer_start(oled_render_fn_t render, void *arg)
+{
+    if (oled_pacer_handle != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    oled_pacer_render = render ? render : oled_render_widgets;
+    oled_pacer_arg = arg;
+    oled_render_mutex = xSemaphoreCreateMutex();
+    if (oled_render_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(oled_pacer_task, "oled_pacer", OLED_PACER_TASK_STACK, NULL,
+                    OLED_PACER_TASK_PRIORITY, &oled_pacer_handle) != pdPASS) {
+        ESP_LOGE(TAG, "No se pudo crear la tarea de ritmo de tramas");
+        return ESP_ERR_NO_MEM;
     }
+    ESP_LOGI(TAG, "Ritmo de tramas: %d FPS (máx %d), bus <= %d%%",
+             OLED_FPS_TARGET, OLED_FPS_MAX, OLED_BUS_BUDGET_PCT);
+    return ESP_OK;
 }
 
-void oled_draw_text_centered(int line, const char *text)
+void oled_request_frame(void)
 {
-    int text_width = strlen(text) * 6;
-    int x = (SCREEN_WIDTH - text_width) / 2;
-    int y = line * 10;
+    if (oled_pacer_handle != NULL) {
+        xTaskNotifyGive(oled_pacer_handle);
+    }
+}
 
-    if (x < 0) {
-        x = 0;
+void oled_pacer_pause(bool pause)
+{
+    if (oled_render_mutex == NULL) {
+        return;
     }
-    oled_draw_text(x, y, text);
+    if (pause) {
+        xSemaphoreTake(oled_render_mutex, portMAX_DELAY);
+        return;
+    }
+    xSemaphoreGive(oled_render_mutex);
+    /* Lo dibujado entretanto no es de la escena: se repinta ya */
+    xTaskNotifyGive(oled_pacer_handle);
 }
 
+void oled_get_frame_stats(oled_frame_stats_t *stats)
+{
+    oled_stats_lock();
+    *stats = oled_frame_stats;
+    oled_stats_unlock();
+}
 
 /* Pantallas / utilidades -------------------------------------------------- */
 void oled_show_combined_status(bool button_pressed, const char *ip, const char *dht_status)
 {
-    /* dht_status y ip son mostrados tal cual; se asume cadenas cortas. */
-    oled_clear();
-
-    /* Cabecera con IP (si existe) */
-    oled_draw_text_centered(0, ip);
-
-    /* Estado LED */
-    bool led_state = led_control_get_state();
-    oled_draw_text(0, 10, "LED:");
-    oled_draw_text(30, 10, led_state ? "ON " : "OFF");
-    if (led_state) {
-        oled_draw_fill_rect(50, 9, 8, 8);
-    } else {
-        oled_draw_rect(50, 9, 8, 8);
-    }
+    oled_render_combined_status(led_control_get_state(), button_pressed, ip, dht_status);
+    oled_update();
+}
 
-    /* Estado botón */
-    oled_draw_text(0, 20, "BOTON:");
-    oled_draw_text(36, 20, button_pressed ? "PRESS" : "FREE");
-    if (button_pressed) {
-        oled_draw_fill_rect(75, 19, 4, 4);
-    } else {
-        oled_draw_rect(75, 19, 4, 4);
+void oled_show_widgets(void)
+{
+    if (oled_widgets_refresh()) {
+        oled_update();
     }
-
-    oled_draw_text_centered(3, dht_status);
-    oled_update();
 }
 
 void oled_show_welcome_screen(void)
 {
-    oled_clear();
-    oled_draw_text_centered(0, "SISTEMA");
-    oled_draw_text_centered(1, "LED + WS");
-    oled_draw_text_centered(2, "ESP32-C3");
-    oled_draw_text_centered(3, "Listo!");
+    oled_render_welcome_screen();
     oled_update();
 }
 
 void oled_show_splash_screen(void)
 {
-    oled_clear();
-    oled_draw_text_centered(0, "INICIANDO");
-    oled_draw_text_centered(2, "SISTEMA");
+    oled_render_splash_screen();
     oled_update();
     vTaskDelay(2000 / portTICK_PERIOD_MS);
-}
\ No newline at end of file
+}
@@ -0,0 +1,360 @@
+/**
+ * @file oled_gfx.c
+ * @brief Framebuffer de la OLED 72x40, primitivas de dibujo, texto y
+ *        composición de pantallas.
+ *
+ * Solo C estándar: se compila igual en el firmware que en el host
+ * (tools/oled_host), de modo que las imágenes de referencia y las medidas
+ * de las primitivas salen del mismo código que corre en el ESP32-C3.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#include "oled_gfx.h"
+#include "fonts.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+/* Buffer para la pantalla (WIDTH x PAGES), páginas = height/8. Alineado a
+ * 4 para que las primitivas de relleno trabajen por palabras */
+static uint8_t oled_buffer[OLED_FRAME_BYTES] __attribute__((aligned(4)));
+
+
+/* Framebuffer ------------------------------------------------------------- */
+void oled_clear(void)
+{
+    memset(oled_buffer, 0, sizeof(oled_buffer));
+}
+
+const uint8_t *oled_get_buffer(void)
+{
+    return oled_buffer;
+}
+
+#define OLED_STR_(x) #x
+#define OLED_STR(x)  OLED_STR_(x)
+
+/* PBM P4: filas de arriba abajo, bit más significativo = píxel izquierdo */
+size_t oled_export_pbm(uint8_t *out, size_t size)
+{
+    static const char header[] = "P4\n" OLED_STR(SCREEN_WIDTH) " " OLED_STR(SCREEN_HEIGHT) "\n";
+    _Static_assert(sizeof(header) - 1 == OLED_PBM_HEADER_BYTES, "Cabecera PBM: revisar OLED_PBM_HEADER_BYTES");
+    const int row_bytes = (SCREEN_WIDTH + 7) / 8;
+
+    if (out == NULL || size < OLED_PBM_BYTES) {
+        return 0;
+    }
+
+    memcpy(out, header, OLED_PBM_HEADER_BYTES);
+    uint8_t *dst = out + OLED_PBM_HEADER_BYTES;
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        const uint8_t *page = &oled_buffer[(y / 8) * SCREEN_WIDTH];
+        uint8_t bit = (uint8_t)(1u << (y % 8));
+        memset(dst, 0, row_bytes);
+        for (int x = 0; x < SCREEN_WIDTH; x++) {
+            if (page[x] & bit) {
+                dst[x / 8] |= (uint8_t)(0x80u >> (x % 8));
+            }
+        }
+        dst += row_bytes;
+    }
+    return OLED_PBM_BYTES;
+}
+
+
+/* Primitivas de dibujo ---------------------------------------------------- */
+void oled_draw_pixel(int x, int y)
+{
+    if (x < 0 || x >= SCREEN_WIDTH || y < 0 || y >= SCREEN_HEIGHT) {
+        return;
+    }
+
+    int page = y / 8;
+    int bit = y % 8;
+    oled_buffer[x + page * SCREEN_WIDTH] |= (1 << bit);
+}
+
+void oled_draw_line(int x0, int y0, int x1, int y1)
+{
+    int dx = abs(x1 - x0);
+    int dy = abs(y1 - y0);
+    int sx = (x0 < x1) ? 1 : -1;
+    int sy = (y0 < y1) ? 1 : -1;
+    int err = dx - dy;
+
+    while (1) {
+        oled_draw_pixel(x0, y0);
+        if (x0 == x1 && y0 == y1) {
+            break;
+        }
+        int e2 = 2 * err;
+        if (e2 > -dy) {
+            err -= dy;
+            x0 += sx;
+        }
+        if (e2 < dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+/* Spans sobre páginas ------------------------------------------------------
+ * Un rectángulo ocupa en cada página un tramo de columnas con la misma
+ * máscara de filas: las páginas completas usan máscara 0xFF y solo la
+ * primera y la última llevan máscara parcial. Cada tramo se procesa byte a
+ * byte hasta alinear y después por palabras de 32 bits.
+ */
+typedef enum {
+    OLED_OP_SET,
+    OLED_OP_CLEAR,
+    OLED_OP_XOR,
+} oled_op_t;
+
+typedef uint32_t __attribute__((may_alias)) oled_word_t;
+
+static void oled_span_row(uint8_t *row, int len, uint8_t mask, oled_op_t op)
+{
+    uint32_t mask32 = mask * 0x01010101u;
+
+    while (len > 0 && ((uintptr_t)row & 3) != 0) {
+        *row = (op == OLED_OP_SET) ? (*row | mask) : (op == OLED_OP_CLEAR) ? (*row & ~mask) : (*row ^ mask);
+        row++;
+        len--;
+    }
+
+    oled_word_t *word = (oled_word_t *)row;
+    switch (op) {
+    case OLED_OP_SET:
+        for (; len >= 4; len -= 4) {
+            *word++ |= mask32;
+        }
+        break;
+    case OLED_OP_CLEAR:
+        for (; len >= 4; len -= 4) {
+            *word++ &= ~mask32;
+        }
+        break;
+    default:
+        for (; len >= 4; len -= 4) {
+            *word++ ^= mask32;
+        }
+        break;
+    }
+
+    row = (uint8_t *)word;
+    while (len-- > 0) {
+        *row = (op == OLED_OP_SET) ? (*row | mask) : (op == OLED_OP_CLEAR) ? (*row & ~mask) : (*row ^ mask);
+        row++;
+    }
+}
+
+/* Recorta el rectángulo [x, x+w) x [y, y+h) a la pantalla; false si queda vacío */
+static bool oled_clip(int *x, int *y, int *w, int *h)
+{
+    if (*x < 0) {
+        *w += *x;
+        *x = 0;
+    }
+    if (*y < 0) {
+        *h += *y;
+        *y = 0;
+    }
+    if (*x + *w > SCREEN_WIDTH) {
+        *w = SCREEN_WIDTH - *x;
+    }
+    if (*y + *h > SCREEN_HEIGHT) {
+        *h = SCREEN_HEIGHT - *y;
+    }
+    return *w > 0 && *h > 0;
+}
+
+/* Máscara de filas de `page` dentro de [y, y_end) */
+static uint8_t oled_page_mask(int page, int y, int y_end)
+{
+    int first = (y > page * 8) ? y - page * 8 : 0;
+    int last = (y_end < page * 8 + 8) ? y_end - page * 8 : 8;
+    return (uint8_t)((0xFFu << first) & (0xFFu >> (8 - last)));
+}
+
+/* Aplica `op` al rectángulo [x, x+w) x [y, y+h), recortado una sola vez */
+static void oled_span(int x, int y, int w, int h, oled_op_t op)
+{
+    if (!oled_clip(&x, &y, &w, &h)) {
+        return;
+    }
+
+    int y_end = y + h;   /* Exclusivo */
+    for (int page = y / 8; page * 8 < y_end; page++) {
+        oled_span_row(&oled_buffer[page * SCREEN_WIDTH + x], w, oled_page_mask(page, y, y_end), op);
+    }
+}
+
+void oled_draw_hline(int x, int y, int w)
+{
+    oled_span(x, y, w, 1, OLED_OP_SET);
+}
+
+void oled_draw_vline(int x, int y, int h)
+{
+    oled_span(x, y, 1, h, OLED_OP_SET);
+}
+
+/* Contorno con las esquinas (x, y) y (x + w, y + h), ambas incluidas */
+void oled_draw_rect(int x, int y, int w, int h)
+{
+    if (w < 0) {
+        x += w;
+        w = -w;
+    }
+    if (h < 0) {
+        y += h;
+        h = -h;
+    }
+    oled_draw_hline(x, y, w + 1);
+    oled_draw_hline(x, y + h, w + 1);
+    oled_draw_vline(x, y, h + 1);
+    oled_draw_vline(x + w, y, h + 1);
+}
+
+void oled_draw_fill_rect(int x, int y, int w, int h)
+{
+    oled_span(x, y, w, h, OLED_OP_SET);
+}
+
+void oled_invert_rect(int x, int y, int w, int h)
+{
+    oled_span(x, y, w, h, OLED_OP_XOR);
+}
+
+void oled_clear_rect(int x, int y, int w, int h)
+{
+    oled_span(x, y, w, h, OLED_OP_CLEAR);
+}
+
+void oled_copy_rect(const uint8_t *src, int x, int y, int w, int h)
+{
+    if (!oled_clip(&x, &y, &w, &h)) {
+        return;
+    }
+
+    int y_end = y + h;
+    for (int page = y / 8; page * 8 < y_end; page++) {
+        uint8_t mask = oled_page_mask(page, y, y_end);
+        uint8_t *dst = &oled_buffer[page * SCREEN_WIDTH + x];
+        const uint8_t *from = &src[page * SCREEN_WIDTH + x];
+        if (mask == 0xFF) {
+            memcpy(dst, from, w);
+            continue;
+        }
+        for (int col = 0; col < w; col++) {
+            dst[col] = (uint8_t)((dst[col] & ~mask) | (from[col] & mask));
+        }
+    }
+}
+
+
+/* Texto ------------------------------------------------------------------- */
+/*
+ * Texto por columnas completas: cada columna del glifo ya tiene el formato
+ * de página del SSD1306, así que se hace OR de un byte en la página de y
+ * (y de otro en la siguiente si y no es múltiplo de 8) con la tabla
+ * desplazada correspondiente. El recorte vertical se resuelve una vez por
+ * cadena y el horizontal solo afecta a los caracteres de los bordes.
+ */
+void oled_draw_text(int x, int y, const char *text)
+{
+    if (y <= -8 || y >= SCREEN_HEIGHT || x >= SCREEN_WIDTH) {
+        return;
+    }
+
+    /* Página superior (puede ser -1 si y < 0) y desplazamiento dentro de ella */
+    int page = (y >= 0) ? y / 8 : -1;
+    int shift = y - page * 8;
+    const uint16_t (*glyphs)[5] = font_5x7_shifted[shift];
+    uint8_t *top = (page >= 0) ? &oled_buffer[page * SCREEN_WIDTH] : NULL;
+    uint8_t *bottom = (shift != 0 && page + 1 < OLED_PAGES) ? &oled_buffer[(page + 1) * SCREEN_WIDTH] : NULL;
+
+    int char_x = x;
+    for (const char *p = text; *p != '\0' && char_x < SCREEN_WIDTH; p++, char_x += 6) {
+        char c = *p;
+        if (c < 32 || c > 126 || char_x <= -5) {
+            continue;
+        }
+
+        const uint16_t *cols = glyphs[c - 32];
+        int col0 = (char_x < 0) ? -char_x : 0;
+        int col1 = (char_x + 5 > SCREEN_WIDTH) ? SCREEN_WIDTH - char_x : 5;
+
+        for (int col = col0; col < col1; col++) {
+            uint16_t bits = cols[col];
+            if (top) {
+                top[char_x + col] |= (uint8_t)bits;
+            }
+            if (bottom) {
+                bottom[char_x + col] |= (uint8_t)(bits >> 8);
+            }
+        }
+    }
+}
+
+void oled_draw_text_centered(int line, const char *text)
+{
+    int text_width = strlen(text) * 6;
+    int x = (SCREEN_WIDTH - text_width) / 2;
+    int y = line * 10;
+
+    if (x < 0) {
+        x = 0;
+    }
+    oled_draw_text(x, y, text);
+}
+
+
+/* Composición de pantallas ------------------------------------------------ */
+void oled_render_combined_status(bool led_on, bool button_pressed, const char *ip, const char *dht_status)
+{
+    /* dht_status y ip son mostrados tal cual; se asume cadenas cortas. */
+    oled_clear();
+
+    /* Cabecera con IP (si existe) */
+    oled_draw_text_centered(0, ip);
+
+    /* Estado LED */
+    oled_draw_text(0, 10, "LED:");
+    oled_draw_text(30, 10, led_on ? "ON " : "OFF");
+    if (led_on) {
+        oled_draw_fill_rect(50, 9, 8, 8);
+    } else {
+        oled_draw_rect(50, 9, 8, 8);
+    }
+
+    /* Estado botón */
+    oled_draw_text(0, 20, "BOTON:");
+    oled_draw_text(36, 20, button_pressed ? "PRESS" : "FREE");
+    if (button_pressed) {
+        oled_draw_fill_rect(75, 19, 4, 4);
+    } else {
+        oled_draw_rect(75, 19, 4, 4);
+    }
+
+    oled_draw_text_centered(3, dht_status);
+}
+
+void oled_render_welcome_screen(void)
+{
+    oled_clear();
+    oled_draw_text_centered(0, "SISTEMA");
+    oled_draw_text_centered(1, "LED + WS");
+    oled_draw_text_centered(2, "ESP32-C3");
+    oled_draw_text_centered(3, "Listo!");
+}
+
+void oled_render_splash_screen(void)
+{
+    oled_clear();
+    oled_draw_text_centered(0, "INICIANDO");
+    oled_draw_text_centered(2, "SISTEMA");
+}
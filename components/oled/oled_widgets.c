@@ -0,0 +1,303 @@
+/**
+ * @file oled_widgets.c
+ * @brief Widgets en modo retenido: capa de fondo fija y redibujado solo de
+ *        los widgets cuyo valor cambió.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#include "oled_widgets.h"
+#include "oled_gfx.h"
+
+#include <string.h>
+
+#define CHAR_ADVANCE 6   /* 5 columnas de glifo + 1 de separación */
+#define LINE_HEIGHT  8   /* 7 filas de glifo + 1 de separación */
+
+typedef enum {
+    OLED_WIDGET_TEXT,
+    OLED_WIDGET_BOX,
+    OLED_WIDGET_BAR,
+} oled_widget_kind_t;
+
+typedef struct {
+    oled_widget_kind_t kind;
+    int16_t x, y, w, h;          /* Área ocupada: se restaura del fondo */
+    int8_t line;                 /* Texto centrado en esta línea; -1 = en (x, y) */
+    uint8_t max_chars;
+    int32_t min, max;            /* Rango de la barra */
+    oled_widget_int_fn get_int;
+    oled_widget_text_fn get_text;
+    void *arg;
+    bool drawn;                  /* El framebuffer muestra `value` / `text` */
+    int32_t value;
+    char text[OLED_WIDGET_TEXT_MAX];
+} oled_widget_t;
+
+static oled_widget_t s_widgets[OLED_WIDGETS_MAX];
+static int s_count = 0;
+static bool s_scene = false;
+
+/* Capa de fondo (etiquetas) y copia de la última trama compuesta, para
+ * detectar si otro código dibujó en el framebuffer entre refrescos */
+static uint8_t s_background[OLED_FRAME_BYTES];
+static uint8_t s_frame[OLED_FRAME_BYTES];
+static bool s_frame_valid = false;
+
+static oled_widgets_stats_t s_stats;
+
+
+/* Composición ------------------------------------------------------------- */
+void oled_widgets_begin(void)
+{
+    s_count = 0;
+    s_scene = false;
+    s_frame_valid = false;
+    oled_clear();
+}
+
+void oled_widget_label(int x, int y, const char *text)
+{
+    oled_draw_text(x, y, text);
+}
+
+void oled_widget_label_centered(int line, const char *text)
+{
+    oled_draw_text_centered(line, text);
+}
+
+static oled_widget_t *widget_add(oled_widget_kind_t kind, int x, int y, int w, int h, void *arg)
+{
+    if (s_count >= OLED_WIDGETS_MAX) {
+        return NULL;
+    }
+    oled_widget_t *widget = &s_widgets[s_count++];
+    memset(widget, 0, sizeof(*widget));
+    widget->kind = kind;
+    widget->x = x;
+    widget->y = y;
+    widget->w = w;
+    widget->h = h;
+    widget->line = -1;
+    widget->arg = arg;
+    return widget;
+}
+
+int oled_widget_text(int x, int y, int max_chars, int line, oled_widget_text_fn get, void *arg)
+{
+    if (get == NULL || max_chars <= 0) {
+        return -1;
+    }
+    if (max_chars > OLED_WIDGET_TEXT_MAX - 1) {
+        max_chars = OLED_WIDGET_TEXT_MAX - 1;
+    }
+
+    oled_widget_t *w = (line >= 0)
+        ? widget_add(OLED_WIDGET_TEXT, 0, line * 10, SCREEN_WIDTH, LINE_HEIGHT, arg)
+        : widget_add(OLED_WIDGET_TEXT, x, y, max_chars * CHAR_ADVANCE, LINE_HEIGHT, arg);
+    if (w == NULL) {
+        return -1;
+    }
+    w->line = line;
+    w->max_chars = max_chars;
+    w->get_text = get;
+    return s_count - 1;
+}
+
+int oled_widget_box(int x, int y, int size, oled_widget_int_fn get, void *arg)
+{
+    if (get == NULL || size <= 0) {
+        return -1;
+    }
+    /* El contorno incluye ambas esquinas: ocupa size + 1 */
+    oled_widget_t *w = widget_add(OLED_WIDGET_BOX, x, y, size + 1, size + 1, arg);
+    if (w == NULL) {
+        return -1;
+    }
+    w->get_int = get;
+    return s_count - 1;
+}
+
+int oled_widget_bar(int x, int y, int w, int h, int32_t min, int32_t max, oled_widget_int_fn get, void *arg)
+{
+    if (get == NULL || w < 3 || h < 3 || max <= min) {
+        return -1;
+    }
+    oled_widget_t *bar = widget_add(OLED_WIDGET_BAR, x, y, w, h, arg);
+    if (bar == NULL) {
+        return -1;
+    }
+    bar->min = min;
+    bar->max = max;
+    bar->get_int = get;
+    return s_count - 1;
+}
+
+void oled_widgets_end(void)
+{
+    memcpy(s_background, oled_get_buffer(), sizeof(s_background));
+    s_scene = true;
+    s_frame_valid = false;
+}
+
+
+/* Refresco ---------------------------------------------------------------- */
+
+/* Lee el valor actual; devuelve true si difiere de lo dibujado */
+static bool widget_poll(oled_widget_t *w)
+{
+    if (w->kind == OLED_WIDGET_TEXT) {
+        char text[OLED_WIDGET_TEXT_MAX];
+        text[0] = '\0';
+        w->get_text(text, sizeof(text), w->arg);
+        text[w->max_chars] = '\0';
+        if (w->drawn && strcmp(text, w->text) == 0) {
+            return false;
+        }
+        memcpy(w->text, text, sizeof(text));
+        return true;
+    }
+
+    int32_t value = w->get_int(w->arg);
+    if (w->drawn && value == w->value) {
+        return false;
+    }
+    w->value = value;
+    return true;
+}
+
+static void widget_draw(const oled_widget_t *w)
+{
+    switch (w->kind) {
+    case OLED_WIDGET_TEXT:
+        if (w->line >= 0) {
+            oled_draw_text_centered(w->line, w->text);
+        } else {
+            oled_draw_text(w->x, w->y, w->text);
+        }
+        break;
+    case OLED_WIDGET_BOX:
+        if (w->value) {
+            oled_draw_fill_rect(w->x, w->y, w->w - 1, w->h - 1);
+        } else {
+            oled_draw_rect(w->x, w->y, w->w - 1, w->h - 1);
+        }
+        break;
+    case OLED_WIDGET_BAR: {
+        int32_t value = w->value;
+        if (value < w->min) {
+            value = w->min;
+        }
+        if (value > w->max) {
+            value = w->max;
+        }
+        int inner = w->w - 2;
+        int filled = (int)((int64_t)(value - w->min) * inner / (w->max - w->min));
+        oled_draw_rect(w->x, w->y, w->w - 1, w->h - 1);
+        oled_draw_fill_rect(w->x + 1, w->y + 1, filled, w->h - 2);
+        break;
+    }
+    }
+}
+
+bool oled_widgets_refresh(void)
+{
+    bool changed = false;
+
+    if (!s_scene) {
+        return false;
+    }
+    s_stats.refreshes++;
+
+    /* Primera vez, o alguien dibujó fuera de la escena: partir del fondo */
+    if (!s_frame_valid || memcmp(oled_get_buffer(), s_frame, sizeof(s_frame)) != 0) {
+        oled_copy_rect(s_background, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+        for (int i = 0; i < s_count; i++) {
+            s_widgets[i].drawn = false;
+        }
+        s_stats.full_redraws++;
+        changed = true;
+    }
+
+    for (int i = 0; i < s_count; i++) {
+        oled_widget_t *w = &s_widgets[i];
+        bool was_drawn = w->drawn;
+        if (!widget_poll(w)) {
+            continue;
+        }
+        if (was_drawn) {
+            oled_copy_rect(s_background, w->x, w->y, w->w, w->h);
+        }
+        widget_draw(w);
+        w->drawn = true;
+        s_stats.widgets_drawn++;
+        changed = true;
+    }
+
+    if (changed) {
+        memcpy(s_frame, oled_get_buffer(), sizeof(s_frame));
+        s_frame_valid = true;
+    }
+    return changed;
+}
+
+void oled_widgets_invalidate(void)
+{
+    s_frame_valid = false;
+}
+
+void oled_widgets_get_stats(oled_widgets_stats_t *stats)
+{
+    *stats = s_stats;
+}
+
+
+/* Escena de estado combinado ---------------------------------------------- */
+static oled_status_bindings_t s_status;
+
+/* Copia acotada: se llama en cada refresco, sin el coste de snprintf */
+static void copy_text(char *buf, size_t size, const char *text)
+{
+    size_t len = strlen(text);
+    if (len >= size) {
+        len = size - 1;
+    }
+    memcpy(buf, text, len);
+    buf[len] = '\0';
+}
+
+static void status_led_text(char *buf, size_t size, void *arg)
+{
+    copy_text(buf, size, s_status.led_on(arg) ? "ON " : "OFF");
+}
+
+static void status_button_text(char *buf, size_t size, void *arg)
+{
+    copy_text(buf, size, s_status.button_pressed(arg) ? "PRESS" : "FREE");
+}
+
+void oled_widgets_build_status(const oled_status_bindings_t *bindings)
+{
+    s_status = *bindings;
+
+    oled_widgets_begin();
+
+    /* Cabecera con IP */
+    oled_widget_text(0, 0, OLED_WIDGET_TEXT_MAX - 1, 0, s_status.ip, s_status.arg);
+
+    /* Estado LED */
+    oled_widget_label(0, 10, "LED:");
+    oled_widget_text(30, 10, 3, -1, status_led_text, s_status.arg);
+    oled_widget_box(50, 9, 8, s_status.led_on, s_status.arg);
+
+    /* Estado botón */
+    oled_widget_label(0, 20, "BOTON:");
+    oled_widget_text(36, 20, 5, -1, status_button_text, s_status.arg);
+    oled_widget_box(75, 19, 4, s_status.button_pressed, s_status.arg);
+
+    /* Lectura DHT */
+    oled_widget_text(0, 0, OLED_WIDGET_TEXT_MAX - 1, 3, s_status.dht_status, s_status.arg);
+
+    oled_widgets_end();
+}
@@ -0,0 +1,124 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @file rules.h
+ * @brief Motor de reglas local: fuente de texto compilada a bytecode.
+ *
+ * Sintaxis (palabras clave sin distinguir mayúsculas):
+ *
+ *     WHEN <condición> THEN <acción> [ELSE <acción>]
+ *
+ *  - condición: comparaciones unidas con AND / OR / NOT y paréntesis.
+ *    Comparación: <señal> (> < >= <= == !=) <valor> [HYST <margen>].
+ *  - señales: TEMP (°C), HUM (%), MIN (hora local, p.ej. 18:30) y BTN
+ *    (evento del botón: PRESS, SHORT, LONG, DOUBLE).
+ *  - acción: ON|OFF|TOGGLE <canal|ALL>, MASK <set> <clear> o SCENE <nombre>.
+ *
+ * Ejemplo: "WHEN TEMP > 30 HYST 2 THEN ON 0 ELSE OFF 0" enciende por
+ * encima de 30 °C y apaga por debajo de 28 °C.
+ *
+ * Las reglas se evalúan solo cuando cambia alguna de sus señales; THEN se
+ * ejecuta al pasar la condición a cierta y ELSE al pasar a falsa. Los
+ * valores se manejan en décimas (enteros) y las fuentes se guardan en NVS
+ * para recompilarlas al arrancar.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#define RULES_MAX            16   /* Reglas simultáneas */
+#define RULES_NAME_MAX       16   /* Nombre (clave NVS, incluye terminador) */
+#define RULES_SOURCE_MAX     160  /* Longitud máxima de la fuente */
+#define RULES_NVS_NAMESPACE  "rules"
+
+/** Señales de entrada */
+typedef enum {
+    RULE_SIG_TEMP = 0,   /* Temperatura, décimas de °C */
+    RULE_SIG_HUM,        /* Humedad, décimas de % */
+    RULE_SIG_MIN,        /* Minuto del día x10 (requiere hora SNTP) */
+    RULE_SIG_BTN,        /* Evento del botón (RULE_BTN_*), señal de pulso */
+    RULE_SIG_COUNT
+} rule_signal_t;
+
+/** Códigos de evento para RULE_SIG_BTN */
+enum {
+    RULE_BTN_NONE = 0,
+    RULE_BTN_PRESS,
+    RULE_BTN_SHORT,
+    RULE_BTN_LONG,
+    RULE_BTN_DOUBLE,
+};
+
+/** Estadísticas de una regla */
+typedef struct {
+    char name[RULES_NAME_MAX];
+    bool state;              /* Último resultado de la condición */
+    uint32_t evaluations;
+    uint32_t then_runs;
+    uint32_t else_runs;
+    uint32_t avg_cycles;     /* Ciclos de CPU por evaluación (media) */
+    uint32_t max_cycles;
+    uint16_t code_size;      /* Bytes de bytecode */
+} rules_stats_t;
+
+/**
+ * @brief Callback tras ejecutar la acción de una regla.
+ * @param name        Nombre de la regla.
+ * @param then_branch true si se ejecutó THEN, false si ELSE.
+ */
+typedef void (*rules_action_cb_t)(const char *name, bool then_branch, void *arg);
+
+/**
+ * @brief Carga y compila las reglas guardadas y arranca el reloj MIN.
+ */
+esp_err_t rules_init(void);
+
+/**
+ * @brief Compila y añade (o sustituye) una regla; la guarda en NVS.
+ *
+ * Si la escritura en NVS falla, la tabla queda como estaba (la regla
+ * sustituida sigue activa) y la nueva no se evalúa.
+ * @param err Buffer para el mensaje de error (puede ser NULL).
+ * @return ESP_OK, ESP_ERR_INVALID_ARG (error de sintaxis o nombre),
+ *         ESP_ERR_NO_MEM (tabla llena) o el error de NVS.
+ */
+esp_err_t rules_add(const char *name, const char *source, char *err, size_t err_len);
+
+/**
+ * @brief Elimina una regla (y su fuente en NVS). Si no se puede borrar
+ * de NVS, la regla sigue activa y se devuelve el error.
+ */
+esp_err_t rules_remove(const char *name);
+
+/**
+ * @brief Actualiza una señal de nivel y evalúa las reglas que dependen de
+ * ella (solo si el valor cambió).
+ * @param value Valor en décimas.
+ */
+void rules_set_signal(rule_signal_t signal, int32_t value);
+
+/**
+ * @brief Notifica un evento de pulso (p.ej. RULE_SIG_BTN): evalúa las
+ * reglas con el valor y después vuelve la señal a 0 sin ejecutar ELSE.
+ */
+void rules_signal_event(rule_signal_t signal, int32_t value);
+
+/**
+ * @brief Copia las estadísticas de hasta `max` reglas.
+ * @return Número de entradas escritas (con `out` NULL, número de reglas).
+ */
+size_t rules_get_stats(rules_stats_t *out, size_t max);
+
+/**
+ * @brief Registra el callback de acciones (p.ej. para notificar a /ws).
+ * Se invoca fuera del bloqueo interno del motor.
+ */
+void rules_set_callback(rules_action_cb_t cb, void *arg);
+
+#endif // RULES_H
@@ -0,0 +1,464 @@
+/**
+ * @file rules.c
+ * @brief Motor de reglas: tabla de programas compilados, señales de
+ * entrada y evaluación incremental.
+ *
+ * Cada regla guarda la máscara de señales de las que depende; al cambiar
+ * una señal solo se evalúan esas reglas. Las acciones se aplican por
+ * flanco (THEN al pasar a cierta, ELSE al pasar a falsa) a través de
+ * led_control, con una sola transición por acción. Un mutex protege la
+ * tabla y los valores de las señales.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#include "rules.h"
+#include "rules_bytecode.h"
+#include "led_control.h"
+#include "led_scene.h"
+
+#include <ctype.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+static const char *TAG = "RULES";
+
+#define RULES_MIN_PERIOD_US      (10 * 1000 * 1000)  /* Muestreo de la hora local */
+#define RULES_MIN_VALID_YEAR     2024                /* Antes: hora SNTP no recibida */
+
+typedef struct {
+    bool used;
+    char name[RULES_NAME_MAX];
+    rule_program_t prog;
+    uint8_t hyst;            /* Bits de estado de las comparaciones HYST */
+    bool primed;             /* Evaluada al menos una vez */
+    bool state;
+    uint32_t evaluations;
+    uint32_t then_runs;
+    uint32_t else_runs;
+    uint64_t total_cycles;
+    uint32_t max_cycles;
+} rule_slot_t;
+
+/* Acción ejecutada, para el callback fuera del mutex */
+typedef struct {
+    char name[RULES_NAME_MAX];
+    bool then_branch;
+} rule_fired_t;
+
+static rule_slot_t s_rules[RULES_MAX];
+static int32_t s_signals[RULE_SIG_COUNT];
+static uint8_t s_valid = 1u << RULE_SIG_BTN;   /* BTN vale 0 (ningún evento) */
+
+static SemaphoreHandle_t s_mutex = NULL;
+static esp_timer_handle_t s_min_timer = NULL;
+
+static rules_action_cb_t s_callback = NULL;
+static void *s_callback_arg = NULL;
+
+
+/* Funciones privadas ------------------------------------------------------ */
+
+/* Nombres: 1..15 caracteres [A-Za-z0-9_-] (también clave NVS) */
+static bool valid_name(const char *name)
+{
+    size_t len = name ? strlen(name) : 0;
+    if (len == 0 || len >= RULES_NAME_MAX) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (!isalnum((unsigned char)name[i]) && name[i] != '_' && name[i] != '-') {
+            return false;
+        }
+    }
+    return true;
+}
+
+static rule_slot_t *find_locked(const char *name)
+{
+    for (size_t i = 0; i < RULES_MAX; i++) {
+        if (s_rules[i].used && strcmp(s_rules[i].name, name) == 0) {
+            return &s_rules[i];
+        }
+    }
+    return NULL;
+}
+
+static void run_action(const rule_action_t *action)
+{
+    switch (action->type) {
+    case RULE_ACT_MASK:
+        if (action->toggle_mask) {
+            led_control_toggle_mask(action->toggle_mask);
+        } else {
+            led_control_apply_mask(action->set_mask, action->clear_mask);
+        }
+        break;
+    case RULE_ACT_SCENE:
+        if (led_scene_apply(action->scene, NULL) != ESP_OK) {
+            ESP_LOGW(TAG, "Escena '%s' no encontrada", action->scene);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/* Evalúa una regla; si hay flanco ejecuta su acción y la anota en `fired` */
+static size_t evaluate_one_locked(rule_slot_t *r, rule_fired_t *fired)
+{
+    uint32_t start = esp_cpu_get_cycle_count();
+    bool result = rule_eval(&r->prog, s_signals, &r->hyst);
+    uint32_t cycles = esp_cpu_get_cycle_count() - start;
+
+    r->evaluations++;
+    r->total_cycles += cycles;
+    if (cycles > r->max_cycles) {
+        r->max_cycles = cycles;
+    }
+
+    if (r->primed && result == r->state) {
+        return 0;
+    }
+    r->primed = true;
+    r->state = result;
+
+    const rule_action_t *action = result ? &r->prog.then_action : &r->prog.else_action;
+    if (action->type == RULE_ACT_NONE) {
+        return 0;
+    }
+    run_action(action);
+    if (result) {
+        r->then_runs++;
+    } else {
+        r->else_runs++;
+    }
+    strcpy(fired->name, r->name);
+    fired->then_branch = result;
+    return 1;
+}
+
+/**
+ * Evalúa las reglas que dependen de `changed` y cuyas señales son todas
+ * válidas. Devuelve el número de acciones anotadas en `fired`.
+ */
+static size_t evaluate_locked(uint8_t changed, rule_fired_t *fired)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < RULES_MAX; i++) {
+        rule_slot_t *r = &s_rules[i];
+        if (r->used && (r->prog.deps & changed) && !(r->prog.deps & ~s_valid)) {
+            n += evaluate_one_locked(r, &fired[n]);
+        }
+    }
+    return n;
+}
+
+static void notify_fired(const rule_fired_t *fired, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        ESP_LOGI(TAG, "Regla '%s' -> %s", fired[i].name, fired[i].then_branch ? "THEN" : "ELSE");
+        if (s_callback) {
+            s_callback(fired[i].name, fired[i].then_branch, s_callback_arg);
+        }
+    }
+}
+
+static esp_err_t add_locked(const char *name, const rule_program_t *prog)
+{
+    rule_slot_t *r = find_locked(name);
+    if (r == NULL) {
+        for (size_t i = 0; i < RULES_MAX && r == NULL; i++) {
+            if (!s_rules[i].used) {
+                r = &s_rules[i];
+            }
+        }
+        if (r == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    memset(r, 0, sizeof(*r));
+    r->used = true;
+    strcpy(r->name, name);
+    r->prog = *prog;
+    return ESP_OK;
+}
+
+static esp_err_t save_source(const char *name, const char *source)
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(RULES_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = source ? nvs_set_str(handle, name, source) : nvs_erase_key(handle, name);
+    if (ret == ESP_ERR_NVS_NOT_FOUND) {
+        ret = ESP_OK;
+    }
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error guardando regla %s: %s", name, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/* Recompila las fuentes guardadas en NVS */
+static void load_rules(void)
+{
+    char names[RULES_MAX][RULES_NAME_MAX];
+    size_t count = 0;
+
+    nvs_iterator_t it = NULL;
+    esp_err_t ret = nvs_entry_find(NVS_DEFAULT_PART_NAME, RULES_NVS_NAMESPACE, NVS_TYPE_STR, &it);
+    while (ret == ESP_OK && count < RULES_MAX) {
+        nvs_entry_info_t info;
+        nvs_entry_info(it, &info);
+        strlcpy(names[count++], info.key, RULES_NAME_MAX);
+        ret = nvs_entry_next(&it);
+    }
+    nvs_release_iterator(it);
+    if (count == 0) {
+        return;
+    }
+
+    nvs_handle_t handle;
+    if (nvs_open(RULES_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+    size_t loaded = 0;
+    for (size_t i = 0; i < count; i++) {
+        char source[RULES_SOURCE_MAX + 1];
+        char err[48];
+        size_t len = sizeof(source);
+        rule_program_t prog;
+
+        if (nvs_get_str(handle, names[i], source, &len) != ESP_OK) {
+            continue;
+        }
+        if (rule_compile(source, &prog, err, sizeof(err)) != ESP_OK) {
+            ESP_LOGW(TAG, "Regla '%s' guardada no compila: %s", names[i], err);
+            continue;
+        }
+        if (add_locked(names[i], &prog) == ESP_OK) {
+            loaded++;
+        }
+    }
+    nvs_close(handle);
+    ESP_LOGI(TAG, "%u de %u reglas cargadas de NVS", (unsigned)loaded, (unsigned)count);
+}
+
+/* Muestrea la hora local y actualiza MIN solo si cambió */
+static void min_timer_cb(void *arg)
+{
+    time_t now = time(NULL);
+    struct tm local;
+    localtime_r(&now, &local);
+    if (local.tm_year + 1900 < RULES_MIN_VALID_YEAR) {
+        return;
+    }
+    rules_set_signal(RULE_SIG_MIN, (local.tm_hour * 60 + local.tm_min) * 10);
+}
+
+
+/* API pública ------------------------------------------------------------- */
+
+esp_err_t rules_init(void)
+{
+    if (s_mutex != NULL) {
+        return ESP_OK;
+    }
+    s_mutex = xSemaphoreCreateMutex();
+    if (s_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    load_rules();
+    xSemaphoreGive(s_mutex);
+
+    const esp_timer_create_args_t args = {
+        .callback = min_timer_cb,
+        .name = "rules_min",
+    };
+    esp_err_t ret = esp_timer_create(&args, &s_min_timer);
+    if (ret == ESP_OK) {
+        ret = esp_timer_start_periodic(s_min_timer, RULES_MIN_PERIOD_US);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error creando temporizador MIN: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t rules_add(const char *name, const char *source, char *err, size_t err_len)
+{
+    rule_program_t prog;
+
+    if (!valid_name(name) || source == NULL || strlen(source) > RULES_SOURCE_MAX) {
+        if (err && err_len) {
+            snprintf(err, err_len, "nombre o longitud inválidos");
+        }
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t ret = rule_compile(source, &prog, err, err_len);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    /* Alta en la tabla y en NVS a la vez: si NVS falla se restaura el
+     * hueco (regla anterior o libre) y la nueva no llega a evaluarse */
+    rule_fired_t fired;
+    size_t count = 0;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    rule_slot_t *r = find_locked(name);
+    for (size_t i = 0; i < RULES_MAX && r == NULL; i++) {
+        if (!s_rules[i].used) {
+            r = &s_rules[i];
+        }
+    }
+    if (r == NULL) {
+        xSemaphoreGive(s_mutex);
+        if (err && err_len) {
+            snprintf(err, err_len, "tabla de reglas llena");
+        }
+        return ESP_ERR_NO_MEM;
+    }
+    rule_slot_t old = *r;
+    add_locked(name, &prog);
+    ret = save_source(name, source);
+    if (ret != ESP_OK) {
+        *r = old;
+    } else if (!(r->prog.deps & ~s_valid) && !(r->prog.deps & (1u << RULE_SIG_BTN))) {
+        /* Si sus señales de nivel ya tienen valor se evalúa al momento;
+         * las que dependen de BTN esperan al siguiente evento */
+        count = evaluate_one_locked(r, &fired);
+    }
+    xSemaphoreGive(s_mutex);
+    notify_fired(&fired, count);
+
+    if (ret != ESP_OK) {
+        if (err && err_len) {
+            snprintf(err, err_len, "error guardando en NVS");
+        }
+        return ret;
+    }
+    ESP_LOGI(TAG, "Regla '%s' compilada (%u bytes)", name, (unsigned)prog.code_len);
+    return ESP_OK;
+}
+
+esp_err_t rules_remove(const char *name)
+{
+    if (s_mutex == NULL || !valid_name(name)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    rule_slot_t *r = find_locked(name);
+    if (r == NULL) {
+        xSemaphoreGive(s_mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+    /* Si no se puede borrar de NVS, la regla sigue activa con su estado */
+    r->used = false;
+    esp_err_t ret = save_source(name, NULL);
+    if (ret != ESP_OK) {
+        r->used = true;
+    }
+    xSemaphoreGive(s_mutex);
+    return ret;
+}
+
+void rules_set_signal(rule_signal_t signal, int32_t value)
+{
+    rule_fired_t fired[RULES_MAX];
+    size_t count = 0;
+    uint8_t bit = 1u << signal;
+
+    if (s_mutex == NULL || signal >= RULE_SIG_COUNT) {
+        return;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (!(s_valid & bit) || s_signals[signal] != value) {
+        s_signals[signal] = value;
+        s_valid |= bit;
+        count = evaluate_locked(bit, fired);
+    }
+    xSemaphoreGive(s_mutex);
+    notify_fired(fired, count);
+}
+
+void rules_signal_event(rule_signal_t signal, int32_t value)
+{
+    rule_fired_t fired[RULES_MAX];
+    size_t count;
+    uint8_t bit = 1u << signal;
+
+    if (s_mutex == NULL || signal >= RULE_SIG_COUNT) {
+        return;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_signals[signal] = value;
+    s_valid |= bit;
+    count = evaluate_locked(bit, fired);
+
+    /* Fin del pulso: sin flanco de bajada, la siguiente pulsación vuelve
+     * a disparar THEN */
+    s_signals[signal] = 0;
+    for (size_t i = 0; i < RULES_MAX; i++) {
+        if (s_rules[i].used && (s_rules[i].prog.deps & bit)) {
+            s_rules[i].state = false;
+        }
+    }
+    xSemaphoreGive(s_mutex);
+    notify_fired(fired, count);
+}
+
+size_t rules_get_stats(rules_stats_t *out, size_t max)
+{
+    size_t n = 0;
+    if (s_mutex == NULL) {
+        return 0;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    for (size_t i = 0; i < RULES_MAX && (out == NULL || n < max); i++) {
+        const rule_slot_t *r = &s_rules[i];
+        if (!r->used) {
+            continue;
+        }
+        if (out == NULL) {
+            n++;
+            continue;
+        }
+        rules_stats_t *st = &out[n++];
+        strcpy(st->name, r->name);
+        st->state = r->state;
+        st->evaluations = r->evaluations;
+        st->then_runs = r->then_runs;
+        st->else_runs = r->else_runs;
+        st->avg_cycles = r->evaluations ? (uint32_t)(r->total_cycles / r->evaluations) : 0;
+        st->max_cycles = r->max_cycles;
+        st->code_size = r->prog.code_len;
+    }
+    xSemaphoreGive(s_mutex);
+    return n;
+}
+
+void rules_set_callback(rules_action_cb_t cb, void *arg)
+{
+    s_callback_arg = arg;
+    s_callback = cb;
+}
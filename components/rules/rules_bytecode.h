@@ -0,0 +1,82 @@
+/*
+ * rules_bytecode.h
+ *
+ * Formato del bytecode de reglas y funciones de compilación/evaluación.
+ * No forma parte de la API pública.
+ *
+ * Máquina de pila de enteros (int32, valores en décimas):
+ *   LOAD  s          -> push señal s
+ *   PUSH  i32        -> push inmediato (little endian)
+ *   CMP   op         -> b = pop, a = pop, push (a op b)
+ *   CMPH  op slot h  -> igual con histéresis h (i16) y bit de estado `slot`
+ *   AND / OR / NOT   -> lógica sobre 0/1
+ *   END              -> el tope de la pila es el resultado
+ */
+
+#ifndef RULES_BYTECODE_H
+#define RULES_BYTECODE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "led_scene.h"
+
+#define RULES_CODE_MAX    64   /* Bytes de bytecode por regla */
+#define RULES_STACK_MAX   8    /* Profundidad de pila de la VM */
+#define RULES_HYST_MAX    8    /* Comparaciones con histéresis por regla */
+
+typedef enum {
+    RULE_OP_END = 0,
+    RULE_OP_LOAD,
+    RULE_OP_PUSH,
+    RULE_OP_CMP,
+    RULE_OP_CMPH,
+    RULE_OP_AND,
+    RULE_OP_OR,
+    RULE_OP_NOT,
+} rule_opcode_t;
+
+typedef enum {
+    RULE_CMP_GT = 0,
+    RULE_CMP_LT,
+    RULE_CMP_GE,
+    RULE_CMP_LE,
+    RULE_CMP_EQ,
+    RULE_CMP_NE,
+} rule_cmp_t;
+
+typedef enum {
+    RULE_ACT_NONE = 0,
+    RULE_ACT_MASK,      /* nuevo = ((m & ~clear) | set) ^ toggle */
+    RULE_ACT_SCENE,
+} rule_action_type_t;
+
+typedef struct {
+    uint8_t type;
+    uint16_t set_mask;
+    uint16_t clear_mask;
+    uint16_t toggle_mask;
+    char scene[LED_SCENE_NAME_MAX];
+} rule_action_t;
+
+typedef struct {
+    uint8_t code[RULES_CODE_MAX];
+    uint16_t code_len;
+    uint8_t deps;           /* Bit s = depende de la señal s */
+    rule_action_t then_action;
+    rule_action_t else_action;
+} rule_program_t;
+
+/**
+ * Compila una fuente. En error escribe en `err` el motivo y la posición.
+ */
+esp_err_t rule_compile(const char *source, rule_program_t *prog, char *err, size_t err_len);
+
+/**
+ * Evalúa el programa con los valores de señal dados. `hyst` guarda los
+ * bits de estado de las comparaciones con histéresis entre evaluaciones.
+ */
+bool rule_eval(const rule_program_t *prog, const int32_t *signals, uint8_t *hyst);
+
+#endif /* RULES_BYTECODE_H */
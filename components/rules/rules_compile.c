@@ -0,0 +1,532 @@
+/**
+ * @file rules_compile.c
+ * @brief Compilador de reglas (texto -> bytecode) y máquina de pila que
+ * las evalúa.
+ *
+ * El compilador es un descendente recursivo sobre la gramática:
+ *
+ *     regla    := WHEN expr THEN acción [ELSE acción]
+ *     expr     := término { OR término }
+ *     término  := factor { AND factor }
+ *     factor   := NOT factor | '(' expr ')' | señal op valor [HYST margen]
+ *
+ * Toda la validación (señales, canales, rangos, profundidad de pila) se
+ * hace al compilar, de modo que la VM no comprueba nada en tiempo de
+ * ejecución: un recorrido lineal del bytecode sin reservas de memoria.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#include "rules.h"
+#include "rules_bytecode.h"
+#include "led_control.h"
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define TOKEN_MAX  24
+
+typedef enum {
+    TK_END = 0,
+    TK_WORD,     /* Palabra o número: [A-Za-z0-9_.:-]+ */
+    TK_OP,       /* > < >= <= == != */
+    TK_LPAREN,
+    TK_RPAREN,
+    TK_BAD,
+} token_kind_t;
+
+typedef struct {
+    const char *src;
+    const char *p;          /* Posición tras el token actual */
+    token_kind_t kind;
+    char text[TOKEN_MAX];
+    int col;                /* Columna (1..n) del token actual */
+
+    rule_program_t *prog;
+    int depth;              /* Profundidad de pila en el punto actual */
+    int nesting;            /* Paréntesis / NOT abiertos (recursión del parser) */
+    uint8_t hyst_slots;
+
+    char *err;
+    size_t err_len;
+    bool failed;
+} compiler_t;
+
+
+/* Errores y tokens -------------------------------------------------------- */
+
+static bool fail(compiler_t *c, const char *fmt, ...)
+{
+    if (!c->failed && c->err && c->err_len) {
+        int n = snprintf(c->err, c->err_len, "col %d: ", c->col);
+        if (n > 0 && (size_t)n < c->err_len) {
+            va_list ap;
+            va_start(ap, fmt);
+            vsnprintf(c->err + n, c->err_len - n, fmt, ap);
+            va_end(ap);
+        }
+    }
+    c->failed = true;
+    return false;
+}
+
+static bool is_word_char(char ch)
+{
+    return isalnum((unsigned char)ch) || ch == '_' || ch == '.' || ch == ':' || ch == '-';
+}
+
+static void next_token(compiler_t *c)
+{
+    const char *p = c->p;
+    while (isspace((unsigned char)*p)) {
+        p++;
+    }
+    c->col = (int)(p - c->src) + 1;
+    c->text[0] = '\0';
+
+    if (*p == '\0') {
+        c->kind = TK_END;
+    } else if (*p == '(' || *p == ')') {
+        c->kind = (*p == '(') ? TK_LPAREN : TK_RPAREN;
+        c->text[0] = *p++;
+        c->text[1] = '\0';
+    } else if (strchr("<>=!", *p)) {
+        size_t n = (p[1] == '=') ? 2 : 1;
+        memcpy(c->text, p, n);
+        c->text[n] = '\0';
+        p += n;
+        /* '=' y '!' sueltos no son operadores */
+        c->kind = (n == 1 && (c->text[0] == '=' || c->text[0] == '!')) ? TK_BAD : TK_OP;
+    } else if (is_word_char(*p)) {
+        size_t n = 0;
+        while (is_word_char(p[n])) {
+            n++;
+        }
+        if (n >= TOKEN_MAX) {
+            c->kind = TK_BAD;
+        } else {
+            memcpy(c->text, p, n);
+            c->text[n] = '\0';
+            c->kind = TK_WORD;
+        }
+        p += n;
+    } else {
+        c->kind = TK_BAD;
+        c->text[0] = *p++;
+        c->text[1] = '\0';
+    }
+    c->p = p;
+}
+
+static bool accept_keyword(compiler_t *c, const char *kw)
+{
+    if (c->kind == TK_WORD && strcasecmp(c->text, kw) == 0) {
+        next_token(c);
+        return true;
+    }
+    return false;
+}
+
+
+/* Valores ----------------------------------------------------------------- */
+
+/* "30", "-2.5" -> décimas (un decimal como máximo) */
+static bool parse_tenths(const char *text, int32_t *out)
+{
+    char *end;
+    long whole = strtol(text, &end, 10);
+    long frac = 0;
+
+    if (end == text || whole > 100000 || whole < -100000) {
+        return false;
+    }
+    if (*end == '.') {
+        if (!isdigit((unsigned char)end[1]) || end[2] != '\0') {
+            return false;
+        }
+        frac = end[1] - '0';
+        end += 2;
+    }
+    if (*end != '\0') {
+        return false;
+    }
+    *out = (int32_t)(whole * 10 + ((text[0] == '-') ? -frac : frac));
+    return true;
+}
+
+/* "HH:MM" -> minuto del día x10 */
+static bool parse_hhmm(const char *text, int32_t *out)
+{
+    char *end;
+    long hour = strtol(text, &end, 10);
+    if (end == text || *end != ':') {
+        return false;
+    }
+    const char *m = end + 1;
+    long minute = strtol(m, &end, 10);
+    if (end == m || *end != '\0' || hour < 0 || hour > 23 || minute < 0 || minute > 59) {
+        return false;
+    }
+    *out = (int32_t)(hour * 60 + minute) * 10;
+    return true;
+}
+
+static bool parse_button(const char *text, int32_t *out)
+{
+    static const char *const names[] = { "NONE", "PRESS", "SHORT", "LONG", "DOUBLE" };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcasecmp(text, names[i]) == 0) {
+            *out = (int32_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_signal(const char *text, uint8_t *signal)
+{
+    static const char *const names[RULE_SIG_COUNT] = { "TEMP", "HUM", "MIN", "BTN" };
+    for (uint8_t i = 0; i < RULE_SIG_COUNT; i++) {
+        if (strcasecmp(text, names[i]) == 0) {
+            *signal = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_cmp(const char *text, uint8_t *op)
+{
+    static const char *const ops[] = { ">", "<", ">=", "<=", "==", "!=" };
+    for (uint8_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (strcmp(text, ops[i]) == 0) {
+            *op = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/* Emisión ----------------------------------------------------------------- */
+
+static bool emit(compiler_t *c, const uint8_t *bytes, size_t n, int stack_delta)
+{
+    rule_program_t *prog = c->prog;
+    if (prog->code_len + n > RULES_CODE_MAX - 1) {   /* Reserva para END */
+        return fail(c, "regla demasiado larga");
+    }
+    memcpy(&prog->code[prog->code_len], bytes, n);
+    prog->code_len += n;
+
+    c->depth += stack_delta;
+    if (c->depth > RULES_STACK_MAX) {
+        return fail(c, "expresión demasiado anidada");
+    }
+    return true;
+}
+
+static bool emit_op(compiler_t *c, rule_opcode_t op, int stack_delta)
+{
+    uint8_t byte = op;
+    return emit(c, &byte, 1, stack_delta);
+}
+
+
+/* Parser ------------------------------------------------------------------ */
+
+static bool parse_expr(compiler_t *c);
+static bool parse_factor(compiler_t *c);
+
+static bool parse_comparison(compiler_t *c)
+{
+    uint8_t signal, op;
+    int32_t value, hyst = 0;
+
+    if (c->kind != TK_WORD || !parse_signal(c->text, &signal)) {
+        return fail(c, "se esperaba señal (TEMP, HUM, MIN, BTN)");
+    }
+    next_token(c);
+
+    if (c->kind != TK_OP || !parse_cmp(c->text, &op)) {
+        return fail(c, "se esperaba comparación");
+    }
+    next_token(c);
+
+    bool ok = false;
+    if (c->kind == TK_WORD) {
+        switch (signal) {
+        case RULE_SIG_MIN: ok = parse_hhmm(c->text, &value); break;
+        case RULE_SIG_BTN: ok = parse_button(c->text, &value); break;
+        default:           ok = parse_tenths(c->text, &value); break;
+        }
+    }
+    if (!ok) {
+        return fail(c, signal == RULE_SIG_MIN ? "se esperaba HH:MM" :
+                       signal == RULE_SIG_BTN ? "se esperaba evento de botón" :
+                       "se esperaba número");
+    }
+    next_token(c);
+
+    if (accept_keyword(c, "HYST")) {
+        if (signal == RULE_SIG_BTN || op == RULE_CMP_EQ || op == RULE_CMP_NE) {
+            return fail(c, "HYST solo con > < >= <= sobre TEMP, HUM o MIN");
+        }
+        if (c->kind != TK_WORD || !parse_tenths(c->text, &hyst) || hyst <= 0 || hyst > INT16_MAX) {
+            return fail(c, "margen HYST inválido");
+        }
+        if (c->hyst_slots >= RULES_HYST_MAX) {
+            return fail(c, "demasiadas comparaciones con HYST");
+        }
+        next_token(c);
+    }
+
+    c->prog->deps |= 1u << signal;
+
+    uint8_t load[2] = { RULE_OP_LOAD, signal };
+    uint8_t push[5] = { RULE_OP_PUSH, (uint8_t)value, (uint8_t)(value >> 8),
+                        (uint8_t)(value >> 16), (uint8_t)(value >> 24) };
+    if (!emit(c, load, sizeof(load), 1) || !emit(c, push, sizeof(push), 1)) {
+        return false;
+    }
+    if (hyst == 0) {
+        uint8_t cmp[2] = { RULE_OP_CMP, op };
+        return emit(c, cmp, sizeof(cmp), -1);
+    }
+    uint8_t cmph[5] = { RULE_OP_CMPH, op, c->hyst_slots++, (uint8_t)hyst, (uint8_t)(hyst >> 8) };
+    return emit(c, cmph, sizeof(cmph), -1);
+}
+
+static bool parse_nested(compiler_t *c)
+{
+    if (accept_keyword(c, "NOT")) {
+        return parse_factor(c) && emit_op(c, RULE_OP_NOT, 0);
+    }
+    next_token(c);   /* '(' */
+    if (!parse_expr(c)) {
+        return false;
+    }
+    if (c->kind != TK_RPAREN) {
+        return fail(c, "se esperaba ')'");
+    }
+    next_token(c);
+    return true;
+}
+
+static bool parse_factor(compiler_t *c)
+{
+    if (c->kind != TK_LPAREN && !(c->kind == TK_WORD && strcasecmp(c->text, "NOT") == 0)) {
+        return parse_comparison(c);
+    }
+    /* Acota la recursión: el parser corre en la pila de httpd o de
+     * rules_init, y cada nivel cuesta ~200 bytes */
+    if (++c->nesting > RULES_STACK_MAX) {
+        return fail(c, "expresión demasiado anidada");
+    }
+    bool ok = parse_nested(c);
+    c->nesting--;
+    return ok;
+}
+
+static bool parse_term(compiler_t *c)
+{
+    if (!parse_factor(c)) {
+        return false;
+    }
+    while (accept_keyword(c, "AND")) {
+        if (!parse_factor(c) || !emit_op(c, RULE_OP_AND, -1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool parse_expr(compiler_t *c)
+{
+    if (!parse_term(c)) {
+        return false;
+    }
+    while (accept_keyword(c, "OR")) {
+        if (!parse_term(c) || !emit_op(c, RULE_OP_OR, -1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Canal numérico o ALL -> máscara */
+static bool parse_channel_mask(compiler_t *c, uint16_t *mask)
+{
+    if (accept_keyword(c, "ALL")) {
+        *mask = (uint16_t)led_control_get_all_mask();
+        return true;
+    }
+    char *end;
+    long ch = (c->kind == TK_WORD) ? strtol(c->text, &end, 10) : -1;
+    if (c->kind != TK_WORD || end == c->text || *end != '\0' ||
+        ch < 0 || ch >= led_control_get_channel_count()) {
+        return fail(c, "canal inválido");
+    }
+    *mask = (uint16_t)(1u << ch);
+    next_token(c);
+    return true;
+}
+
+static bool parse_mask_value(compiler_t *c, uint16_t *mask)
+{
+    char *end;
+    unsigned long value = (c->kind == TK_WORD) ? strtoul(c->text, &end, 0) : 0;
+    if (c->kind != TK_WORD || end == c->text || *end != '\0' ||
+        (value & ~(unsigned long)led_control_get_all_mask()) != 0) {
+        return fail(c, "máscara inválida");
+    }
+    *mask = (uint16_t)value;
+    next_token(c);
+    return true;
+}
+
+static bool parse_action(compiler_t *c, rule_action_t *action)
+{
+    uint16_t mask;
+    memset(action, 0, sizeof(*action));
+
+    if (accept_keyword(c, "ON")) {
+        action->type = RULE_ACT_MASK;
+        return parse_channel_mask(c, &action->set_mask);
+    }
+    if (accept_keyword(c, "OFF")) {
+        action->type = RULE_ACT_MASK;
+        return parse_channel_mask(c, &action->clear_mask);
+    }
+    if (accept_keyword(c, "TOGGLE")) {
+        action->type = RULE_ACT_MASK;
+        return parse_channel_mask(c, &action->toggle_mask);
+    }
+    if (accept_keyword(c, "MASK")) {
+        action->type = RULE_ACT_MASK;
+        if (!parse_mask_value(c, &mask)) {
+            return false;
+        }
+        action->set_mask = mask;
+        if (!parse_mask_value(c, &mask)) {
+            return false;
+        }
+        action->clear_mask = mask & ~action->set_mask;
+        return true;
+    }
+    if (accept_keyword(c, "SCENE")) {
+        if (c->kind != TK_WORD || strlen(c->text) >= sizeof(action->scene)) {
+            return fail(c, "nombre de escena inválido");
+        }
+        action->type = RULE_ACT_SCENE;
+        strcpy(action->scene, c->text);
+        next_token(c);
+        return true;
+    }
+    return fail(c, "se esperaba acción (ON, OFF, TOGGLE, MASK, SCENE)");
+}
+
+
+/* API interna ------------------------------------------------------------- */
+
+esp_err_t rule_compile(const char *source, rule_program_t *prog, char *err, size_t err_len)
+{
+    compiler_t c = {
+        .src = source,
+        .p = source,
+        .prog = prog,
+        .err = err,
+        .err_len = err_len,
+    };
+
+    memset(prog, 0, sizeof(*prog));
+    if (err && err_len) {
+        err[0] = '\0';
+    }
+    next_token(&c);
+
+    bool ok = (accept_keyword(&c, "WHEN") || fail(&c, "se esperaba WHEN")) &&
+              parse_expr(&c) &&
+              (accept_keyword(&c, "THEN") || fail(&c, "se esperaba THEN")) &&
+              parse_action(&c, &prog->then_action) &&
+              (!accept_keyword(&c, "ELSE") || parse_action(&c, &prog->else_action)) &&
+              (c.kind == TK_END || fail(&c, "texto sobrante '%s'", c.text));
+
+    if (!ok) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    prog->code[prog->code_len++] = RULE_OP_END;
+    return ESP_OK;
+}
+
+static inline bool compare(uint8_t op, int32_t a, int32_t b)
+{
+    switch (op) {
+    case RULE_CMP_GT: return a > b;
+    case RULE_CMP_LT: return a < b;
+    case RULE_CMP_GE: return a >= b;
+    case RULE_CMP_LE: return a <= b;
+    case RULE_CMP_EQ: return a == b;
+    default:          return a != b;
+    }
+}
+
+bool rule_eval(const rule_program_t *prog, const int32_t *signals, uint8_t *hyst)
+{
+    int32_t stack[RULES_STACK_MAX];
+    int sp = 0;
+    const uint8_t *pc = prog->code;
+
+    for (;;) {
+        switch (*pc++) {
+        case RULE_OP_LOAD:
+            stack[sp++] = signals[*pc++];
+            break;
+        case RULE_OP_PUSH:
+            stack[sp++] = (int32_t)((uint32_t)pc[0] | (uint32_t)pc[1] << 8 |
+                                    (uint32_t)pc[2] << 16 | (uint32_t)pc[3] << 24);
+            pc += 4;
+            break;
+        case RULE_OP_CMP:
+            sp--;
+            stack[sp - 1] = compare(*pc++, stack[sp - 1], stack[sp]);
+            break;
+        case RULE_OP_CMPH: {
+            uint8_t op = pc[0];
+            uint8_t bit = 1u << pc[1];
+            int32_t margin = (int16_t)(pc[2] | pc[3] << 8);
+            int32_t limit;
+            pc += 4;
+            sp--;
+            /* Con la comparación ya cierta, el umbral se desplaza el
+             * margen en el sentido que la mantiene cierta */
+            limit = stack[sp];
+            if (*hyst & bit) {
+                limit += (op == RULE_CMP_GT || op == RULE_CMP_GE) ? -margin : margin;
+            }
+            bool r = compare(op, stack[sp - 1], limit);
+            *hyst = r ? (*hyst | bit) : (*hyst & ~bit);
+            stack[sp - 1] = r;
+            break;
+        }
+        case RULE_OP_AND:
+            sp--;
+            stack[sp - 1] = stack[sp - 1] && stack[sp];
+            break;
+        case RULE_OP_OR:
+            sp--;
+            stack[sp - 1] = stack[sp - 1] || stack[sp];
+            break;
+        case RULE_OP_NOT:
+            stack[sp - 1] = !stack[sp - 1];
+            break;
+        default:   /* RULE_OP_END */
+            return sp > 0 && stack[sp - 1] != 0;
+        }
+    }
+}
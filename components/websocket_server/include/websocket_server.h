@@ -37,6 +37,21 @@ void wifi_init_sta(void);
  */
 void start_websocket_server(void);
 
+/**
+ * @brief Envía un texto a todos los clientes WebSocket conectados.
+ *
+ * Puede llamarse desde cualquier tarea: el envío se encola en la tarea
+ * del servidor (httpd_queue_work) con una copia del texto.
+ */
+esp_err_t websocket_server_broadcast(const char *text);
+
+/**
+ * @brief Envía a todos los clientes el estado actual (mismo formato que la
+ * respuesta a "STATUS"). Las peticiones que llegan mientras otra está
+ * pendiente se agrupan en un solo envío.
+ */
+esp_err_t websocket_server_notify_state(void);
+
 /**
  * @brief Devuelve la IP actual asignada a la interfaz WiFi STA.
  *
@@ -5,7 +5,12 @@
  *
  * Implementación que maneja:
  *  - Endpoints estáticos: /, /style.css, /websocket.js
- *  - WebSocket en /ws para recibir comandos: "ON", "OFF", "TOGGLE", "STATUS"
+ *  - WebSocket en /ws para recibir comandos: "ON", "OFF", "TOGGLE", "STATUS",
+ *    canales/máscaras ("CH", "MASK", "ALL"), brillo ("PWM", "BRIGHT", "FADE"),
+ *    efectos ("FX"), timelines ("TL" + frames binarios), acciones
+ *    programadas ("SCHED"), escenas y grupos ("SCENE", "GROUP"), reglas
+ *    locales ("RULE"), tira WS2812 ("PX" + frames binarios) y "BENCH"
+ *    (micro-benchmarks)
  *
  * Autor: migbertweb
  * Fecha: 2025-11-09
@@ -13,17 +18,37 @@
 
 #include "websocket_server.h"
 #include "led_control.h"
+#include "led_pwm.h"
+#include "led_effect.h"
+#include "led_timeline.h"
+#include "led_schedule.h"
+#include "led_scene.h"
+#include "rules.h"
+#include "ws2812.h"
+#include "oled.h"
+#include "i2c_bus.h"
+#include "bench.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "esp_http_server.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "esp_spiffs.h"
 #include "esp_netif.h"
 #include "esp_event.h"
+#include "esp_timer.h"
+#include "esp_sntp.h"
+#include "sdkconfig.h"
+
+#if CONFIG_WSLED_NET_OPENETH
+#include "esp_eth.h"
+#endif
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <time.h>
 
 /* Tag usado para logs */
 static const char *TAG = "WEB_SOCKET";
@@ -31,6 +56,33 @@ static const char *TAG = "WEB_SOCKET";
 /* Handle del servidor HTTPD (global para permitir stop si se quisiera) */
 static httpd_handle_t server = NULL;
 
+/* Clave del netif por defecto según la interfaz de red usada */
+#if CONFIG_WSLED_NET_OPENETH
+#define NETIF_IFKEY "ETH_DEF"
+#else
+#define NETIF_IFKEY "WIFI_STA_DEF"
+#endif
+
+#if CONFIG_WSLED_BENCH_MARKERS
+/* Tag propio para que tools/qemu_bench.py pueda filtrar las marcas */
+static const char *BENCH_TAG = "BENCH";
+
+/* Se marca solo el primer comando /ws atendido tras el arranque */
+static bool s_first_cmd_marked = false;
+
+/**
+ * @brief Emite por consola una marca de tiempo de arranque en JSON.
+ * @param event Nombre del hito (p.ej. "ws_server_started").
+ */
+static void bench_mark(const char *event)
+{
+    ESP_LOGI(BENCH_TAG, "{\"event\":\"%s\",\"t_us\":%lld}",
+             event, (long long)esp_timer_get_time());
+}
+#else
+#define bench_mark(event) do { } while (0)
+#endif
+
 /*
  * Estructura auxiliar (no utilizada activamente en esta versión) que muestra
  * cómo se podría asociar contexto asíncrono por cliente/FD.
@@ -103,17 +155,1003 @@ static esp_err_t js_handler(httpd_req_t *req)
     return serve_file(req, "websocket.js", "application/javascript");
 }
 
-/// Maneja los mensajes WebSocket
+/* Tamaño máximo de una respuesta de texto (el JSON de BENCH es el mayor) */
+#define WS_RESPONSE_MAX 1024
+
+/* Tamaño máximo de un frame binario (timeline completo o trama de píxeles) */
+#define WS_TIMELINE_BINARY_MAX (LED_TIMELINE_HEADER_SIZE + LED_TIMELINE_MAX_EVENTS * sizeof(led_timeline_event_t))
+#define WS_PIXEL_BINARY_MAX    (WS2812_FRAME_HEADER_SIZE + WS2812_MAX_PIXELS * 4)
+#define WS_BINARY_MAX (WS_TIMELINE_BINARY_MAX > WS_PIXEL_BINARY_MAX ? WS_TIMELINE_BINARY_MAX : WS_PIXEL_BINARY_MAX)
+
+/* Fichero de SPIFFS donde se guarda el timeline */
+#define WS_TIMELINE_PATH "/spiffs/timeline.ltl"
+
+/* Clientes como máximo en un broadcast (>= max_open_sockets del httpd) */
+#define WS_MAX_CLIENTS 8
+
+/* Iteraciones por defecto del comando BENCH */
+#define WS_BENCH_DEFAULT_ITERATIONS 32
+
+/* Trabajos como máximo en una respuesta de SCHED:LIST */
+#define WS_SCHED_LIST_MAX 32
+
+/* Año mínimo para considerar la hora sincronizada (SCHED:AT) */
+#define WS_SCHED_MIN_VALID_YEAR 2024
+
+/* Tarea de un solo uso que ejecuta OLED:TUNE fuera del httpd */
+#define WS_TUNE_TASK_STACK    3072
+#define WS_TUNE_TASK_PRIORITY 2
+
 /**
- * @brief Handler para el endpoint WebSocket (/ws).
+ * @brief Codifica el estado actual: "LED:ENCENDIDO|APAGADO" seguido de
+ * campos ";CLAVE=valor" (máscara de canales, número de canales, versión
+ * del estado, brillo 0..255 si el modo PWM está activo y efecto en curso
+ * si lo hay).
+ * @param out Buffer de salida.
+ * @param len Tamaño de `out`.
+ */
+static void ws_build_status(char *out, size_t len)
+{
+    uint32_t mask, version;
+    led_control_get_snapshot(&mask, &version);
+    bool led_state = (mask >> LED_CONTROL_LED_CHANNEL) & 1;
+    const char* estado = led_state ? "ENCENDIDO" : "APAGADO";
+    int n = snprintf(out, len, "LED:%s;MASK=0x%04lX;CH=%d;VER=%lu", estado,
+                     (unsigned long)mask, led_control_get_channel_count(),
+                     (unsigned long)version);
+    if (n > 0 && (size_t)n < len && led_pwm_is_enabled()) {
+        n += snprintf(out + n, len - n, ";PWM=%u", led_pwm_get_brightness());
+    }
+
+    led_effect_params_t fx;
+    uint32_t cycles;
+    if (n > 0 && (size_t)n < len && led_effect_get_state(&fx, &cycles)) {
+        n += snprintf(out + n, len - n, ";FX=%s;FX_CYCLES=%lu", led_effect_name(fx.type),
+                      (unsigned long)cycles);
+    }
+
+    if (n > 0 && (size_t)n < len && led_timeline_is_playing()) {
+        n += snprintf(out + n, len - n, ";TL=PLAY");
+    }
+
+    if (n > 0 && (size_t)n < len && led_sched_count() > 0) {
+        snprintf(out + n, len - n, ";SCHED=%u", (unsigned)led_sched_count());
+    }
+}
+
+/**
+ * @brief Ejecuta los comandos de timeline.
+ *
+ *  - "TL:START[:<sync_ms>]" -> reproduce (opcionalmente alineado a sync_ms)
+ *  - "TL:STOP"              -> detiene la reproducción
+ *  - "TL:SAVE" / "TL:LOAD"  -> guarda/carga el timeline en SPIFFS
+ *
+ * La secuencia se sube como frame binario (ver led_timeline.h).
+ * @return true si el comando era de timeline y se ejecutó correctamente.
+ */
+static bool ws_timeline_command(const char *cmd)
+{
+    if (strncmp(cmd, "TL:START", 8) == 0) {
+        uint32_t sync_ms = 0;
+        if (cmd[8] == ':') {
+            char *end;
+            sync_ms = strtoul(cmd + 9, &end, 10);
+            if (*end != '\0') {
+                return false;
+            }
+        } else if (cmd[8] != '\0') {
+            return false;
+        }
+        return led_timeline_start(sync_ms) == ESP_OK;
+    }
+    if (strcmp(cmd, "TL:STOP") == 0) {
+        led_timeline_stop();
+        return true;
+    }
+    if (strcmp(cmd, "TL:SAVE") == 0) {
+        return led_timeline_save(WS_TIMELINE_PATH) == ESP_OK;
+    }
+    if (strcmp(cmd, "TL:LOAD") == 0) {
+        return led_timeline_load_file(WS_TIMELINE_PATH) == ESP_OK;
+    }
+    return false;
+}
+
+/**
+ * @brief Respuesta de "TL:STATS": estado, contadores y jitter en us.
+ */
+static void ws_timeline_stats(char *response, size_t len)
+{
+    led_timeline_stats_t st;
+    led_timeline_get_stats(&st);
+    snprintf(response, len,
+             "TL:STATS;PLAY=%d;EVENTS=%u;PLAYED=%lu;LOOPS=%lu;LATE=%lu;"
+             "JITTER_MIN=%lu;JITTER_AVG=%lu;JITTER_MAX=%lu",
+             led_timeline_is_playing(), (unsigned)led_timeline_get_event_count(),
+             (unsigned long)st.events_played, (unsigned long)st.loops,
+             (unsigned long)st.late_events, (unsigned long)st.jitter_min_us,
+             (unsigned long)st.jitter_avg_us, (unsigned long)st.jitter_max_us);
+}
+
+/**
+ * @brief Respuesta de "OLED:STATS": ritmo de tramas y tiempos (us).
+ *
+ * RENDER_* es el tiempo de dibujo en el framebuffer y XFER_* el de bus de
+ * una trama; BUS es el % de tiempo de bus de la pantalla en el último
+ * segundo. PRESENT=0 mientras el panel no responde (ABSENT cuenta las
+ * veces que se dio por ausente).
+ */
+static void ws_oled_stats(char *response, size_t len)
+{
+    oled_frame_stats_t fs;
+    oled_stats_t st;
+    oled_get_frame_stats(&fs);
+    oled_get_stats(&st);
+    snprintf(response, len,
+             "OLED:STATS;FPS=%lu;FRAMES=%lu;IDLE=%lu;DEFERRED=%lu;LIMITED=%lu;DROPPED=%lu;"
+             "RENDER_US=%lu;RENDER_MAX=%lu;XFER_US=%lu;XFER_MAX=%lu;BYTES=%lu;BUS=%lu;"
+             "PRESENT=%d;ERR=%lu;ABSENT=%lu",
+             (unsigned long)fs.fps, (unsigned long)fs.frames, (unsigned long)fs.idle,
+             (unsigned long)fs.deferred, (unsigned long)fs.rate_limited,
+             (unsigned long)st.dropped, (unsigned long)fs.render_us_last,
+             (unsigned long)fs.render_us_max, (unsigned long)st.frame_us_last,
+             (unsigned long)st.frame_us_max, (unsigned long)st.bytes_sent,
+             (unsigned long)fs.bus_pct, oled_is_present() ? 1 : 0,
+             (unsigned long)st.errors, (unsigned long)st.absent);
+}
+
+/* Calibración en curso (OLED:TUNE); solo hay una a la vez */
+static volatile bool s_tune_running = false;
+
+/*
+ * Calibra la velocidad de la pantalla y difunde el resultado a todos los
+ * clientes. Son cientos de transacciones, el timeout y la recuperación
+ * del paso que falla y un commit de NVS: en el httpd retrasaría todos los
+ * comandos de control.
+ */
+static void ws_oled_tune_task(void *arg)
+{
+    uint32_t hz = 0;
+    char msg[32];
+
+    if (oled_tune_bus(&hz) == ESP_OK) {
+        snprintf(msg, sizeof(msg), "OLED:TUNE;HZ=%lu", (unsigned long)hz);
+    } else {
+        snprintf(msg, sizeof(msg), "ERROR:OLED:TUNE");
+    }
+    ESP_LOGI(TAG, "Calibración I2C terminada: %s", msg);
+    websocket_server_broadcast(msg);
+
+    s_tune_running = false;
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief "OLED:TUNE": lanza la calibración y responde "OLED:TUNE;STARTED"
+ * al momento; el resultado ("OLED:TUNE;HZ=<velocidad>" o
+ * "ERROR:OLED:TUNE") llega después por broadcast. "ERROR:OLED:TUNE;BUSY"
+ * si ya hay una en curso.
+ */
+static void ws_oled_tune_start(char *response, size_t len)
+{
+    if (s_tune_running) {
+        snprintf(response, len, "ERROR:OLED:TUNE;BUSY");
+        return;
+    }
+    /* Se marca antes de crearla: la tarea lo limpia al terminar */
+    s_tune_running = true;
+    if (xTaskCreate(ws_oled_tune_task, "oled_tune", WS_TUNE_TASK_STACK, NULL,
+                    WS_TUNE_TASK_PRIORITY, NULL) != pdPASS) {
+        s_tune_running = false;
+        snprintf(response, len, "ERROR:OLED:TUNE");
+        return;
+    }
+    ESP_LOGI(TAG, "Calibrando velocidad I2C de la pantalla");
+    snprintf(response, len, "OLED:TUNE;STARTED");
+}
+
+/**
+ * @brief Respuesta de "I2C:STATS": contabilidad del bus por dispositivo,
+ * p.ej. "I2C:STATS;N=1;RECOV=0;oled=0x3C,HZ=800000,TX=120,ERR=0,FALLBACKS=0,
+ * WR=4210,RD=0,BUS_US=98000,WAIT_AVG=15,WAIT_MAX=840". WAIT_* es la espera
+ * en cola (us) tras otros dispositivos; RECOV, las recuperaciones del bus
+ * tras un timeout.
+ */
+static void ws_i2c_stats(char *response, size_t len)
+{
+    size_t count = i2c_bus_get_device_count();
+    int off = snprintf(response, len, "I2C:STATS;N=%u;RECOV=%lu", (unsigned)count,
+                       (unsigned long)i2c_bus_get_recoveries());
+
+    for (size_t i = 0; i < count && off > 0 && (size_t)off < len; i++) {
+        i2c_bus_device_stats_t st;
+        if (i2c_bus_get_device_stats(i, &st) != ESP_OK) {
+            break;
+        }
+        off += snprintf(response + off, len - off,
+                        ";%s=0x%02X,HZ=%lu,TX=%lu,ERR=%lu,FALLBACKS=%lu,WR=%lu,RD=%lu,BUS_US=%lu,"
+                        "WAIT_AVG=%lu,WAIT_MAX=%lu",
+                        st.name, st.address, (unsigned long)st.scl_hz, (unsigned long)st.transactions,
+                        (unsigned long)st.errors, (unsigned long)st.speed_fallbacks,
+                        (unsigned long)st.bytes_written,
+                        (unsigned long)st.bytes_read, (unsigned long)st.bus_us,
+                        (unsigned long)(st.transactions ? st.wait_us_total / st.transactions : 0),
+                        (unsigned long)st.wait_us_max);
+    }
+}
+
+/**
+ * @brief Procesa un frame binario según su magic: timelines ("LTL1") o
+ * tramas de la tira WS2812 ("PXF1", ver ws2812.h).
+ */
+static void ws_dispatch_binary(const uint8_t *data, size_t data_len, char *response, size_t len)
+{
+    if (data_len >= 4 && memcmp(data, WS2812_FRAME_MAGIC, 4) == 0) {
+        esp_err_t ret = ws2812_load_frame(data, data_len);
+        if (ret == ESP_OK) {
+            ws2812_stats_t st;
+            ws2812_get_stats(&st);
+            snprintf(response, len, "PX:OK;F=%lu", (unsigned long)st.frames);
+        } else {
+            snprintf(response, len, "ERROR:PX %s", esp_err_to_name(ret));
+        }
+        return;
+    }
+    if (data_len >= 4 && memcmp(data, LED_TIMELINE_MAGIC, 4) == 0) {
+        esp_err_t ret = led_timeline_load(data, data_len);
+        if (ret == ESP_OK) {
+            snprintf(response, len, "TL:OK;EVENTS=%u", (unsigned)led_timeline_get_event_count());
+        } else {
+            snprintf(response, len, "ERROR:TL %s", esp_err_to_name(ret));
+        }
+        return;
+    }
+    snprintf(response, len, "ERROR:binario desconocido");
+}
+
+/**
+ * @brief Ejecuta los comandos del motor de efectos.
+ *
+ *  - "FX:STOP"
+ *  - "FX:<TIPO>[:<periodo_ms>[:<duty_%>[:<repeticiones>[:<mascara>]]]]"
+ *    con TIPO = BLINK | STROBE | HEARTBEAT | BREATHE. Los campos omitidos
+ *    o a 0 toman los valores por defecto del tipo; repeticiones 0 = sin fin.
+ *
+ * @return true si el comando era de efectos y se ejecutó correctamente.
+ */
+static bool ws_effect_command(const char *cmd)
+{
+    if (strncmp(cmd, "FX:", 3) != 0) {
+        return false;
+    }
+    if (strcmp(cmd + 3, "STOP") == 0) {
+        led_effect_stop();
+        return true;
+    }
+
+    char name[16];
+    const char *args = cmd + 3;
+    size_t name_len = strcspn(args, ":");
+    if (name_len == 0 || name_len >= sizeof(name)) {
+        return false;
+    }
+    memcpy(name, args, name_len);
+    name[name_len] = '\0';
+
+    led_effect_params_t params = { .type = led_effect_from_name(name) };
+    if (params.type == LED_EFFECT_NONE) {
+        return false;
+    }
+
+    /* Campos numéricos opcionales en orden */
+    unsigned long values[4] = { 0 };
+    const char *p = args + name_len;
+    for (int i = 0; i < 4 && *p == ':'; i++) {
+        char *end;
+        values[i] = strtoul(p + 1, &end, 0);
+        p = end;
+    }
+    if (*p != '\0' || values[1] > 100) {
+        return false;
+    }
+
+    params.period_ms = values[0];
+    params.duty_pct = values[1];
+    params.repeat = values[2];
+    params.channel_mask = values[3];
+    return led_effect_start(&params) == ESP_OK;
+}
+
+/**
+ * @brief Ejecuta los comandos de brillo PWM.
+ *
+ *  - "PWM:ON" / "PWM:OFF"     -> activa/desactiva el modo PWM del LED
+ *  - "BRIGHT:<0-255>"         -> brillo inmediato
+ *  - "FADE:<0-255>:<ms>"      -> fundido por hardware (no bloqueante)
+ *
+ * @return true si el comando era de PWM y se ejecutó correctamente.
+ */
+static bool ws_pwm_command(const char *cmd)
+{
+    char *end;
+
+    if (strcmp(cmd, "PWM:ON") == 0) {
+        return led_pwm_enable() == ESP_OK;
+    }
+    if (strcmp(cmd, "PWM:OFF") == 0) {
+        return led_pwm_disable() == ESP_OK;
+    }
+    if (strncmp(cmd, "BRIGHT:", 7) == 0) {
+        unsigned long level = strtoul(cmd + 7, &end, 10);
+        if (*end != '\0' || level > 255) {
+            return false;
+        }
+        return led_pwm_set_brightness(level) == ESP_OK;
+    }
+    if (strncmp(cmd, "FADE:", 5) == 0) {
+        unsigned long level = strtoul(cmd + 5, &end, 10);
+        if (*end != ':' || level > 255) {
+            return false;
+        }
+        unsigned long duration_ms = strtoul(end + 1, &end, 10);
+        if (*end != '\0') {
+            return false;
+        }
+        return led_pwm_fade_to(level, duration_ms) == ESP_OK;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Ejecuta los comandos de canales y máscaras.
+ *
+ *  - "CH:<n>:ON|OFF|TOGGLE"      -> un canal individual
+ *  - "MASK:<set>:<clear>"        -> encender/apagar grupos a la vez
+ *  - "MASK:<mask>"               -> fijar la máscara completa
+ *  - "ALL:ON|OFF"                -> todos los canales
+ *  - "CAS:<versión>:<mask>"      -> fija la máscara solo si la versión del
+ *                                   estado (campo VER) sigue siendo esa
+ *
+ * Las máscaras aceptan decimal o hexadecimal con prefijo 0x.
+ * @return true si el comando era válido.
+ */
+static bool ws_channel_command(const char *cmd)
+{
+    char *end;
+
+    if (strncmp(cmd, "CAS:", 4) == 0) {
+        uint32_t expected = strtoul(cmd + 4, &end, 10);
+        if (*end != ':') {
+            return false;
+        }
+        uint32_t mask = strtoul(end + 1, &end, 0);
+        if (*end != '\0') {
+            return false;
+        }
+        uint32_t version;
+        bool ok = led_control_compare_and_set(expected, mask, &version);
+        ESP_LOGI(TAG, "CAS v%lu -> %s (v%lu)", (unsigned long)expected,
+                 ok ? "aplicado" : "rechazado", (unsigned long)version);
+        return ok;
+    }
+
+    if (strncmp(cmd, "CH:", 3) == 0) {
+        long channel = strtol(cmd + 3, &end, 10);
+        if (*end != ':' || channel < 0 || channel >= led_control_get_channel_count()) {
+            return false;
+        }
+        const char *action = end + 1;
+        if (strcmp(action, "ON") == 0) {
+            led_control_set_channel(channel, true);
+        } else if (strcmp(action, "OFF") == 0) {
+            led_control_set_channel(channel, false);
+        } else if (strcmp(action, "TOGGLE") == 0) {
+            led_control_toggle_channel(channel);
+        } else {
+            return false;
+        }
+        ESP_LOGI(TAG, "Canal %ld -> %s", channel, action);
+        return true;
+    }
+
+    if (strncmp(cmd, "MASK:", 5) == 0) {
+        uint32_t first = strtoul(cmd + 5, &end, 0);
+        if (*end == '\0') {
+            led_control_write_mask(first);
+        } else if (*end == ':') {
+            uint32_t clear = strtoul(end + 1, &end, 0);
+            if (*end != '\0') {
+                return false;
+            }
+            led_control_apply_mask(first, clear);
+        } else {
+            return false;
+        }
+        ESP_LOGI(TAG, "Máscara aplicada: 0x%04lX", (unsigned long)led_control_get_mask());
+        return true;
+    }
+
+    if (strcmp(cmd, "ALL:ON") == 0) {
+        led_control_write_mask(led_control_get_all_mask());
+        return true;
+    }
+    if (strcmp(cmd, "ALL:OFF") == 0) {
+        led_control_write_mask(0);
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Respuesta de "SCHED:LIST": "SCHED:LIST;N=<total>" seguido de
+ * ";J=<id>,<ms>,<A|T>,<set>,<clear>" por trabajo mientras quepa.
+ */
+static void ws_sched_list(char *response, size_t len)
+{
+    static led_sched_job_info_t jobs[WS_SCHED_LIST_MAX];
+    size_t count = led_sched_list(jobs, WS_SCHED_LIST_MAX);
+
+    int n = snprintf(response, len, "SCHED:LIST;N=%u", (unsigned)led_sched_count());
+    for (size_t i = 0; i < count && n > 0 && (size_t)n < len; i++) {
+        n += snprintf(response + n, len - n, ";J=0x%08lX,%lu,%c,0x%04X,0x%04X",
+                      (unsigned long)jobs[i].id, (unsigned long)jobs[i].due_in_ms,
+                      jobs[i].action == LED_SCHED_TOGGLE ? 'T' : 'A',
+                      jobs[i].set_mask, jobs[i].clear_mask);
+    }
+    if (n > 0 && (size_t)n >= len) {
+        /* Recortar al último trabajo completo */
+        char *last = strrchr(response, ';');
+        if (last) {
+            *last = '\0';
+        }
+    }
+}
+
+/**
+ * @brief Traduce ON|OFF|TOGGLE sobre una máscara a una acción planificada.
+ */
+static bool ws_sched_word(const char *word, uint32_t mask, led_sched_action_t *action,
+                          uint16_t *set, uint16_t *clr)
+{
+    *action = LED_SCHED_APPLY;
+    *set = 0;
+    *clr = 0;
+    if (strcmp(word, "ON") == 0) {
+        *set = mask;
+    } else if (strcmp(word, "OFF") == 0) {
+        *clr = mask;
+    } else if (strcmp(word, "TOGGLE") == 0) {
+        *action = LED_SCHED_TOGGLE;
+        *set = mask;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Interpreta la acción de un comando SCHED.
  *
- * Recibe frames WebSocket de tipo texto con comandos simples:
+ * Misma sintaxis que los comandos inmediatos: "ON", "OFF", "TOGGLE",
+ * "CH:<n>:ON|OFF|TOGGLE", "MASK:<set>:<clear>" y "ALL:ON|OFF".
+ */
+static bool ws_sched_parse_action(const char *spec, led_sched_action_t *action,
+                                  uint16_t *set, uint16_t *clr)
+{
+    char *end;
+
+    if (strncmp(spec, "CH:", 3) == 0) {
+        long channel = strtol(spec + 3, &end, 10);
+        if (*end != ':' || channel < 0 || channel >= led_control_get_channel_count()) {
+            return false;
+        }
+        return ws_sched_word(end + 1, 1UL << channel, action, set, clr);
+    }
+    if (strncmp(spec, "MASK:", 5) == 0) {
+        *set = strtoul(spec + 5, &end, 0);
+        if (*end != ':') {
+            return false;
+        }
+        *clr = strtoul(end + 1, &end, 0);
+        *action = LED_SCHED_APPLY;
+        return *end == '\0';
+    }
+    if (strncmp(spec, "ALL:", 4) == 0) {
+        return strcmp(spec + 4, "TOGGLE") != 0 &&
+               ws_sched_word(spec + 4, led_control_get_all_mask(), action, set, clr);
+    }
+    return ws_sched_word(spec, 1UL << LED_CONTROL_LED_CHANNEL, action, set, clr);
+}
+
+/**
+ * @brief Milisegundos hasta la próxima hora local HH:MM (0 si no hay hora).
+ */
+static uint32_t ws_sched_ms_until(int hour, int minute)
+{
+    time_t now = time(NULL);
+    struct tm local;
+    localtime_r(&now, &local);
+    if (local.tm_year + 1900 < WS_SCHED_MIN_VALID_YEAR) {
+        return 0;
+    }
+
+    int now_s = local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+    int due_s = hour * 3600 + minute * 60;
+    if (due_s <= now_s) {
+        due_s += 24 * 3600;
+    }
+    return (uint32_t)(due_s - now_s) * 1000;
+}
+
+/**
+ * @brief Ejecuta los comandos del planificador.
+ *
+ *  - "SCHED:IN:<ms>:<acción>"     -> acción dentro de <ms> milisegundos
+ *  - "SCHED:AT:<HH>:<MM>:<acción>" -> acción a la próxima HH:MM local (SNTP)
+ *  - "SCHED:PULSE:<ms>[:<canal>]" -> enciende ya y apaga tras <ms>
+ *  - "SCHED:CANCEL:<id>"          -> cancela un trabajo
+ *  - "SCHED:CLEAR"                -> cancela todos
+ *  - "SCHED:LIST"                 -> lista los trabajos pendientes
+ *
+ * La acción usa la sintaxis de ws_sched_parse_action(). Las altas
+ * responden "SCHED:OK;ID=0x<id>;DUE=<ms>"; un error responde
+ * "ERROR:<cmd>".
+ *
+ * @return true si el comando empieza por "SCHED:" (respuesta ya escrita).
+ */
+static bool ws_sched_command(const char *cmd, char *response, size_t len)
+{
+    if (strncmp(cmd, "SCHED:", 6) != 0) {
+        return false;
+    }
+
+    const char *args = cmd + 6;
+    char *end;
+    uint32_t delay_ms = 0;
+    led_sched_action_t action;
+    uint16_t set = 0, clr = 0;
+    led_sched_id_t id;
+    bool ok = false;
+    long pulse_channel = -1;      /* PULSE: canal encendido antes del alta */
+    bool pulse_was_on = false;
+
+    if (strcmp(args, "LIST") == 0) {
+        ws_sched_list(response, len);
+        return true;
+    } else if (strcmp(args, "CLEAR") == 0) {
+        led_sched_cancel_all();
+        snprintf(response, len, "SCHED:OK;N=0");
+        return true;
+    } else if (strncmp(args, "CANCEL:", 7) == 0) {
+        id = strtoul(args + 7, &end, 0);
+        if (*end == '\0' && led_sched_cancel(id) == ESP_OK) {
+            snprintf(response, len, "SCHED:OK;N=%u", (unsigned)led_sched_count());
+            return true;
+        }
+    } else if (strncmp(args, "IN:", 3) == 0) {
+        delay_ms = strtoul(args + 3, &end, 10);
+        ok = *end == ':' && ws_sched_parse_action(end + 1, &action, &set, &clr);
+    } else if (strncmp(args, "AT:", 3) == 0) {
+        long hour = strtol(args + 3, &end, 10);
+        if (*end == ':' && hour >= 0 && hour < 24) {
+            long minute = strtol(end + 1, &end, 10);
+            if (*end == ':' && minute >= 0 && minute < 60) {
+                delay_ms = ws_sched_ms_until(hour, minute);
+                ok = delay_ms > 0 && ws_sched_parse_action(end + 1, &action, &set, &clr);
+            }
+        }
+    } else if (strncmp(args, "PULSE:", 6) == 0) {
+        delay_ms = strtoul(args + 6, &end, 10);
+        long channel = LED_CONTROL_LED_CHANNEL;
+        if (*end == ':') {
+            channel = strtol(end + 1, &end, 10);
+        }
+        if (*end == '\0' && delay_ms > 0 && channel >= 0 &&
+            channel < led_control_get_channel_count()) {
+            action = LED_SCHED_APPLY;
+            clr = 1UL << channel;
+            /* Se enciende antes del alta para que un pulso corto no se
+             * apague antes de encenderse; si el alta falla, se deshace */
+            pulse_channel = channel;
+            pulse_was_on = led_control_get_channel(channel);
+            led_control_set_channel(channel, true);
+            ok = true;
+        }
+    }
+
+    if (ok && led_sched_add(delay_ms, action, set, clr, &id) == ESP_OK) {
+        ESP_LOGI(TAG, "Programado 0x%08lX en %lu ms", (unsigned long)id, (unsigned long)delay_ms);
+        snprintf(response, len, "SCHED:OK;ID=0x%08lX;DUE=%lu",
+                 (unsigned long)id, (unsigned long)delay_ms);
+        return true;
+    }
+
+    if (pulse_channel >= 0) {
+        led_control_set_channel(pulse_channel, pulse_was_on);
+    }
+    ESP_LOGW(TAG, "Comando SCHED inválido: %s", cmd);
+    snprintf(response, len, "ERROR:%s", cmd);
+    return true;
+}
+
+/**
+ * @brief Respuesta de "SCENE:LIST" / "GROUP:LIST".
+ *
+ * "SCENE:LIST;N=<n>;S=<nombre>,<set>,<clear>..." y
+ * "GROUP:LIST;N=<n>;G=<nombre>,<mask>...".
+ */
+static void ws_scene_list(bool groups, char *response, size_t len)
+{
+    size_t count = groups ? led_group_count() : led_scene_count();
+    int n = snprintf(response, len, "%s:LIST;N=%u", groups ? "GROUP" : "SCENE", (unsigned)count);
+
+    for (size_t i = 0; i < count && n > 0 && (size_t)n < len; i++) {
+        if (groups) {
+            led_group_t g;
+            if (led_group_get(i, &g)) {
+                n += snprintf(response + n, len - n, ";G=%s,0x%04X", g.name, g.mask);
+            }
+        } else {
+            led_scene_t sc;
+            if (led_scene_get(i, &sc)) {
+                n += snprintf(response + n, len - n, ";S=%s,0x%04X,0x%04X",
+                              sc.name, sc.set_mask, sc.clear_mask);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Copia en `out` el campo hasta el siguiente ':' (o el final).
+ * @return Puntero al separador/terminador tras el campo, o NULL si no cabe.
+ */
+static const char *ws_copy_field(const char *src, char *out, size_t out_len)
+{
+    size_t field_len = strcspn(src, ":");
+    if (field_len == 0 || field_len >= out_len) {
+        return NULL;
+    }
+    memcpy(out, src, field_len);
+    out[field_len] = '\0';
+    return src + field_len;
+}
+
+/**
+ * @brief Ejecuta los comandos de escenas y grupos.
+ *
+ *  - "SCENE:<nombre>"                       -> aplica la escena (una transición)
+ *  - "SCENE:SET:<nombre>:<set>:<clear>"     -> crea/sustituye y guarda en NVS
+ *  - "SCENE:DEL:<nombre>"                   -> borra
+ *  - "GROUP:SET:<nombre>:<mask>"            -> crea/sustituye y guarda en NVS
+ *  - "GROUP:DEL:<nombre>"                   -> borra
+ *  - "GROUP:<nombre>:ON|OFF|TOGGLE"         -> actúa sobre todo el grupo
+ *
+ * Aplicar una escena o actuar sobre un grupo notifica además el nuevo
+ * estado a todos los clientes /ws (un único envío).
+ * @return true si el comando era válido.
+ */
+static bool ws_scene_command(const char *cmd)
+{
+    char name[LED_SCENE_NAME_MAX];
+    const char *p;
+    char *end;
+
+    if (strncmp(cmd, "SCENE:SET:", 10) == 0) {
+        if ((p = ws_copy_field(cmd + 10, name, sizeof(name))) == NULL || *p != ':') {
+            return false;
+        }
+        uint32_t set = strtoul(p + 1, &end, 0);
+        if (*end != ':') {
+            return false;
+        }
+        uint32_t clear = strtoul(end + 1, &end, 0);
+        return *end == '\0' && led_scene_define(name, set, clear) == ESP_OK;
+    }
+    if (strncmp(cmd, "SCENE:DEL:", 10) == 0) {
+        return led_scene_delete(cmd + 10) == ESP_OK;
+    }
+    if (strncmp(cmd, "SCENE:", 6) == 0) {
+        if (led_scene_apply(cmd + 6, NULL) != ESP_OK) {
+            return false;
+        }
+        websocket_server_notify_state();
+        return true;
+    }
+
+    if (strncmp(cmd, "GROUP:SET:", 10) == 0) {
+        if ((p = ws_copy_field(cmd + 10, name, sizeof(name))) == NULL || *p != ':') {
+            return false;
+        }
+        uint32_t mask = strtoul(p + 1, &end, 0);
+        return *end == '\0' && led_group_define(name, mask) == ESP_OK;
+    }
+    if (strncmp(cmd, "GROUP:DEL:", 10) == 0) {
+        return led_group_delete(cmd + 10) == ESP_OK;
+    }
+    if (strncmp(cmd, "GROUP:", 6) == 0) {
+        uint16_t mask;
+        if ((p = ws_copy_field(cmd + 6, name, sizeof(name))) == NULL || *p != ':' ||
+            led_group_find(name, &mask) != ESP_OK) {
+            return false;
+        }
+        const char *action = p + 1;
+        if (strcmp(action, "ON") == 0) {
+            led_control_apply_mask(mask, 0);
+        } else if (strcmp(action, "OFF") == 0) {
+            led_control_apply_mask(0, mask);
+        } else if (strcmp(action, "TOGGLE") == 0) {
+            led_control_toggle_mask(mask);
+        } else {
+            return false;
+        }
+        websocket_server_notify_state();
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Ejecuta los comandos de la tira WS2812.
+ *
+ *  - "PX:FILL:<RRGGBB[WW]>" -> rellena la tira con un color y la muestra
+ *  - "PX:CLEAR"             -> apaga todos los píxeles
+ *  - "PX:BRIGHT:<0..255>"   -> brillo global (tabla gamma/brillo)
+ *  - "PX:STATS"             -> solo responde
+ *
+ * Las tramas completas se suben como frame binario "PXF1". Responde
+ * "PX:OK;N=<píxeles>;BRIGHT=<b>;F=<tramas>;WAIT=<esperas>;TO=<timeouts>".
+ *
+ * @return true si el comando empieza por "PX:" (respuesta ya escrita).
+ */
+static bool ws_pixel_command(const char *cmd, char *response, size_t len)
+{
+    if (strncmp(cmd, "PX:", 3) != 0) {
+        return false;
+    }
+
+    const char *args = cmd + 3;
+    char *end;
+    esp_err_t ret = ESP_OK;
+
+    if (strncmp(args, "FILL:", 5) == 0) {
+        size_t digits = strlen(args + 5);
+        uint32_t color = strtoul(args + 5, &end, 16);
+        if (*end != '\0' || (digits != 6 && digits != 8)) {
+            ret = ESP_ERR_INVALID_ARG;
+        } else {
+            if (digits == 6) {
+                color <<= 8;
+            }
+            ws2812_fill(color >> 24, color >> 16, color >> 8, color);
+            ret = ws2812_show();
+        }
+    } else if (strcmp(args, "CLEAR") == 0) {
+        ws2812_fill(0, 0, 0, 0);
+        ret = ws2812_show();
+    } else if (strncmp(args, "BRIGHT:", 7) == 0) {
+        unsigned long brightness = strtoul(args + 7, &end, 10);
+        if (*end != '\0' || brightness > 255) {
+            ret = ESP_ERR_INVALID_ARG;
+        } else {
+            ws2812_set_brightness(brightness);
+            ret = ws2812_show();
+        }
+    } else if (strcmp(args, "STATS") != 0) {
+        ret = ESP_ERR_INVALID_ARG;
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Comando PX fallido (%s): %s", esp_err_to_name(ret), cmd);
+        snprintf(response, len, "ERROR:%s", cmd);
+        return true;
+    }
+
+    ws2812_stats_t st;
+    ws2812_get_stats(&st);
+    snprintf(response, len, "PX:OK;N=%u;BRIGHT=%u;F=%lu;WAIT=%lu;TO=%lu",
+             (unsigned)ws2812_get_pixel_count(), ws2812_get_brightness(),
+             (unsigned long)st.frames, (unsigned long)st.busy_waits,
+             (unsigned long)st.timeouts);
+    return true;
+}
+
+/**
+ * @brief Ejecuta los comandos del motor de reglas.
+ *
+ *  - "RULE:ADD:<nombre>:<fuente>" -> compila, activa y guarda en NVS
+ *  - "RULE:DEL:<nombre>"          -> borra
+ *  - "RULE:LIST"                  -> "RULE:LIST;N=<n>" seguido de
+ *    ";R=<nombre>,<estado>,<evals>,<then>,<else>,<ciclos med>,<ciclos máx>,<bytes>"
+ *
+ * Un alta correcta responde "RULE:OK;N=<reglas activas>"; un error de compilación
+ * responde "ERROR:RULE;<motivo>".
+ *
+ * @return true si el comando empieza por "RULE:" (respuesta ya escrita).
+ */
+static bool ws_rule_command(const char *cmd, char *response, size_t len)
+{
+    if (strncmp(cmd, "RULE:", 5) != 0) {
+        return false;
+    }
+
+    const char *args = cmd + 5;
+    char name[RULES_NAME_MAX];
+    const char *p;
+
+    if (strcmp(args, "LIST") == 0) {
+        static rules_stats_t stats[RULES_MAX];
+        size_t count = rules_get_stats(stats, RULES_MAX);
+        int n = snprintf(response, len, "RULE:LIST;N=%u", (unsigned)count);
+        for (size_t i = 0; i < count && n > 0 && (size_t)n < len; i++) {
+            n += snprintf(response + n, len - n, ";R=%s,%d,%lu,%lu,%lu,%lu,%lu,%u",
+                          stats[i].name, stats[i].state,
+                          (unsigned long)stats[i].evaluations,
+                          (unsigned long)stats[i].then_runs,
+                          (unsigned long)stats[i].else_runs,
+                          (unsigned long)stats[i].avg_cycles,
+                          (unsigned long)stats[i].max_cycles,
+                          (unsigned)stats[i].code_size);
+        }
+        return true;
+    }
+    if (strncmp(args, "DEL:", 4) == 0) {
+        if (rules_remove(args + 4) == ESP_OK) {
+            snprintf(response, len, "RULE:OK");
+            return true;
+        }
+    } else if (strncmp(args, "ADD:", 4) == 0) {
+        char err[64] = "";
+        if ((p = ws_copy_field(args + 4, name, sizeof(name))) == NULL || *p != ':') {
+            snprintf(response, len, "ERROR:RULE;nombre inválido");
+            return true;
+        }
+        if (rules_add(name, p + 1, err, sizeof(err)) == ESP_OK) {
+            snprintf(response, len, "RULE:OK;N=%u", (unsigned)rules_get_stats(NULL, 0));
+        } else {
+            ESP_LOGW(TAG, "Regla '%s' rechazada: %s", name, err);
+            snprintf(response, len, "ERROR:RULE;%s", err);
+        }
+        return true;
+    }
+
+    snprintf(response, len, "ERROR:%s", cmd);
+    return true;
+}
+
+/**
+ * @brief Ejecuta el comando BENCH[:<nombre>[:<iteraciones>]].
+ *
+ * Sin nombre (o con "*") ejecuta todos los benchmarks registrados.
+ * El resultado se escribe en `response` como JSON.
+ */
+static void ws_run_bench(const char *args, char *response, size_t len)
+{
+    char name[32] = "";
+    uint32_t iterations = WS_BENCH_DEFAULT_ITERATIONS;
+
+    if (args != NULL && *args != '\0') {
+        const char *sep = strchr(args, ':');
+        size_t name_len = sep ? (size_t)(sep - args) : strlen(args);
+        if (name_len >= sizeof(name)) {
+            name_len = sizeof(name) - 1;
+        }
+        memcpy(name, args, name_len);
+        name[name_len] = '\0';
+        if (sep) {
+            iterations = strtoul(sep + 1, NULL, 10);
+        }
+    }
+
+    bench_result_t results[BENCH_MAX_ENTRIES];
+    const char *filter = (name[0] == '\0' || strcmp(name, "*") == 0) ? NULL : name;
+    size_t count = bench_run(filter, iterations, results, BENCH_MAX_ENTRIES);
+
+    if (count == 0) {
+        snprintf(response, len, "ERROR:BENCH desconocido");
+    } else if (bench_format_json(results, count, response, len) < 0) {
+        snprintf(response, len, "ERROR:BENCH respuesta demasiado larga");
+    }
+}
+
+/**
+ * @brief Procesa un comando de texto y escribe la respuesta.
+ *
+ * Comandos (case-sensitive):
  *  - "ON"     -> enciende el LED
  *  - "OFF"    -> apaga el LED
  *  - "TOGGLE" -> alterna el estado del LED
  *  - "STATUS" -> solicita el estado actual (sin cambiarlo)
+ *  - "CH:..", "MASK:..", "ALL:.." -> canales y grupos (ver ws_channel_command)
+ *  - "PWM:..", "BRIGHT:..", "FADE:.." -> brillo PWM (ver ws_pwm_command)
+ *  - "FX:.."  -> efectos de LED (ver ws_effect_command)
+ *  - "TL:.."  -> timelines (ver ws_timeline_command); "TL:STATS" responde
+ *    con las estadísticas de reproducción
+ *  - "SCHED:.." -> acciones diferidas (ver ws_sched_command), con
+ *    respuesta propia
+ *  - "SCENE:..", "GROUP:.." -> escenas y grupos (ver ws_scene_command);
+ *    "SCENE:LIST" y "GROUP:LIST" responden con las tablas
+ *  - "RULE:.." -> reglas locales (ver ws_rule_command), con respuesta propia
+ *  - "PX:.." -> tira WS2812 (ver ws_pixel_command), con respuesta propia
+ *  - "OLED:STATS" -> métricas del ritmo de tramas de la pantalla
+ *  - "OLED:TUNE" -> calibra la velocidad I2C de la pantalla en segundo
+ *    plano: responde "OLED:TUNE;STARTED" y difunde después
+ *    "OLED:TUNE;HZ=<velocidad>" (ver ws_oled_tune_start)
+ *  - "I2C:STATS" -> contabilidad del bus I2C por dispositivo
+ *  - "BENCH[:<nombre>[:<it>]]" -> ejecuta micro-benchmarks, responde JSON
+ *
+ * Salvo BENCH, TL:STATS, OLED:STATS, OLED:TUNE, I2C:STATS, SCHED, RULE, PX y los listados, responde con el estado (ver ws_build_status), p.ej.
+ * "LED:ENCENDIDO;MASK=0x0001;CH=4;VER=12". Un comando inválido (o un CAS
+ * con versión obsoleta) responde "ERROR:<cmd>".
+ *
+ * @param cmd      Comando terminado en NUL.
+ * @param response Buffer de respuesta.
+ * @param len      Tamaño de `response`.
+ */
+static void ws_dispatch_command(const char *cmd, char *response, size_t len)
+{
+    if (strcmp(cmd, "ON") == 0) {
+        ESP_LOGI(TAG, "Encendiendo LED");
+        led_control_set_state(true);
+    } else if (strcmp(cmd, "OFF") == 0) {
+        ESP_LOGI(TAG, "Apagando LED");
+        led_control_set_state(false);
+    } else if (strcmp(cmd, "TOGGLE") == 0) {
+        ESP_LOGI(TAG, "Toggle LED");
+        led_control_toggle();
+    } else if (strcmp(cmd, "STATUS") == 0) {
+        ESP_LOGI(TAG, "Solicitud de estado");
+        /* No cambiar estado, solo responder más abajo */
+    } else if (strncmp(cmd, "BENCH", 5) == 0 && (cmd[5] == '\0' || cmd[5] == ':')) {
+        ESP_LOGI(TAG, "Ejecutando benchmarks");
+        ws_run_bench(cmd[5] == ':' ? cmd + 6 : NULL, response, len);
+        return;
+    } else if (strcmp(cmd, "TL:STATS") == 0) {
+        ws_timeline_stats(response, len);
+        return;
+    } else if (strcmp(cmd, "OLED:STATS") == 0) {
+        ws_oled_stats(response, len);
+        return;
+    } else if (strcmp(cmd, "OLED:TUNE") == 0) {
+        ws_oled_tune_start(response, len);
+        return;
+    } else if (strcmp(cmd, "I2C:STATS") == 0) {
+        ws_i2c_stats(response, len);
+        return;
+    } else if (ws_sched_command(cmd, response, len)) {
+        return;
+    } else if (ws_rule_command(cmd, response, len)) {
+        return;
+    } else if (ws_pixel_command(cmd, response, len)) {
+        return;
+    } else if (strcmp(cmd, "SCENE:LIST") == 0 || strcmp(cmd, "GROUP:LIST") == 0) {
+        ws_scene_list(cmd[0] == 'G', response, len);
+        return;
+    } else if (!ws_channel_command(cmd) && !ws_pwm_command(cmd) && !ws_effect_command(cmd) &&
+               !ws_timeline_command(cmd) && !ws_scene_command(cmd)) {
+        ESP_LOGW(TAG, "Comando desconocido: %s", cmd);
+        snprintf(response, len, "ERROR:%s", cmd);
+        return;
+    }
+
+    /* Construir respuesta con estado actual */
+    ws_build_status(response, len);
+}
+
+/// Maneja los mensajes WebSocket
+/**
+ * @brief Handler para el endpoint WebSocket (/ws).
+ *
+ * Recibe frames WebSocket de tipo texto con comandos simples y los
+ * delega en ws_dispatch_command(); los frames binarios (timelines) van a
+ * ws_dispatch_binary(). En ambos casos devuelve una respuesta de texto.
  *
- * Responde con un mensaje de texto en formato "LED:ENCENDIDO" o "LED:APAGADO".
+ * Los frames llegan a un buffer estático (el servidor atiende los
+ * handlers desde una sola tarea) y los logs por frame son de nivel
+ * DEBUG: con tramas de píxeles a 60 fps, reservar memoria y escribir por
+ * la UART en cada una limitaría el ritmo.
  *
  * @param req Petición HTTP (WebSocket)
  * @return esp_err_t ESP_OK siempre que el handler procese correctamente la petición
@@ -126,7 +1164,8 @@ static esp_err_t handle_ws_req(httpd_req_t *req)
         return ESP_OK;
     }
 
-    ESP_LOGI(TAG, "Mensaje WebSocket recibido");
+    /* Payload + NUL; solo lo usa la tarea de httpd */
+    static uint8_t s_rx_buf[WS_BINARY_MAX + 1];
 
     httpd_ws_frame_t ws_pkt;
     memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
@@ -138,56 +1177,38 @@ static esp_err_t handle_ws_req(httpd_req_t *req)
         return ret;
     }
 
-    ESP_LOGI(TAG, "Frame type: %d, len: %d", ws_pkt.type, ws_pkt.len);
+    ESP_LOGD(TAG, "Frame type: %d, len: %d", ws_pkt.type, ws_pkt.len);
 
-    if (ws_pkt.type == HTTPD_WS_TYPE_TEXT && ws_pkt.len > 0) {
-        /* Reservar buffer para payload + NUL terminator */
-        uint8_t *buf = calloc(1, ws_pkt.len + 1);
-        if (buf == NULL) {
-            ESP_LOGE(TAG, "Error al asignar memoria");
-            return ESP_ERR_NO_MEM;
-        }
+    bool is_text = (ws_pkt.type == HTTPD_WS_TYPE_TEXT);
+    bool is_binary = (ws_pkt.type == HTTPD_WS_TYPE_BINARY);
+    if ((is_text || is_binary) && ws_pkt.len > WS_BINARY_MAX) {
+        ESP_LOGW(TAG, "Frame demasiado grande: %d", ws_pkt.len);
+        return ESP_ERR_INVALID_SIZE;
+    }
 
+    if ((is_text || is_binary) && ws_pkt.len > 0) {
+        uint8_t *buf = s_rx_buf;
         ws_pkt.payload = buf;
 
         /* Leer payload completo */
         ret = httpd_ws_recv_frame(req, &ws_pkt, ws_pkt.len);
         if (ret != ESP_OK) {
             ESP_LOGE(TAG, "Error al recibir payload: %s", esp_err_to_name(ret));
-            free(buf);
             return ret;
         }
 
-        /* Asegurar terminador NUL */
-        buf[ws_pkt.len] = '\0';
-        ESP_LOGI(TAG, "Comando recibido: %s", (char*)buf);
-
-        /* Procesar comando (comparaciones sencillas, case-sensitive) */
-        if (strcmp((char*)buf, "ON") == 0) {
-            ESP_LOGI(TAG, "Encendiendo LED");
-            led_control_set_state(true);
-        } else if (strcmp((char*)buf, "OFF") == 0) {
-            ESP_LOGI(TAG, "Apagando LED");
-            led_control_set_state(false);
-        } else if (strcmp((char*)buf, "TOGGLE") == 0) {
-            ESP_LOGI(TAG, "Toggle LED");
-            led_control_toggle();
-        } else if (strcmp((char*)buf, "STATUS") == 0) {
-            ESP_LOGI(TAG, "Solicitud de estado");
-            /* No cambiar estado, solo responder más abajo */
+        char response[WS_RESPONSE_MAX];
+        if (is_text) {
+            /* Asegurar terminador NUL */
+            buf[ws_pkt.len] = '\0';
+            ESP_LOGD(TAG, "Comando recibido: %s", (char*)buf);
+            ws_dispatch_command((char*)buf, response, sizeof(response));
         } else {
-            ESP_LOGW(TAG, "Comando desconocido: %s", (char*)buf);
+            ESP_LOGD(TAG, "Frame binario recibido: %d bytes", ws_pkt.len);
+            ws_dispatch_binary(buf, ws_pkt.len, response, sizeof(response));
         }
 
-        free(buf);
-
-        /* Construir respuesta con estado actual */
-        bool led_state = led_control_get_state();
-        const char* estado = led_state ? "ENCENDIDO" : "APAGADO";
-        char response[50];
-        snprintf(response, sizeof(response), "LED:%s", estado);
-
-        ESP_LOGI(TAG, "Enviando estado: %s", response);
+        ESP_LOGD(TAG, "Enviando estado: %s", response);
 
         httpd_ws_frame_t resp_pkt = {
             .final = true,
@@ -201,10 +1222,16 @@ static esp_err_t handle_ws_req(httpd_req_t *req)
         if (ret != ESP_OK) {
             ESP_LOGE(TAG, "Error enviando respuesta: %s", esp_err_to_name(ret));
         } else {
-            ESP_LOGI(TAG, "Respuesta enviada correctamente");
+            ESP_LOGD(TAG, "Respuesta enviada correctamente");
+#if CONFIG_WSLED_BENCH_MARKERS
+            if (!s_first_cmd_marked) {
+                s_first_cmd_marked = true;
+                bench_mark("first_ws_cmd");
+            }
+#endif
         }
     } else {
-        ESP_LOGW(TAG, "Frame no es de texto o está vacío");
+        ESP_LOGW(TAG, "Frame no es de texto/binario o está vacío");
     }
 
     return ESP_OK;
@@ -265,6 +1292,25 @@ static httpd_handle_t start_webserver(void)
     return NULL;
 }
 
+/**
+ * @brief Arranca SNTP (una sola vez) y fija la zona horaria local.
+ *
+ * La hora local solo la necesita "SCHED:AT"; hasta la primera
+ * sincronización ese comando responde error.
+ */
+static void sntp_start_once(void)
+{
+    if (esp_sntp_enabled()) {
+        return;
+    }
+    setenv("TZ", CONFIG_WSLED_TIMEZONE, 1);
+    tzset();
+    esp_sntp_setoperatingmode(SNTP_OPMODE_POLL);
+    esp_sntp_setservername(0, CONFIG_WSLED_SNTP_SERVER);
+    esp_sntp_init();
+    ESP_LOGI(TAG, "SNTP iniciado (%s, TZ=%s)", CONFIG_WSLED_SNTP_SERVER, CONFIG_WSLED_TIMEZONE);
+}
+
 // WiFi event handler (igual que antes)
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                                 int32_t event_id, void* event_data)
@@ -277,14 +1323,58 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "Conectado a WiFi! IP: " IPSTR, IP2STR(&event->ip_info.ip));
+        bench_mark("got_ip");
+        sntp_start_once();
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_ETH_GOT_IP) {
+        ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
+        ESP_LOGI(TAG, "Ethernet conectado! IP: " IPSTR, IP2STR(&event->ip_info.ip));
+        bench_mark("got_ip");
+        sntp_start_once();
     }
 }
 
+#if CONFIG_WSLED_NET_OPENETH
+/**
+ * @brief Arranca la interfaz Ethernet OpenCores emulada por QEMU.
+ *
+ * Sustituye a la conexión WiFi cuando el firmware se ejecuta en el
+ * emulador; la IP se obtiene por DHCP de la red "user" de QEMU.
+ */
+static void eth_init_openeth(void)
+{
+    esp_netif_config_t netif_cfg = ESP_NETIF_DEFAULT_ETH();
+    esp_netif_t *eth_netif = esp_netif_new(&netif_cfg);
+
+    eth_mac_config_t mac_config = ETH_MAC_DEFAULT_CONFIG();
+    eth_phy_config_t phy_config = ETH_PHY_DEFAULT_CONFIG();
+    phy_config.phy_addr = 1;
+    phy_config.reset_gpio_num = -1;
+    phy_config.autonego_timeout_ms = 100;
+
+    esp_eth_mac_t *mac = esp_eth_mac_new_openeth(&mac_config);
+    esp_eth_phy_t *phy = esp_eth_phy_new_dp83848(&phy_config);
+
+    esp_eth_config_t eth_config = ETH_DEFAULT_CONFIG(mac, phy);
+    esp_eth_handle_t eth_handle = NULL;
+    ESP_ERROR_CHECK(esp_eth_driver_install(&eth_config, &eth_handle));
+    ESP_ERROR_CHECK(esp_netif_attach(eth_netif, esp_eth_new_netif_glue(eth_handle)));
+    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_ETH_GOT_IP, &wifi_event_handler, NULL));
+    ESP_ERROR_CHECK(esp_eth_start(eth_handle));
+
+    ESP_LOGI(TAG, "Ethernet OpenCores (QEMU) inicializado");
+}
+#endif
+
 
 void wifi_init_sta(void)
 {
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
+
+#if CONFIG_WSLED_NET_OPENETH
+    /* En QEMU no hay radio: usar el MAC Ethernet emulado */
+    eth_init_openeth();
+#else
     esp_netif_create_default_wifi_sta();
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
@@ -305,14 +1395,119 @@ void wifi_init_sta(void)
     ESP_ERROR_CHECK(esp_wifi_start());
 
     ESP_LOGI(TAG, "WiFi inicializado en modo STA");
+#endif
+}
+
+/* Micro-benchmarks del servidor ----------------------------------------- */
+
+/* Despacho completo de un comando que no modifica el estado */
+static void bench_ws_dispatch(void *arg)
+{
+    static char response[WS_RESPONSE_MAX];
+    ws_dispatch_command("STATUS", response, sizeof(response));
+}
+
+/* Codificación de la respuesta de estado */
+static void bench_status_encode(void *arg)
+{
+    char response[64];
+    ws_build_status(response, sizeof(response));
+}
+
+/* Lectura por bloques de index.html, igual que serve_file() sin la red */
+static void bench_serve_file_chunks(void *arg)
+{
+    static char buffer[512];
+    FILE *file = fopen("/spiffs/index.html", "rb");
+    if (!file) {
+        return;
+    }
+    while (fread(buffer, 1, sizeof(buffer), file) > 0) {
+    }
+    fclose(file);
 }
 
 void start_websocket_server(void)
 {
+    bench_register("ws_dispatch", bench_ws_dispatch, NULL);
+    bench_register("status_encode", bench_status_encode, NULL);
+    bench_register("serve_file_chunks", bench_serve_file_chunks, NULL);
+
     server = start_webserver();
     if (server == NULL) {
         ESP_LOGE(TAG, "Error al iniciar servidor WebSocket");
+        return;
+    }
+    bench_mark("ws_server_started");
+}
+
+/* Broadcast a los clientes /ws ------------------------------------------ */
+
+/* Evita encolar más de una notificación de estado a la vez */
+static volatile bool s_notify_pending = false;
+
+/**
+ * @brief Envía un texto a todos los clientes WebSocket (en la tarea httpd).
+ * @param arg Copia del texto en heap (se libera aquí) o NULL para enviar el
+ *            estado actual (ver ws_build_status).
+ */
+static void ws_broadcast_work(void *arg)
+{
+    static char status[WS_RESPONSE_MAX];
+    char *msg = arg;
+
+    if (msg == NULL) {
+        s_notify_pending = false;
+        ws_build_status(status, sizeof(status));
+    }
+
+    int fds[WS_MAX_CLIENTS];
+    size_t count = WS_MAX_CLIENTS;
+    if (httpd_get_client_list(server, &count, fds) == ESP_OK) {
+        httpd_ws_frame_t frame = {
+            .type = HTTPD_WS_TYPE_TEXT,
+            .payload = (uint8_t *)(msg ? msg : status),
+            .len = strlen(msg ? msg : status),
+        };
+        for (size_t i = 0; i < count; i++) {
+            if (httpd_ws_get_fd_info(server, fds[i]) == HTTPD_WS_CLIENT_WEBSOCKET) {
+                httpd_ws_send_frame_async(server, fds[i], &frame);
+            }
+        }
+    }
+    free(msg);
+}
+
+esp_err_t websocket_server_broadcast(const char *text)
+{
+    if (server == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    char *copy = strdup(text);
+    if (copy == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t ret = httpd_queue_work(server, ws_broadcast_work, copy);
+    if (ret != ESP_OK) {
+        free(copy);
+    }
+    return ret;
+}
+
+esp_err_t websocket_server_notify_state(void)
+{
+    if (server == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_notify_pending) {
+        return ESP_OK;
+    }
+    s_notify_pending = true;
+    esp_err_t ret = httpd_queue_work(server, ws_broadcast_work, NULL);
+    if (ret != ESP_OK) {
+        s_notify_pending = false;
     }
+    return ret;
 }
 
 static char s_ip_str[16];
@@ -320,8 +1515,8 @@ static char s_ip_str[16];
 const char* websocket_server_get_ip(void)
 {
     esp_netif_ip_info_t ip_info;
-    // Obtener handle del netif STA por su key por defecto
-    esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    // Obtener handle del netif (STA o Ethernet en QEMU) por su key por defecto
+    esp_netif_t *netif = esp_netif_get_handle_from_ifkey(NETIF_IFKEY);
     if (netif && esp_netif_get_ip_info(netif, &ip_info) == ESP_OK) {
         snprintf(s_ip_str, sizeof(s_ip_str), IPSTR, IP2STR(&ip_info.ip));
         return s_ip_str;
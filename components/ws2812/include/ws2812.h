@@ -0,0 +1,106 @@
+#ifndef WS2812_H
+#define WS2812_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "ws2812_encoder.h"
+
+/**
+ * @file ws2812.h
+ * @brief Tira de LEDs direccionables (WS2812 / SK6812) por RMT.
+ *
+ * Dos buffers de trama: las escrituras van al buffer de trabajo y
+ * ws2812_show() lo intercambia con el que se transmite, de modo que la
+ * siguiente trama se puede preparar mientras sale la anterior. Los
+ * símbolos RMT se generan por tramos desde el propio buffer de píxeles
+ * (ver ws2812_encoder.h), aplicando una tabla combinada de gamma y brillo.
+ *
+ * Formato binario de trama (little-endian), subido como frame WebSocket:
+ *
+ *   offset 0  char[4]  magic "PXF1"
+ *   offset 4  uint16   primer píxel
+ *   offset 6  uint16   número de píxeles
+ *   offset 8  píxeles R, G, B[, W] (ws2812_get_bytes_per_pixel() bytes cada uno)
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+/* -----------------------------
+ * Configuración
+ * ----------------------------- */
+#ifndef WS2812_GPIO
+#define WS2812_GPIO             8     /* LED RGB de las placas ESP32-C3-DevKitM */
+#endif
+#ifndef WS2812_NUM_PIXELS
+#define WS2812_NUM_PIXELS       60
+#endif
+#ifndef WS2812_STRIP_TYPE
+#define WS2812_STRIP_TYPE       WS2812_TYPE_WS2812
+#endif
+#define WS2812_MAX_PIXELS       256        /* Tamaño de los buffers de trama */
+#define WS2812_RESOLUTION_HZ    10000000   /* Tick RMT de 0,1 us */
+#define WS2812_GAMMA            2.2f
+#define WS2812_DEFAULT_BRIGHT   128
+#define WS2812_SHOW_TIMEOUT_MS  50         /* Espera máxima a la trama anterior */
+
+#define WS2812_FRAME_MAGIC        "PXF1"
+#define WS2812_FRAME_HEADER_SIZE  8
+
+/** Estadísticas de transmisión */
+typedef struct {
+    uint32_t frames;        /* Tramas enviadas */
+    uint32_t busy_waits;    /* ws2812_show() que esperaron a la trama anterior */
+    uint32_t timeouts;      /* Tramas descartadas por timeout */
+} ws2812_stats_t;
+
+/**
+ * @brief Crea el canal RMT y el codificador y apaga la tira.
+ * @return ESP_ERR_NOT_SUPPORTED si la versión de ESP-IDF no tiene el
+ *         codificador simple de RMT (< 5.3).
+ */
+esp_err_t ws2812_init(void);
+
+size_t ws2812_get_pixel_count(void);
+uint8_t ws2812_get_bytes_per_pixel(void);
+
+/**
+ * @brief Escribe un píxel en el buffer de trabajo (W se ignora en RGB).
+ */
+esp_err_t ws2812_set_pixel(size_t index, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
+
+/**
+ * @brief Rellena todo el buffer de trabajo con un color.
+ */
+void ws2812_fill(uint8_t r, uint8_t g, uint8_t b, uint8_t w);
+
+/**
+ * @brief Copia píxeles R, G, B[, W] al buffer de trabajo desde `first`.
+ */
+esp_err_t ws2812_write(size_t first, const uint8_t *data, size_t len);
+
+/**
+ * @brief Valida una trama binaria "PXF1", la copia y la muestra.
+ * @return ESP_OK, ESP_ERR_INVALID_ARG (formato) o ESP_ERR_INVALID_SIZE.
+ */
+esp_err_t ws2812_load_frame(const uint8_t *frame, size_t len);
+
+/**
+ * @brief Intercambia los buffers y transmite la trama.
+ *
+ * Si la anterior aún está saliendo espera como mucho
+ * WS2812_SHOW_TIMEOUT_MS (una trama de 256 píxeles tarda ~8 ms).
+ */
+esp_err_t ws2812_show(void);
+
+/**
+ * @brief Brillo global 0..255 (recalcula la tabla gamma/brillo).
+ */
+void ws2812_set_brightness(uint8_t brightness);
+uint8_t ws2812_get_brightness(void);
+
+void ws2812_get_stats(ws2812_stats_t *stats);
+
+#endif // WS2812_H
@@ -0,0 +1,76 @@
+#ifndef WS2812_ENCODER_H
+#define WS2812_ENCODER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file ws2812_encoder.h
+ * @brief Conversión de píxeles a símbolos RMT por tramos, sin buffer de
+ * símbolos de la trama completa.
+ *
+ * Cada byte de color se convierte en 8 símbolos (MSB primero) justo
+ * cuando el driver RMT necesita rellenar su memoria, aplicando al vuelo
+ * la tabla de gamma/brillo y el orden de colores de la tira. Un símbolo
+ * es un uint32_t con el formato de rmt_symbol_word_t:
+ * { duration0:15, level0:1, duration1:15, level1:1 }.
+ *
+ * No depende de ESP-IDF: compila también en el host.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+/** Tipos de tira soportados */
+typedef enum {
+    WS2812_TYPE_WS2812 = 0,   /* GRB, 3 bytes por píxel */
+    WS2812_TYPE_SK6812_RGBW,  /* GRBW, 4 bytes por píxel */
+} ws2812_type_t;
+
+/** Estado del codificador (solo lectura durante la transmisión) */
+typedef struct {
+    uint32_t bit0;            /* Símbolo de un bit 0 */
+    uint32_t bit1;            /* Símbolo de un bit 1 */
+    uint32_t reset;           /* Símbolo final (nivel bajo, latch) */
+    uint8_t bytes_per_pixel;  /* 3 o 4 */
+    uint8_t order[4];         /* Byte de salida i = canal order[i] del píxel (RGBW) */
+    const uint8_t *lut;       /* Gamma + brillo, 256 entradas (NULL = identidad) */
+} ws2812_encoder_t;
+
+/**
+ * @brief Construye un símbolo alto `high_ns` + bajo `low_ns`.
+ */
+uint32_t ws2812_make_symbol(uint32_t resolution_hz, uint32_t high_ns, uint32_t low_ns);
+
+/**
+ * @brief Prepara los símbolos y el orden de colores de un tipo de tira.
+ * @param resolution_hz Resolución del canal RMT (ticks por segundo).
+ */
+void ws2812_encoder_setup(ws2812_encoder_t *enc, ws2812_type_t type,
+                          uint32_t resolution_hz, const uint8_t *lut);
+
+/**
+ * @brief Símbolos de una trama de `data_size` bytes (incluido el reset).
+ */
+static inline size_t ws2812_encoder_total_symbols(size_t data_size)
+{
+    return data_size * 8 + 1;
+}
+
+/**
+ * @brief Escribe el siguiente tramo de símbolos.
+ *
+ * Misma firma lógica que rmt_encode_simple_cb_t: continúa en
+ * `symbols_written`, escribe como mucho `symbols_free` símbolos (siempre
+ * bytes completos) y marca `done` al escribir el reset.
+ *
+ * @param pixels    Píxeles en orden RGB[W], `bytes_per_pixel` por píxel.
+ * @param data_size Bytes de `pixels` (múltiplo de bytes_per_pixel).
+ * @return Símbolos escritos (0 si no cabe ni un byte).
+ */
+size_t ws2812_encoder_fill(const ws2812_encoder_t *enc, const uint8_t *pixels, size_t data_size,
+                           size_t symbols_written, size_t symbols_free,
+                           uint32_t *symbols, bool *done);
+
+#endif // WS2812_ENCODER_H
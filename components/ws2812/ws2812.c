@@ -0,0 +1,283 @@
+/**
+ * @file ws2812.c
+ * @brief Driver de la tira WS2812 / SK6812 sobre el driver RMT de TX.
+ *
+ * El codificador simple del RMT llama a ws2812_encoder_fill() cada vez que
+ * hay hueco en la memoria del canal: no existe un buffer de símbolos de
+ * la trama completa (32 veces mayor que los píxeles), solo el de píxeles.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#include "ws2812.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_idf_version.h"
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0)
+#include "driver/rmt_tx.h"
+#define WS2812_HAS_SIMPLE_ENCODER 1
+#else
+#define WS2812_HAS_SIMPLE_ENCODER 0
+#endif
+
+static const char *TAG = "WS2812";
+
+#define FRAME_BYTES  (WS2812_MAX_PIXELS * 4)
+
+/* Dos buffers: s_frames[s_back] se escribe, el otro se transmite */
+static uint8_t s_frames[2][FRAME_BYTES];
+static uint8_t s_back = 0;
+
+static uint8_t s_lut[256];
+static uint8_t s_brightness = WS2812_DEFAULT_BRIGHT;
+static ws2812_encoder_t s_enc;
+static ws2812_stats_t s_stats;
+
+static SemaphoreHandle_t s_mutex = NULL;
+
+#if WS2812_HAS_SIMPLE_ENCODER
+static rmt_channel_handle_t s_chan = NULL;
+static rmt_encoder_handle_t s_encoder = NULL;
+static bool s_tx_pending = false;
+#endif
+
+
+/* Funciones privadas ------------------------------------------------------ */
+
+static size_t frame_size(void)
+{
+    return (size_t)WS2812_NUM_PIXELS * s_enc.bytes_per_pixel;
+}
+
+/* Tabla combinada: salida = 255 * (v/255)^gamma * brillo/255 */
+static void build_lut(uint8_t brightness)
+{
+    for (int v = 0; v < 256; v++) {
+        float g = powf(v / 255.0f, WS2812_GAMMA) * brightness;
+        s_lut[v] = (uint8_t)(g + 0.5f);
+    }
+}
+
+#if WS2812_HAS_SIMPLE_ENCODER
+static size_t encode_cb(const void *data, size_t data_size, size_t symbols_written,
+                        size_t symbols_free, rmt_symbol_word_t *symbols, bool *done, void *arg)
+{
+    return ws2812_encoder_fill(arg, data, data_size, symbols_written, symbols_free,
+                               (uint32_t *)symbols, done);
+}
+
+/* Espera a que termine la trama en curso (con el mutex tomado) */
+static esp_err_t wait_tx_locked(void)
+{
+    if (!s_tx_pending) {
+        return ESP_OK;
+    }
+    esp_err_t ret = rmt_tx_wait_all_done(s_chan, 0);
+    if (ret == ESP_ERR_TIMEOUT) {
+        s_stats.busy_waits++;
+        ret = rmt_tx_wait_all_done(s_chan, WS2812_SHOW_TIMEOUT_MS);
+    }
+    if (ret == ESP_OK) {
+        s_tx_pending = false;
+    }
+    return ret;
+}
+#endif
+
+
+/* API pública ------------------------------------------------------------- */
+
+esp_err_t ws2812_init(void)
+{
+    _Static_assert(WS2812_NUM_PIXELS <= WS2812_MAX_PIXELS, "WS2812_NUM_PIXELS > WS2812_MAX_PIXELS");
+
+    if (s_mutex != NULL) {
+        return ESP_OK;
+    }
+
+#if WS2812_HAS_SIMPLE_ENCODER
+    _Static_assert(sizeof(rmt_symbol_word_t) == sizeof(uint32_t), "símbolo RMT de 32 bits");
+
+    build_lut(s_brightness);
+    ws2812_encoder_setup(&s_enc, WS2812_STRIP_TYPE, WS2812_RESOLUTION_HZ, s_lut);
+
+    s_mutex = xSemaphoreCreateMutex();
+    if (s_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    rmt_tx_channel_config_t chan_cfg = {
+        .gpio_num = WS2812_GPIO,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = WS2812_RESOLUTION_HZ,
+        .mem_block_symbols = 64,
+        .trans_queue_depth = 2,
+    };
+    esp_err_t ret = rmt_new_tx_channel(&chan_cfg, &s_chan);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error creando canal RMT: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    /* Bytes completos: el callback necesita al menos 8 símbolos libres */
+    rmt_simple_encoder_config_t enc_cfg = {
+        .callback = encode_cb,
+        .arg = &s_enc,
+        .min_chunk_size = 8,
+    };
+    ret = rmt_new_simple_encoder(&enc_cfg, &s_encoder);
+    if (ret == ESP_OK) {
+        ret = rmt_enable(s_chan);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error configurando RMT: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Tira de %d píxeles en GPIO %d (%u bytes/píxel)",
+             WS2812_NUM_PIXELS, WS2812_GPIO, s_enc.bytes_per_pixel);
+    return ws2812_show();
+#else
+    ESP_LOGW(TAG, "Se necesita ESP-IDF >= 5.3 (codificador simple de RMT)");
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+size_t ws2812_get_pixel_count(void)
+{
+    return WS2812_NUM_PIXELS;
+}
+
+uint8_t ws2812_get_bytes_per_pixel(void)
+{
+    return s_enc.bytes_per_pixel;
+}
+
+esp_err_t ws2812_set_pixel(size_t index, uint8_t r, uint8_t g, uint8_t b, uint8_t w)
+{
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (index >= WS2812_NUM_PIXELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const uint8_t px[4] = { r, g, b, w };
+    return ws2812_write(index, px, s_enc.bytes_per_pixel);
+}
+
+void ws2812_fill(uint8_t r, uint8_t g, uint8_t b, uint8_t w)
+{
+    const uint8_t px[4] = { r, g, b, w };
+    uint8_t bpp = s_enc.bytes_per_pixel;
+
+    if (s_mutex == NULL) {
+        return;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    uint8_t *buf = s_frames[s_back];
+    for (size_t i = 0; i < WS2812_NUM_PIXELS; i++) {
+        memcpy(&buf[i * bpp], px, bpp);
+    }
+    xSemaphoreGive(s_mutex);
+}
+
+esp_err_t ws2812_write(size_t first, const uint8_t *data, size_t len)
+{
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    size_t offset = first * s_enc.bytes_per_pixel;
+    if (data == NULL || offset + len > frame_size()) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    memcpy(&s_frames[s_back][offset], data, len);
+    xSemaphoreGive(s_mutex);
+    return ESP_OK;
+}
+
+esp_err_t ws2812_load_frame(const uint8_t *frame, size_t len)
+{
+    if (frame == NULL || len < WS2812_FRAME_HEADER_SIZE ||
+        memcmp(frame, WS2812_FRAME_MAGIC, 4) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t first = frame[4] | (frame[5] << 8);
+    size_t count = frame[6] | (frame[7] << 8);
+    if (len != WS2812_FRAME_HEADER_SIZE + count * s_enc.bytes_per_pixel) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t ret = ws2812_write(first, frame + WS2812_FRAME_HEADER_SIZE,
+                                 count * s_enc.bytes_per_pixel);
+    return ret == ESP_OK ? ws2812_show() : ret;
+}
+
+esp_err_t ws2812_show(void)
+{
+#if WS2812_HAS_SIMPLE_ENCODER
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+
+    /* El buffer que sale pasa a ser el de trabajo: hay que esperar a que
+     * el codificador termine de leerlo */
+    esp_err_t ret = wait_tx_locked();
+    if (ret != ESP_OK) {
+        s_stats.timeouts++;
+        xSemaphoreGive(s_mutex);
+        ESP_LOGW(TAG, "Trama descartada: RMT ocupado");
+        return ret;
+    }
+
+    uint8_t front = s_back;
+    s_back ^= 1;
+    /* El nuevo buffer de trabajo parte de la trama mostrada */
+    memcpy(s_frames[s_back], s_frames[front], frame_size());
+
+    const rmt_transmit_config_t tx_cfg = { .loop_count = 0 };
+    ret = rmt_transmit(s_chan, s_encoder, s_frames[front], frame_size(), &tx_cfg);
+    if (ret == ESP_OK) {
+        s_tx_pending = true;
+        s_stats.frames++;
+    }
+    xSemaphoreGive(s_mutex);
+    return ret;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void ws2812_set_brightness(uint8_t brightness)
+{
+    if (s_mutex == NULL) {
+        s_brightness = brightness;
+        return;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+#if WS2812_HAS_SIMPLE_ENCODER
+    /* La tabla se lee durante la codificación */
+    wait_tx_locked();
+#endif
+    s_brightness = brightness;
+    build_lut(brightness);
+    xSemaphoreGive(s_mutex);
+}
+
+uint8_t ws2812_get_brightness(void)
+{
+    return s_brightness;
+}
+
+void ws2812_get_stats(ws2812_stats_t *stats)
+{
+    *stats = s_stats;
+}
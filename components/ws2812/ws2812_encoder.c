@@ -0,0 +1,87 @@
+/**
+ * @file ws2812_encoder.c
+ * @brief Codificador píxeles -> símbolos RMT (ver ws2812_encoder.h).
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#include "ws2812_encoder.h"
+
+#define SYMBOL_DURATION_MAX  0x7FFFu
+#define RESET_NS             280000u   /* Latch: >= 280 us a nivel bajo (WS2812B V5) */
+
+/* Ticks de `ns` a `resolution_hz`, redondeado y al menos 1 */
+static uint32_t ns_to_ticks(uint32_t resolution_hz, uint32_t ns)
+{
+    uint64_t ticks = ((uint64_t)resolution_hz * ns + 500000000u) / 1000000000u;
+    if (ticks == 0) {
+        ticks = 1;
+    }
+    return ticks > SYMBOL_DURATION_MAX ? SYMBOL_DURATION_MAX : (uint32_t)ticks;
+}
+
+static uint32_t symbol(uint32_t d0, uint32_t l0, uint32_t d1, uint32_t l1)
+{
+    return (d0 & SYMBOL_DURATION_MAX) | (l0 << 15) | ((d1 & SYMBOL_DURATION_MAX) << 16) | (l1 << 31);
+}
+
+uint32_t ws2812_make_symbol(uint32_t resolution_hz, uint32_t high_ns, uint32_t low_ns)
+{
+    return symbol(ns_to_ticks(resolution_hz, high_ns), 1, ns_to_ticks(resolution_hz, low_ns), 0);
+}
+
+void ws2812_encoder_setup(ws2812_encoder_t *enc, ws2812_type_t type,
+                          uint32_t resolution_hz, const uint8_t *lut)
+{
+    /* Tiempos de la hoja de datos (ns): T0H/T0L y T1H/T1L */
+    if (type == WS2812_TYPE_SK6812_RGBW) {
+        enc->bit0 = ws2812_make_symbol(resolution_hz, 300, 900);
+        enc->bit1 = ws2812_make_symbol(resolution_hz, 600, 600);
+        enc->bytes_per_pixel = 4;
+    } else {
+        enc->bit0 = ws2812_make_symbol(resolution_hz, 400, 850);
+        enc->bit1 = ws2812_make_symbol(resolution_hz, 800, 450);
+        enc->bytes_per_pixel = 3;
+    }
+
+    /* Salida G, R, B[, W] a partir de píxeles R, G, B[, W] */
+    enc->order[0] = 1;
+    enc->order[1] = 0;
+    enc->order[2] = 2;
+    enc->order[3] = 3;
+
+    /* Reset en un solo símbolo: dos mitades a nivel bajo */
+    uint32_t half = ns_to_ticks(resolution_hz, RESET_NS / 2);
+    enc->reset = symbol(half, 0, half, 0);
+    enc->lut = lut;
+}
+
+size_t ws2812_encoder_fill(const ws2812_encoder_t *enc, const uint8_t *pixels, size_t data_size,
+                           size_t symbols_written, size_t symbols_free,
+                           uint32_t *symbols, bool *done)
+{
+    size_t byte = symbols_written / 8;
+    size_t out = 0;
+    uint8_t bpp = enc->bytes_per_pixel;
+
+    *done = false;
+
+    while (byte < data_size && symbols_free - out >= 8) {
+        size_t pixel = byte / bpp;
+        uint8_t value = pixels[pixel * bpp + enc->order[byte - pixel * bpp]];
+        if (enc->lut) {
+            value = enc->lut[value];
+        }
+        for (int bit = 7; bit >= 0; bit--) {
+            symbols[out++] = ((value >> bit) & 1) ? enc->bit1 : enc->bit0;
+        }
+        byte++;
+    }
+
+    if (byte >= data_size && out < symbols_free) {
+        symbols[out++] = enc->reset;
+        *done = true;
+    }
+    return out;
+}
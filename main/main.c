@@ -11,9 +11,13 @@
 #include "nvs_flash.h"
 
 #include "led_control.h"
+#include "button.h"
+#include "rules.h"
+#include "ws2812.h"
 #include "websocket_server.h"
 #include "oled.h"
 #include "dht11.h"
+#include "bench.h"
 
 static const char *TAG = "MAIN";
 
@@ -60,6 +64,9 @@ void dht11_task(void *pvParameter)
             success_count++;
             ESP_LOGI(TAG, "DHT11 ✅ #%d - Temp: %.1f°C, Hum: %.1f%%",
                      success_count, g_dht11_sensor.temperature, g_dht11_sensor.humidity);
+            /* Señales del motor de reglas (décimas; solo evalúa si cambian) */
+            rules_set_signal(RULE_SIG_TEMP, (int32_t)(g_dht11_sensor.temperature * 10.0f));
+            rules_set_signal(RULE_SIG_HUM, (int32_t)(g_dht11_sensor.humidity * 10.0f));
         } else {
             error_count++;
             ESP_LOGW(TAG, "DHT11 ❌ #%d - Error: %d", error_count, result);
@@ -81,13 +88,244 @@ dht11_t *get_dht11_data(void)
 }
 
 
+/* ------------------------------------------------------------------
+ * Botón físico
+ * - La conmutación local la hace la ISR del componente button; aquí solo
+ *   se publican los cambios a los clientes WS. Pulsación larga: todo
+ *   apagado.
+ * ------------------------------------------------------------------ */
+static void on_button_event(button_event_t event, void *arg)
+{
+    /* Evento del botón -> código de la señal BTN del motor de reglas */
+    static const int32_t rule_codes[] = {
+        [BUTTON_EVENT_PRESS] = RULE_BTN_PRESS,
+        [BUTTON_EVENT_RELEASE] = RULE_BTN_NONE,
+        [BUTTON_EVENT_SHORT] = RULE_BTN_SHORT,
+        [BUTTON_EVENT_LONG] = RULE_BTN_LONG,
+        [BUTTON_EVENT_DOUBLE] = RULE_BTN_DOUBLE,
+    };
+    char msg[24];
+
+    /* La pantalla refleja el botón sin esperar al siguiente render periódico */
+    oled_request_frame();
+
+    if ((size_t)event < sizeof(rule_codes) / sizeof(rule_codes[0]) &&
+        rule_codes[event] != RULE_BTN_NONE) {
+        rules_signal_event(RULE_SIG_BTN, rule_codes[event]);
+    }
+
+    switch (event) {
+    case BUTTON_EVENT_PRESS:
+        websocket_server_notify_state();
+        break;
+    case BUTTON_EVENT_LONG:
+        led_control_write_mask(0);
+        websocket_server_notify_state();
+        /* fall through */
+    case BUTTON_EVENT_SHORT:
+    case BUTTON_EVENT_DOUBLE:
+        snprintf(msg, sizeof(msg), "BTN:%s", button_event_name(event));
+        websocket_server_broadcast(msg);
+        break;
+    default:
+        break;
+    }
+}
+
+
+/* ------------------------------------------------------------------
+ * Motor de reglas: las acciones se publican a los clientes WS
+ * ------------------------------------------------------------------ */
+static void on_rule_action(const char *name, bool then_branch, void *arg)
+{
+    websocket_server_notify_state();
+    oled_request_frame();
+}
+
+
+/* ------------------------------------------------------------------
+ * Pantalla de estado: fuentes de valor de los widgets de la OLED
+ * ------------------------------------------------------------------ */
+static void status_ip(char *buf, size_t size, void *arg)
+{
+    strlcpy(buf, websocket_server_get_ip(), size);
+}
+
+static int32_t status_led_on(void *arg)
+{
+    return led_control_get_state();
+}
+
+static int32_t status_button_pressed(void *arg)
+{
+    return button_is_pressed();
+}
+
+static void status_dht(char *buf, size_t size, void *arg)
+{
+    snprintf(buf, size, "%.1fC %.1f%%", g_dht11_sensor.temperature, g_dht11_sensor.humidity);
+}
+
+static const oled_status_bindings_t s_status_bindings = {
+    .ip = status_ip,
+    .led_on = status_led_on,
+    .button_pressed = status_button_pressed,
+    .dht_status = status_dht,
+};
+
+
+/* ------------------------------------------------------------------
+ * Micro-benchmarks (comando WS "BENCH")
+ * - Kernels de dibujo, transferencia a la OLED y decodificación DHT11.
+ * - Los que dibujan o entregan tramas comparten framebuffer y escena con
+ *   la tarea de ritmo: la pausan mientras corren (ver bench_oled_enter).
+ * ------------------------------------------------------------------ */
+static void bench_oled_enter(void *arg)
+{
+    oled_pacer_pause(true);
+}
+
+static void bench_oled_leave(void *arg)
+{
+    oled_pacer_pause(false);
+}
+
+static void bench_oled_draw_text(void *arg)
+{
+    oled_draw_text(0, 10, "LED: ON 23.5C");
+}
+
+/* Referencia: el render anterior, píxel a píxel con oled_draw_pixel() */
+static void bench_oled_text_pixel(void *arg)
+{
+    const char *text = "LED: ON 23.5C";
+    for (int i = 0; text[i] != '\0'; i++) {
+        const uint8_t *glyph = font_5x7[text[i] - 32];
+        for (int col = 0; col < 5; col++) {
+            for (int row = 0; row < 7; row++) {
+                if (glyph[col] & (1 << row)) {
+                    oled_draw_pixel(i * 6 + col, 10 + row);
+                }
+            }
+        }
+    }
+}
+
+static void bench_oled_fill_invert(void *arg)
+{
+    /* Rectángulo no alineado a página (máscaras parciales arriba y abajo) */
+    oled_draw_fill_rect(3, 5, 61, 27);
+    oled_invert_rect(3, 5, 61, 27);
+}
+
+static void bench_oled_show_status(void *arg)
+{
+    oled_show_combined_status(false, "192.168.1.10", "23.5C 45.0%");
+}
+
+/* Refresco retenido sin cambios: solo lectura de fuentes y comparación */
+static void bench_oled_widgets(void *arg)
+{
+    oled_widgets_refresh();
+}
+
+static void bench_oled_update(void *arg)
+{
+    oled_update();
+}
+
+/* Coste en bus de 6 comandos (como el direccionamiento por trama): una
+ * transacción por comando frente a una sola. NOP (0xE3) para no alterar
+ * el direccionamiento de la tarea de pantalla. */
+static void bench_oled_cmd_single(void *arg)
+{
+    static const uint8_t nop = 0xE3;
+    for (int i = 0; i < 6; i++) {
+        oled_write_commands(&nop, 1);
+    }
+}
+
+static void bench_oled_cmd_batch(void *arg)
+{
+    static const uint8_t nops[6] = { 0xE3, 0xE3, 0xE3, 0xE3, 0xE3, 0xE3 };
+    oled_write_commands(nops, sizeof(nops));
+}
+
+static void bench_dht11_decode(void *arg)
+{
+    /* Trama válida: 45.0 %, 23.5 °C */
+    static const uint8_t frame[5] = { 45, 0, 23, 5, 73 };
+    dht11_t scratch = { .dht11_pin = GPIO_NUM_NC };
+    dht11_decode(&scratch, frame);
+}
+
+static void bench_ws2812_encode(void *arg)
+{
+    /* Trama completa en tramos de 64 símbolos, como la memoria del RMT */
+    static uint8_t pixels[WS2812_MAX_PIXELS * 3];
+    static uint32_t symbols[64];
+    ws2812_encoder_t *enc = arg;
+    size_t written = 0;
+    bool done = false;
+
+    while (!done) {
+        written += ws2812_encoder_fill(enc, pixels, sizeof(pixels), written,
+                                       sizeof(symbols) / sizeof(symbols[0]), symbols, &done);
+    }
+}
+
+static void register_benchmarks(void)
+{
+    static ws2812_encoder_t s_bench_enc;
+    ws2812_encoder_setup(&s_bench_enc, WS2812_TYPE_WS2812, WS2812_RESOLUTION_HZ, NULL);
+
+    bench_register_guarded("oled_draw_text", bench_oled_draw_text, NULL, bench_oled_enter, bench_oled_leave);
+    bench_register_guarded("oled_text_pixel", bench_oled_text_pixel, NULL, bench_oled_enter, bench_oled_leave);
+    bench_register_guarded("oled_fill_invert", bench_oled_fill_invert, NULL, bench_oled_enter, bench_oled_leave);
+    bench_register_guarded("oled_show_status", bench_oled_show_status, NULL, bench_oled_enter, bench_oled_leave);
+    bench_register_guarded("oled_widgets", bench_oled_widgets, NULL, bench_oled_enter, bench_oled_leave);
+    bench_register_guarded("oled_update", bench_oled_update, NULL, bench_oled_enter, bench_oled_leave);
+    bench_register("oled_cmd_single", bench_oled_cmd_single, NULL);
+    bench_register("oled_cmd_batch", bench_oled_cmd_batch, NULL);
+    bench_register("dht11_decode", bench_dht11_decode, NULL);
+    bench_register("ws2812_encode", bench_ws2812_encode, &s_bench_enc);
+}
+
+
 void app_main(void)
 {
+    /* ------------------------------------------------------------------
+     * Salidas primero: NVS y restauración del último estado de los
+     * canales, antes de la pantalla de inicio y del WiFi
+     * ------------------------------------------------------------------ */
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(ret);
+
+    ESP_LOGI(TAG, "Inicializando control de LED...");
+    led_control_init();
+
+    /* Reglas locales: recompila las guardadas en NVS */
+    if (rules_init() == ESP_OK) {
+        rules_set_callback(on_rule_action, NULL);
+    }
+
+    /* Tira WS2812: arranca apagada */
+    ws2812_init();
+
+    /* Botón activo desde el arranque: no depende de WiFi ni de la OLED */
+    if (button_init() == ESP_OK) {
+        button_set_callback(on_button_event, NULL);
+    }
+
     /* ------------------------------------------------------------------
      * Inicialización hardware básico
      * ------------------------------------------------------------------ */
 
-    /* 1) Inicializar I2C (para OLED) */
+    /* 1) Inicializar el bus I2C compartido y registrar la OLED */
     i2c_master_init();
     ESP_LOGI(TAG, "I2C inicializado");
 
@@ -102,15 +340,8 @@ void app_main(void)
     vTaskDelay(2000 / portTICK_PERIOD_MS);
 
     /* ------------------------------------------------------------------
-     * Inicialización del sistema (NVS, SPIFFS, WiFi, WebSocket, etc.)
+     * Inicialización del sistema (SPIFFS, WiFi, WebSocket, etc.)
      * ------------------------------------------------------------------ */
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        ESP_ERROR_CHECK(nvs_flash_erase());
-        ret = nvs_flash_init();
-    }
-    ESP_ERROR_CHECK(ret);
-
     ESP_LOGI(TAG, "Inicializando SPIFFS...");
     esp_vfs_spiffs_conf_t conf = {
         .base_path = "/spiffs",
@@ -131,13 +362,11 @@ void app_main(void)
         ESP_LOGI(TAG, "SPIFFS partición size: total: %d, used: %d", total, used);
     }
 
-    /* Inicializar componentes */
-    ESP_LOGI(TAG, "Inicializando control de LED...");
-    led_control_init();
-
     ESP_LOGI(TAG, "Inicializando WiFi...");
     wifi_init_sta();
 
+    register_benchmarks();
+
     ESP_LOGI(TAG, "Inicializando servidor WebSocket...");
     start_websocket_server();
 
@@ -148,18 +377,11 @@ void app_main(void)
      * ------------------------------------------------------------------ */
     xTaskCreate(&dht11_task, "dht11_task", 4096, NULL, 5, NULL);
 
-    /* Bucle principal: actualiza OLED con estado y lecturas del DHT11 */
-    for (;;) {
-        float temperature = g_dht11_sensor.temperature;
-        float humidity = g_dht11_sensor.humidity;
-
-        const char *ip_address = websocket_server_get_ip();
-        char dht_status[32];
-        snprintf(dht_status, sizeof(dht_status), "%.1fC %.1f%%", temperature, humidity);
-
-        /* Mostrar estado combinado: led, ip y dht */
-        oled_show_combined_status(led_control_get_state(), ip_address, dht_status);
-
-        vTaskDelay(100 / portTICK_PERIOD_MS);
-    }
-}
\ No newline at end of file
+    /* Pantalla de estado en modo retenido: las etiquetas quedan en el
+     * fondo y solo se redibujan los widgets cuyo valor cambió. La tarea de
+     * ritmo de tramas la refresca (OLED_FPS_TARGET, o antes con
+     * oled_request_frame()) dentro del presupuesto de bus; app_main
+     * termina aquí */
+    oled_widgets_build_status(&s_status_bindings);
+    oled_pacer_start(NULL, NULL);
+}
@@ -98,9 +98,15 @@ class WebSocketController {
     handleMessage(message) {
         console.log('🔄 Procesando mensaje:', message);
         if (message.startsWith('LED:')) {
-            const estado = message.split(':')[1];
+            // Formato: LED:<estado>;CLAVE=valor;CLAVE=valor...
+            const [head, ...campos] = message.split(';');
+            const estado = head.split(':')[1];
             console.log('💡 Estado del LED recibido:', estado);
             this.updateLEDStatus(estado);
+            const fields = this.parseFields(campos);
+            this.updateChannels(fields);
+            this.updateBrightness(fields);
+            this.updateEffect(fields);
         } else {
             console.log('📝 Mensaje recibido:', message);
         }
@@ -123,6 +129,57 @@ class WebSocketController {
         }
     }
 
+    parseFields(campos) {
+        const fields = {};
+        campos.forEach(campo => {
+            const idx = campo.indexOf('=');
+            if (idx > 0) {
+                fields[campo.slice(0, idx)] = campo.slice(idx + 1);
+            }
+        });
+        return fields;
+    }
+
+    updateChannels(fields) {
+        const container = document.getElementById('channels');
+        if (!container || fields.MASK === undefined) {
+            return;
+        }
+
+        const mask = parseInt(fields.MASK, 16);
+        const count = parseInt(fields.CH || '0', 10);
+
+        // Crear un botón por canal la primera vez (o si cambia el número)
+        if (container.children.length !== count) {
+            container.innerHTML = '';
+            for (let ch = 0; ch < count; ch++) {
+                const btn = document.createElement('button');
+                btn.className = 'btn btn-channel';
+                btn.textContent = `CH${ch}`;
+                btn.addEventListener('click', () => this.sendCommand(`CH:${ch}:TOGGLE`));
+                container.appendChild(btn);
+            }
+        }
+
+        Array.from(container.children).forEach((btn, ch) => {
+            btn.classList.toggle('channel-on', (mask & (1 << ch)) !== 0);
+        });
+    }
+
+    updateBrightness(fields) {
+        const slider = document.getElementById('brightness');
+        if (slider && fields.PWM !== undefined) {
+            slider.value = fields.PWM;
+        }
+    }
+
+    updateEffect(fields) {
+        const effectElement = document.getElementById('effectStatus');
+        if (effectElement) {
+            effectElement.textContent = fields.FX ? `${fields.FX} (${fields.FX_CYCLES})` : '-';
+        }
+    }
+
     handleReconnection() {
         if (this.reconnectAttempts < this.maxReconnectAttempts) {
             this.reconnectAttempts++;
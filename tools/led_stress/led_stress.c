@@ -0,0 +1,283 @@
+/**
+ * @file led_stress.c
+ * @brief Prueba de concurrencia en el host del núcleo de transiciones de
+ *        led_control.
+ *
+ * Compila components/led_control/led_control.c tal cual contra los
+ * sustitutos de stub/ (sección crítica = mutex de pthread, GPIO_OUT_REG =
+ * variable) y lanza varios hilos que alternan canales a la vez por las
+ * tres vías de la API:
+ *
+ *   - tarea: led_control_toggle_channel()
+ *   - ISR:   led_control_toggle_channel_from_isr() (la parte de tarea va
+ *            a un hilo que hace de tarea del timer de FreeRTOS)
+ *   - CAS:   instantánea + led_control_compare_and_set() con reintento
+ *
+ * y un lector que comprueba que la versión nunca retrocede. Cada toggle
+ * cambia la máscara, así que al final debe cumplirse:
+ *
+ *   - versión == número total de toggles (ninguno perdido ni duplicado)
+ *   - bit de cada canal == paridad de sus toggles
+ *   - GPIO_OUT_REG == pines de la máscara final
+ *
+ * Uso: led_stress [iteraciones por hilo]   (devuelve 1 si algo falla)
+ *
+ * Compilación (desde la raíz del repositorio):
+ *
+ *   cc -O2 -pthread -Itools/led_stress/stub \
+ *      -Icomponents/led_control/include -Icomponents/led_control \
+ *      components/led_control/led_control.c \
+ *      tools/led_stress/led_stress.c -o led_stress
+ *
+ * Con -fsanitize=thread se comprueba además que no haya carreras en los
+ * accesos al estado compartido.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L   /* rand_r() con -std=c11 */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "host_idf.h"
+#include "led_control.h"
+#include "led_internal.h"
+
+#define STRESS_DEFAULT_ITERS  200000
+#define STRESS_THREADS        6      /* Dos por cada vía */
+#define PENDING_MAX           8      /* Cola de la "tarea del timer" */
+
+typedef enum {
+    PATH_TASK,
+    PATH_ISR,
+    PATH_CAS,
+} stress_path_t;
+
+typedef struct {
+    stress_path_t path;
+    unsigned seed;
+    long iters;
+    long toggles[LED_CONTROL_MAX_CHANNELS];
+    long cas_retries;
+} stress_thread_t;
+
+volatile uint32_t host_gpio_out = 0;
+
+static int s_channels;
+static bool s_running = true;     /* Acceso atómico (lo lee el lector sin mutex) */
+static long s_note_changes = 0;
+static long s_deferred_calls = 0;
+
+
+/* Sustitutos del resto del componente ------------------------------------- */
+uint32_t led_persist_restore(void) { return 0; }
+void led_persist_mirror(uint32_t mask) { (void)mask; }
+void led_persist_note_change(void) { __atomic_add_fetch(&s_note_changes, 1, __ATOMIC_RELAXED); }
+bool led_pwm_is_enabled(void) { return false; }
+void led_pwm_follow_state(bool on) { (void)on; }
+void led_effect_init(void) {}
+void led_timeline_init(void) {}
+void led_sched_init(void) {}
+void led_scene_init(void) {}
+esp_err_t gpio_config(const gpio_config_t *config) { (void)config; return ESP_OK; }
+
+
+/* Tarea del timer: ejecuta las llamadas diferidas desde "ISR" ------------- */
+typedef struct {
+    PendedFunction_t fn;
+    void *arg1;
+    uint32_t arg2;
+} pended_call_t;
+
+static pended_call_t s_pending[PENDING_MAX];
+static int s_pending_count = 0;
+static pthread_mutex_t s_pending_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_pending_cond = PTHREAD_COND_INITIALIZER;
+
+BaseType_t xTimerPendFunctionCallFromISR(PendedFunction_t fn, void *arg1, uint32_t arg2,
+                                         BaseType_t *woken)
+{
+    BaseType_t ret = pdFAIL;
+    pthread_mutex_lock(&s_pending_mutex);
+    if (s_pending_count < PENDING_MAX) {
+        s_pending[s_pending_count++] = (pended_call_t) { fn, arg1, arg2 };
+        pthread_cond_signal(&s_pending_cond);
+        ret = pdPASS;
+    }
+    pthread_mutex_unlock(&s_pending_mutex);
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return ret;
+}
+
+static void *timer_task(void *arg)
+{
+    for (;;) {
+        pthread_mutex_lock(&s_pending_mutex);
+        while (s_pending_count == 0 && s_running) {
+            pthread_cond_wait(&s_pending_cond, &s_pending_mutex);
+        }
+        if (s_pending_count == 0) {
+            pthread_mutex_unlock(&s_pending_mutex);
+            return NULL;
+        }
+        pended_call_t call = s_pending[0];
+        memmove(&s_pending[0], &s_pending[1], --s_pending_count * sizeof(s_pending[0]));
+        pthread_mutex_unlock(&s_pending_mutex);
+
+        call.fn(call.arg1, call.arg2);
+        s_deferred_calls++;
+    }
+}
+
+
+/* Hilos de carga ---------------------------------------------------------- */
+static void *stress_thread(void *arg)
+{
+    stress_thread_t *t = arg;
+
+    for (long i = 0; i < t->iters; i++) {
+        int channel = rand_r(&t->seed) % s_channels;
+        uint32_t bit = 1UL << channel;
+
+        switch (t->path) {
+        case PATH_TASK:
+            led_control_toggle_channel(channel);
+            break;
+        case PATH_ISR:
+            led_control_toggle_channel_from_isr(channel);
+            break;
+        case PATH_CAS: {
+            uint32_t mask, version;
+            for (;;) {
+                led_control_get_snapshot(&mask, &version);
+                if (led_control_compare_and_set(version, mask ^ bit, NULL)) {
+                    break;
+                }
+                t->cas_retries++;
+            }
+            break;
+        }
+        }
+        t->toggles[channel]++;
+    }
+    return NULL;
+}
+
+/* Lector: la versión observada nunca retrocede */
+static void *reader_thread(void *arg)
+{
+    long *errors = arg;
+    uint32_t last = 0;
+
+    while (__atomic_load_n(&s_running, __ATOMIC_ACQUIRE)) {
+        uint32_t mask, version;
+        led_control_get_snapshot(&mask, &version);
+        if (version < last) {
+            (*errors)++;
+        }
+        last = version;
+    }
+    return NULL;
+}
+
+
+int main(int argc, char **argv)
+{
+    long iters = (argc > 1) ? atol(argv[1]) : STRESS_DEFAULT_ITERS;
+    if (iters <= 0) {
+        fprintf(stderr, "uso: %s [iteraciones por hilo]\n", argv[0]);
+        return 2;
+    }
+
+    led_control_init();
+    s_channels = led_control_get_channel_count();
+
+    static const char *path_names[] = { "tarea", "ISR", "CAS" };
+    stress_thread_t threads[STRESS_THREADS];
+    pthread_t handles[STRESS_THREADS], timer, reader;
+    long reader_errors = 0;
+
+    pthread_create(&timer, NULL, timer_task, NULL);
+    pthread_create(&reader, NULL, reader_thread, &reader_errors);
+    for (int i = 0; i < STRESS_THREADS; i++) {
+        memset(&threads[i], 0, sizeof(threads[i]));
+        threads[i].path = (stress_path_t)(i % 3);
+        threads[i].seed = 0x1234u + i;
+        threads[i].iters = iters;
+        pthread_create(&handles[i], NULL, stress_thread, &threads[i]);
+    }
+    for (int i = 0; i < STRESS_THREADS; i++) {
+        pthread_join(handles[i], NULL);
+    }
+
+    pthread_mutex_lock(&s_pending_mutex);
+    __atomic_store_n(&s_running, false, __ATOMIC_RELEASE);
+    pthread_cond_signal(&s_pending_cond);
+    pthread_mutex_unlock(&s_pending_mutex);
+    pthread_join(timer, NULL);
+    pthread_join(reader, NULL);
+
+    /* Resultado esperado a partir de los toggles contados */
+    long total = 0;
+    uint32_t expected_mask = 0;
+    for (int c = 0; c < s_channels; c++) {
+        long n = 0;
+        for (int i = 0; i < STRESS_THREADS; i++) {
+            n += threads[i].toggles[c];
+        }
+        total += n;
+        if (n & 1) {
+            expected_mask |= 1UL << c;
+        }
+    }
+    uint32_t expected_pins = 0;
+    for (int c = 0; c < s_channels; c++) {
+        if (expected_mask & (1UL << c)) {
+            expected_pins |= 1UL << led_control_get_channel_pin(c);
+        }
+    }
+
+    uint32_t mask, version;
+    led_control_get_snapshot(&mask, &version);
+
+    for (int i = 0; i < STRESS_THREADS; i++) {
+        printf("hilo %d (%s): %ld toggles", i, path_names[threads[i].path], threads[i].iters);
+        if (threads[i].path == PATH_CAS) {
+            printf(", %ld reintentos CAS", threads[i].cas_retries);
+        }
+        printf("\n");
+    }
+    printf("transiciones: %ld, versión: %lu, llamadas diferidas: %ld, avisos NVS: %ld\n",
+           total, (unsigned long)version, s_deferred_calls, s_note_changes);
+
+    int failures = 0;
+    if ((long)version != total) {
+        printf("FALLO: versión %lu, esperada %ld\n", (unsigned long)version, total);
+        failures++;
+    }
+    if (mask != expected_mask) {
+        printf("FALLO: máscara 0x%04lX, esperada 0x%04lX\n",
+               (unsigned long)mask, (unsigned long)expected_mask);
+        failures++;
+    }
+    if (host_gpio_out != expected_pins) {
+        printf("FALLO: GPIO_OUT_REG 0x%08lX, esperado 0x%08lX\n",
+               (unsigned long)host_gpio_out, (unsigned long)expected_pins);
+        failures++;
+    }
+    if (reader_errors) {
+        printf("FALLO: la versión retrocedió %ld veces\n", reader_errors);
+        failures++;
+    }
+
+    printf("%s\n", failures ? "FALLO" : "OK");
+    return failures ? 1 : 0;
+}
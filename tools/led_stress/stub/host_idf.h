@@ -0,0 +1,86 @@
+/**
+ * @file host_idf.h
+ * @brief Sustitutos mínimos de ESP-IDF/FreeRTOS para compilar
+ *        components/led_control/led_control.c en el host.
+ *
+ * Las secciones críticas (portMUX) son mutex de pthread y GPIO_OUT_REG es
+ * una variable: lo que se prueba es la lógica de las transiciones, no el
+ * hardware.
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#ifndef HOST_IDF_H
+#define HOST_IDF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <pthread.h>
+
+/* esp_err.h */
+typedef int esp_err_t;
+#define ESP_OK                 0
+#define ESP_FAIL               -1
+#define ESP_ERR_INVALID_ARG    0x102
+#define ESP_ERR_INVALID_STATE  0x103
+
+/* esp_attr.h */
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+/* esp_log.h: se comprueba el formato pero no se imprime nada */
+#define HOST_LOG(tag, ...) do { if (0) { (void)(tag); printf(__VA_ARGS__); } } while (0)
+#define ESP_LOGE(tag, ...) HOST_LOG(tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) HOST_LOG(tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) HOST_LOG(tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) HOST_LOG(tag, __VA_ARGS__)
+
+/* FreeRTOS: sección crítica = mutex */
+typedef int BaseType_t;
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdPASS  1
+#define pdFAIL  0
+
+typedef struct {
+    pthread_mutex_t mutex;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { PTHREAD_MUTEX_INITIALIZER }
+
+#define portENTER_CRITICAL(mux)      pthread_mutex_lock(&(mux)->mutex)
+#define portEXIT_CRITICAL(mux)       pthread_mutex_unlock(&(mux)->mutex)
+#define portENTER_CRITICAL_ISR(mux)  portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux)   portEXIT_CRITICAL(mux)
+#define portENTER_CRITICAL_SAFE(mux) portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_SAFE(mux)  portEXIT_CRITICAL(mux)
+#define portYIELD_FROM_ISR()         ((void)0)
+
+/* Llamada diferida a la tarea del timer (la implementa led_stress.c) */
+typedef void (*PendedFunction_t)(void *arg1, uint32_t arg2);
+BaseType_t xTimerPendFunctionCallFromISR(PendedFunction_t fn, void *arg1, uint32_t arg2,
+                                         BaseType_t *woken);
+
+/* GPIO */
+typedef int gpio_num_t;
+typedef enum { GPIO_MODE_DISABLE, GPIO_MODE_INPUT, GPIO_MODE_OUTPUT } gpio_mode_t;
+typedef enum { GPIO_PULLUP_DISABLE, GPIO_PULLUP_ENABLE } gpio_pullup_t;
+typedef enum { GPIO_PULLDOWN_DISABLE, GPIO_PULLDOWN_ENABLE } gpio_pulldown_t;
+typedef enum { GPIO_INTR_DISABLE } gpio_int_type_t;
+typedef struct {
+    uint64_t pin_bit_mask;
+    gpio_mode_t mode;
+    gpio_pullup_t pull_up_en;
+    gpio_pulldown_t pull_down_en;
+    gpio_int_type_t intr_type;
+} gpio_config_t;
+esp_err_t gpio_config(const gpio_config_t *config);
+
+/* Registro de salida simulado */
+extern volatile uint32_t host_gpio_out;
+#define GPIO_OUT_REG          (&host_gpio_out)
+#define REG_READ(reg)         (*(reg))
+#define REG_WRITE(reg, val)   (*(reg) = (val))
+
+#endif /* HOST_IDF_H */
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""
+make_timeline.py - Genera un timeline binario "LTL1" para led_timeline.
+
+Entrada de texto, una línea por evento (se ignoran vacías y las que empiezan
+por '#'):
+
+    <delta_us> <set_mask> <clear_mask>
+
+Las máscaras aceptan decimal o hexadecimal (0x..). El fichero resultante se
+sube a /ws como frame binario; después "TL:START[:sync_ms]" lo reproduce.
+
+Ejemplo (parpadeo de 10 Hz en el canal 0, en bucle; al dar la vuelta el
+delta del primer evento se cuenta desde el último):
+
+    50000  0x1 0x0
+    50000  0x0 0x1
+
+Autor: migbertweb
+Fecha: 2025-11-09
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = b"LTL1"
+MAX_EVENTS = 1024
+FLAG_LOOP = 0x01
+
+
+def parse(lines):
+    events = []
+    for num, line in enumerate(lines, 1):
+        line = line.split("#", 1)[0].strip()
+        if not line:
+            continue
+        fields = line.split()
+        if len(fields) != 3:
+            raise ValueError("línea {}: se esperan 3 campos".format(num))
+        delta, set_mask, clear_mask = (int(f, 0) for f in fields)
+        if not 0 <= delta <= 0xFFFFFFFF or not 0 <= set_mask <= 0xFFFF or not 0 <= clear_mask <= 0xFFFF:
+            raise ValueError("línea {}: valor fuera de rango".format(num))
+        events.append((delta, set_mask, clear_mask))
+    if not 0 < len(events) <= MAX_EVENTS:
+        raise ValueError("se admiten entre 1 y {} eventos".format(MAX_EVENTS))
+    return events
+
+
+def encode(events, loop):
+    out = MAGIC + struct.pack("<HBB", len(events), FLAG_LOOP if loop else 0, 0)
+    for delta, set_mask, clear_mask in events:
+        out += struct.pack("<IHH", delta, set_mask, clear_mask)
+    return out
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("input", help="fichero de texto con los eventos ('-' = stdin)")
+    ap.add_argument("output", help="fichero binario de salida")
+    ap.add_argument("--loop", action="store_true", help="reproducir en bucle")
+    args = ap.parse_args()
+
+    src = sys.stdin if args.input == "-" else open(args.input)
+    with src:
+        events = parse(src)
+    with open(args.output, "wb") as f:
+        f.write(encode(events, args.loop))
+    print("{} eventos, {} bytes".format(len(events), 8 + 8 * len(events)))
+
+
+if __name__ == "__main__":
+    main()
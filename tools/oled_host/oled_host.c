@@ -0,0 +1,664 @@
+/**
+ * @file oled_host.c
+ * @brief Emulador en el host de la capa de dibujo de la OLED 72x40.
+ *
+ * Compila components/oled/oled_gfx.c, oled_widgets.c y
+ * components/fonts/fonts.c tal cual (sin ESP-IDF) y permite revisar el
+ * render sin el panel físico:
+ *
+ *   render <dir>   Escribe en <dir> un PBM por pantalla (ver `screens`).
+ *   check <dir>    Compara cada pantalla con su imagen de referencia en
+ *                  <dir>; informa de los píxeles distintos y devuelve 1
+ *                  si alguna cambia.
+ *   show <nombre>  Muestra una pantalla en la terminal ('#' = encendido).
+ *   bench [n]      Tiempo medio (ns) de cada primitiva en n iteraciones.
+ *   verify [n]     Compara n casos aleatorios (rectángulos, líneas, texto
+ *                  y copias, recortados o no) con una implementación de
+ *                  referencia píxel a píxel; devuelve 1 si algún byte del
+ *                  framebuffer difiere.
+ *
+ * Las pantallas "widgets_*" son la escena retenida de estado combinado
+ * (oled_widgets_build_status) refrescada en secuencia, así que solo la
+ * primera se pinta completa; cada una debe coincidir con la imagen del
+ * render inmediato equivalente.
+ *
+ * Las imágenes de referencia están en tools/oled_host/golden. Si un
+ * cambio altera el render a propósito, se regeneran con "render" y se
+ * revisan (los PBM se abren con cualquier visor o se pasan a PNG con
+ * `pnmtopng`).
+ *
+ * Compilación (desde la raíz del repositorio):
+ *
+ *   cc -O2 -Icomponents/oled/include -Icomponents/fonts/include \
+ *      components/oled/oled_gfx.c components/oled/oled_widgets.c \
+ *      components/fonts/fonts.c \
+ *      tools/oled_host/oled_host.c -o oled_host
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L   /* clock_gettime() con -std=c11 */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "oled_gfx.h"
+#include "oled_widgets.h"
+#include "fonts.h"
+
+#define BENCH_DEFAULT_ITERS  100000
+#define VERIFY_DEFAULT_CASES 200000
+
+/* Pantallas con imagen de referencia ------------------------------------- */
+typedef struct {
+    const char *name;
+    const char *golden;   /* Imagen de referencia (sin ".pbm") */
+    void (*render)(void);
+} screen_t;
+
+static void render_splash(void)
+{
+    oled_render_splash_screen();
+}
+
+static void render_welcome(void)
+{
+    oled_render_welcome_screen();
+}
+
+static void render_status_idle(void)
+{
+    oled_render_combined_status(false, false, "192.168.1.10", "23.5C 45.0%");
+}
+
+static void render_status_active(void)
+{
+    oled_render_combined_status(true, true, "10.0.0.7", "--");
+}
+
+/* IP más ancha que la pantalla y sin IP: recorte y centrado */
+static void render_status_clipped(void)
+{
+    oled_render_combined_status(true, false, "192.168.100.200", "DHT ERROR");
+}
+
+static void render_status_no_ip(void)
+{
+    oled_render_combined_status(false, true, "", "18.0C 60.0%");
+}
+
+/* Estado simulado para la escena de widgets */
+static struct {
+    const char *ip;
+    bool led_on;
+    bool button_pressed;
+    const char *dht_status;
+} s_host;
+
+static void host_ip(char *buf, size_t size, void *arg)
+{
+    snprintf(buf, size, "%s", s_host.ip);
+}
+
+static int32_t host_led_on(void *arg)
+{
+    return s_host.led_on;
+}
+
+static int32_t host_button_pressed(void *arg)
+{
+    return s_host.button_pressed;
+}
+
+static void host_dht_status(char *buf, size_t size, void *arg)
+{
+    snprintf(buf, size, "%s", s_host.dht_status);
+}
+
+static void widgets_set(bool led_on, bool button_pressed, const char *ip, const char *dht_status)
+{
+    static bool built = false;
+    static const oled_status_bindings_t bindings = {
+        .ip = host_ip,
+        .led_on = host_led_on,
+        .button_pressed = host_button_pressed,
+        .dht_status = host_dht_status,
+    };
+
+    if (!built) {
+        oled_widgets_build_status(&bindings);
+        built = true;
+    }
+    s_host.led_on = led_on;
+    s_host.button_pressed = button_pressed;
+    s_host.ip = ip;
+    s_host.dht_status = dht_status;
+    oled_widgets_refresh();
+}
+
+static void widgets_idle(void)
+{
+    widgets_set(false, false, "192.168.1.10", "23.5C 45.0%");
+}
+
+static void widgets_active(void)
+{
+    widgets_set(true, true, "10.0.0.7", "--");
+}
+
+static void widgets_clipped(void)
+{
+    widgets_set(true, false, "192.168.100.200", "DHT ERROR");
+}
+
+static void widgets_no_ip(void)
+{
+    widgets_set(false, true, "", "18.0C 60.0%");
+}
+
+/* Las "widgets_*" van seguidas: desde la segunda, el refresco es parcial */
+static const screen_t screens[] = {
+    { "splash",          "splash",         render_splash },
+    { "welcome",         "welcome",        render_welcome },
+    { "status_idle",     "status_idle",    render_status_idle },
+    { "status_active",   "status_active",  render_status_active },
+    { "status_clipped",  "status_clipped", render_status_clipped },
+    { "status_no_ip",    "status_no_ip",   render_status_no_ip },
+    { "widgets_idle",    "status_idle",    widgets_idle },
+    { "widgets_active",  "status_active",  widgets_active },
+    { "widgets_clipped", "status_clipped", widgets_clipped },
+    { "widgets_no_ip",   "status_no_ip",   widgets_no_ip },
+    { "widgets_back",    "status_idle",    widgets_idle },
+};
+
+#define NUM_SCREENS (sizeof(screens) / sizeof(screens[0]))
+
+static const screen_t *find_screen(const char *name)
+{
+    for (size_t i = 0; i < NUM_SCREENS; i++) {
+        if (strcmp(screens[i].name, name) == 0) {
+            return &screens[i];
+        }
+    }
+    return NULL;
+}
+
+static size_t render_pbm(const screen_t *screen, uint8_t *pbm)
+{
+    screen->render();
+    return oled_export_pbm(pbm, OLED_PBM_BYTES);
+}
+
+/* Píxeles distintos entre dos PBM del mismo tamaño (se salta la cabecera) */
+static int pbm_diff_pixels(const uint8_t *a, const uint8_t *b)
+{
+    int diff = 0;
+    for (size_t i = OLED_PBM_HEADER_BYTES; i < OLED_PBM_BYTES; i++) {
+        diff += __builtin_popcount(a[i] ^ b[i]);
+    }
+    return diff;
+}
+
+
+/* Modos ------------------------------------------------------------------- */
+static int cmd_render(const char *dir)
+{
+    uint8_t pbm[OLED_PBM_BYTES];
+    char path[512];
+
+    for (size_t i = 0; i < NUM_SCREENS; i++) {
+        if (strcmp(screens[i].name, screens[i].golden) != 0) {
+            continue;   /* Comparte imagen con otra pantalla */
+        }
+        size_t len = render_pbm(&screens[i], pbm);
+        snprintf(path, sizeof(path), "%s/%s.pbm", dir, screens[i].name);
+        FILE *f = fopen(path, "wb");
+        if (f == NULL || fwrite(pbm, 1, len, f) != len) {
+            fprintf(stderr, "No se pudo escribir %s\n", path);
+            if (f) {
+                fclose(f);
+            }
+            return 1;
+        }
+        fclose(f);
+        printf("%s\n", path);
+    }
+    return 0;
+}
+
+static int cmd_check(const char *dir)
+{
+    uint8_t pbm[OLED_PBM_BYTES], golden[OLED_PBM_BYTES];
+    char path[512];
+    int failed = 0;
+
+    for (size_t i = 0; i < NUM_SCREENS; i++) {
+        render_pbm(&screens[i], pbm);
+        snprintf(path, sizeof(path), "%s/%s.pbm", dir, screens[i].golden);
+
+        FILE *f = fopen(path, "rb");
+        size_t len = f ? fread(golden, 1, sizeof(golden), f) : 0;
+        if (f) {
+            fclose(f);
+        }
+        if (len != OLED_PBM_BYTES || memcmp(golden, pbm, OLED_PBM_HEADER_BYTES) != 0) {
+            printf("%-16s ERROR: %s no es un PBM %dx%d\n", screens[i].name, path, SCREEN_WIDTH, SCREEN_HEIGHT);
+            failed++;
+            continue;
+        }
+
+        int diff = pbm_diff_pixels(golden, pbm);
+        printf("%-16s %s", screens[i].name, diff ? "DISTINTA" : "OK");
+        if (diff) {
+            printf(" (%d píxeles)", diff);
+            failed++;
+        }
+        printf("\n");
+    }
+    return failed ? 1 : 0;
+}
+
+static int cmd_show(const char *name)
+{
+    const screen_t *screen = find_screen(name);
+    if (screen == NULL) {
+        fprintf(stderr, "Pantalla desconocida: %s\n", name);
+        return 1;
+    }
+
+    screen->render();
+    const uint8_t *fb = oled_get_buffer();
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        for (int x = 0; x < SCREEN_WIDTH; x++) {
+            putchar((fb[(y / 8) * SCREEN_WIDTH + x] >> (y % 8)) & 1 ? '#' : '.');
+        }
+        putchar('\n');
+    }
+    return 0;
+}
+
+
+/* Benchmarks de primitivas ------------------------------------------------ */
+static void bench_clear(void)          { oled_clear(); }
+static void bench_pixel(void)          { oled_draw_pixel(37, 21); }
+static void bench_line(void)           { oled_draw_line(0, 0, SCREEN_WIDTH - 1, SCREEN_HEIGHT - 1); }
+static void bench_hline(void)          { oled_draw_hline(3, 21, 61); }
+static void bench_vline(void)          { oled_draw_vline(37, 3, 33); }
+static void bench_rect(void)           { oled_draw_rect(3, 5, 61, 27); }
+static void bench_fill_rect(void)      { oled_draw_fill_rect(3, 5, 61, 27); }
+static void bench_fill_full(void)      { oled_draw_fill_rect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT); }
+static void bench_invert_rect(void)    { oled_invert_rect(3, 5, 61, 27); }
+static void bench_clear_rect(void)     { oled_clear_rect(3, 5, 61, 27); }
+static void bench_text(void)           { oled_draw_text(0, 10, "LED: ON 23.5C"); }
+static void bench_text_unaligned(void) { oled_draw_text(0, 13, "LED: ON 23.5C"); }
+static void bench_text_centered(void)  { oled_draw_text_centered(3, "23.5C 45.0%"); }
+static void bench_status(void)         { render_status_idle(); }
+static void bench_widgets_idle(void)   { widgets_idle(); }
+
+/* Cambia un widget por refresco (indicador y texto del LED) */
+static void bench_widgets_change(void)
+{
+    static bool led_on = false;
+    led_on = !led_on;
+    widgets_set(led_on, false, "192.168.1.10", "23.5C 45.0%");
+}
+
+static void bench_export_pbm(void)
+{
+    static uint8_t pbm[OLED_PBM_BYTES];
+    oled_export_pbm(pbm, sizeof(pbm));
+}
+
+typedef struct {
+    const char *name;
+    void (*fn)(void);
+} bench_t;
+
+static const bench_t benches[] = {
+    { "clear",              bench_clear },
+    { "draw_pixel",         bench_pixel },
+    { "draw_line",          bench_line },
+    { "draw_hline",         bench_hline },
+    { "draw_vline",         bench_vline },
+    { "draw_rect",          bench_rect },
+    { "fill_rect",          bench_fill_rect },
+    { "fill_full",          bench_fill_full },
+    { "invert_rect",        bench_invert_rect },
+    { "clear_rect",         bench_clear_rect },
+    { "draw_text",          bench_text },
+    { "draw_text_y13",      bench_text_unaligned },
+    { "draw_text_centered", bench_text_centered },
+    { "render_status",      bench_status },
+    { "widgets_no_change",  bench_widgets_idle },
+    { "widgets_led_change", bench_widgets_change },
+    { "export_pbm",         bench_export_pbm },
+};
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int cmd_bench(long iters)
+{
+    if (iters <= 0) {
+        fprintf(stderr, "Iteraciones no válidas\n");
+        return 1;
+    }
+
+    printf("%-20s %10s\n", "primitiva", "ns/op");
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        /* Calentamiento: cachés y predictor como en régimen estable */
+        for (long n = 0; n < iters / 10; n++) {
+            benches[i].fn();
+        }
+        double start = now_ns();
+        for (long n = 0; n < iters; n++) {
+            benches[i].fn();
+        }
+        printf("%-20s %10.1f\n", benches[i].name, (now_ns() - start) / (double)iters);
+    }
+    return 0;
+}
+
+/* Referencia píxel a píxel ------------------------------------------------
+ * Las primitivas tal como eran antes de los spans y de las tablas de
+ * glifos desplazados: un píxel cada vez, recortado por ref_pixel(). Son
+ * lentas pero evidentes, y "verify" exige que el framebuffer resultante
+ * sea idéntico byte a byte.
+ */
+typedef enum {
+    REF_SET,
+    REF_CLEAR,
+    REF_XOR,
+} ref_op_t;
+
+static uint8_t s_ref[OLED_FRAME_BYTES];
+
+static void ref_pixel(int x, int y, ref_op_t op)
+{
+    if (x < 0 || x >= SCREEN_WIDTH || y < 0 || y >= SCREEN_HEIGHT) {
+        return;
+    }
+
+    uint8_t *byte = &s_ref[x + (y / 8) * SCREEN_WIDTH];
+    uint8_t bit = (uint8_t)(1u << (y % 8));
+    *byte = (op == REF_SET) ? (*byte | bit) : (op == REF_CLEAR) ? (*byte & ~bit) : (*byte ^ bit);
+}
+
+static void ref_line(int x0, int y0, int x1, int y1)
+{
+    int dx = abs(x1 - x0);
+    int dy = abs(y1 - y0);
+    int sx = (x0 < x1) ? 1 : -1;
+    int sy = (y0 < y1) ? 1 : -1;
+    int err = dx - dy;
+
+    while (1) {
+        ref_pixel(x0, y0, REF_SET);
+        if (x0 == x1 && y0 == y1) {
+            break;
+        }
+        int e2 = 2 * err;
+        if (e2 > -dy) {
+            err -= dy;
+            x0 += sx;
+        }
+        if (e2 < dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+static void ref_area(int x, int y, int w, int h, ref_op_t op)
+{
+    for (int i = x; i < x + w; i++) {
+        for (int j = y; j < y + h; j++) {
+            ref_pixel(i, j, op);
+        }
+    }
+}
+
+static void ref_rect(int x, int y, int w, int h)
+{
+    ref_line(x, y, x + w, y);
+    ref_line(x + w, y, x + w, y + h);
+    ref_line(x + w, y + h, x, y + h);
+    ref_line(x, y + h, x, y);
+}
+
+static void ref_copy(const uint8_t *src, int x, int y, int w, int h)
+{
+    for (int i = x; i < x + w; i++) {
+        for (int j = y; j < y + h; j++) {
+            if (i < 0 || i >= SCREEN_WIDTH || j < 0 || j >= SCREEN_HEIGHT) {
+                continue;
+            }
+            bool on = (src[i + (j / 8) * SCREEN_WIDTH] >> (j % 8)) & 1;
+            ref_pixel(i, j, on ? REF_SET : REF_CLEAR);
+        }
+    }
+}
+
+static void ref_text(int x, int y, const char *text)
+{
+    for (int i = 0; text[i] != '\0'; i++) {
+        char c = text[i];
+        if (c < 32 || c > 126) {
+            continue;
+        }
+
+        int char_x = x + i * 6;   /* 5px ancho + 1px espacio */
+        if (char_x >= SCREEN_WIDTH) {
+            break;
+        }
+
+        for (int col = 0; col < 5; col++) {
+            uint8_t col_data = font_5x7[c - 32][col];
+            for (int row = 0; row < 7; row++) {
+                if (col_data & (1 << row)) {
+                    ref_pixel(char_x + col, y + row, REF_SET);
+                }
+            }
+        }
+    }
+}
+
+static void ref_text_centered(int line, const char *text)
+{
+    int x = (SCREEN_WIDTH - (int)strlen(text) * 6) / 2;
+    ref_text(x < 0 ? 0 : x, line * 10, text);
+}
+
+
+/* Casos aleatorios (xorshift32: la secuencia es la misma en cada ejecución) */
+static uint32_t s_rng = 0x2545F491u;
+
+static uint32_t rng_next(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+/* Entero en [lo, hi] */
+static int rng_range(int lo, int hi)
+{
+    return lo + (int)(rng_next() % (uint32_t)(hi - lo + 1));
+}
+
+/* Coordenada que cae a veces fuera de la pantalla para probar el recorte */
+static int rng_coord(int size)
+{
+    return rng_range(-size / 2, size + size / 2);
+}
+
+/* Cadena de 0..15 caracteres, con algún carácter no imprimible */
+static void rng_text(char *buf)
+{
+    int len = rng_range(0, 15);
+    for (int i = 0; i < len; i++) {
+        buf[i] = (rng_next() % 16 == 0) ? (char)rng_range(1, 255) : (char)rng_range(32, 126);
+    }
+    buf[len] = '\0';
+}
+
+static void rng_frame(uint8_t *frame)
+{
+    for (int i = 0; i < OLED_FRAME_BYTES; i++) {
+        frame[i] = (uint8_t)rng_next();
+    }
+}
+
+static const char *const verify_ops[] = {
+    "pixel", "line", "hline", "vline", "rect", "fill_rect",
+    "invert_rect", "clear_rect", "copy_rect", "text", "text_centered",
+};
+
+#define NUM_VERIFY_OPS (sizeof(verify_ops) / sizeof(verify_ops[0]))
+
+static int cmd_verify(long cases)
+{
+    if (cases <= 0) {
+        fprintf(stderr, "Casos no válidos\n");
+        return 1;
+    }
+
+    uint8_t start[OLED_FRAME_BYTES], src[OLED_FRAME_BYTES];
+    char text[16];
+    long per_op[NUM_VERIFY_OPS] = { 0 };
+
+    for (long n = 0; n < cases; n++) {
+        /* Parte de una trama aleatoria, vacía o llena */
+        int fill = rng_range(0, 3);
+        if (fill == 0) {
+            memset(start, 0, sizeof(start));
+        } else if (fill == 1) {
+            memset(start, 0xFF, sizeof(start));
+        } else {
+            rng_frame(start);
+        }
+        oled_copy_rect(start, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+        memcpy(s_ref, start, sizeof(s_ref));
+
+        size_t op = rng_next() % NUM_VERIFY_OPS;
+        int x = rng_coord(SCREEN_WIDTH);
+        int y = rng_coord(SCREEN_HEIGHT);
+        int w = rng_range(-8, SCREEN_WIDTH + 8);
+        int h = rng_range(-8, SCREEN_HEIGHT + 8);
+        char args[64];
+        snprintf(args, sizeof(args), "(%d, %d, %d, %d)", x, y, w, h);
+
+        switch (op) {
+        case 0:
+            oled_draw_pixel(x, y);
+            ref_pixel(x, y, REF_SET);
+            break;
+        case 1:
+            oled_draw_line(x, y, x + w, y + h);
+            ref_line(x, y, x + w, y + h);
+            break;
+        case 2:
+            oled_draw_hline(x, y, w);
+            ref_area(x, y, w, 1, REF_SET);
+            break;
+        case 3:
+            oled_draw_vline(x, y, h);
+            ref_area(x, y, 1, h, REF_SET);
+            break;
+        case 4:
+            oled_draw_rect(x, y, w, h);
+            ref_rect(x, y, w, h);
+            break;
+        case 5:
+            oled_draw_fill_rect(x, y, w, h);
+            ref_area(x, y, w, h, REF_SET);
+            break;
+        case 6:
+            oled_invert_rect(x, y, w, h);
+            ref_area(x, y, w, h, REF_XOR);
+            break;
+        case 7:
+            oled_clear_rect(x, y, w, h);
+            ref_area(x, y, w, h, REF_CLEAR);
+            break;
+        case 8:
+            rng_frame(src);
+            oled_copy_rect(src, x, y, w, h);
+            ref_copy(src, x, y, w, h);
+            break;
+        case 9:
+            rng_text(text);
+            oled_draw_text(x, y, text);
+            ref_text(x, y, text);
+            snprintf(args, sizeof(args), "(%d, %d, \"%s\")", x, y, text);
+            break;
+        default:
+            rng_text(text);
+            y = rng_range(-2, 5);
+            oled_draw_text_centered(y, text);
+            ref_text_centered(y, text);
+            snprintf(args, sizeof(args), "(%d, \"%s\")", y, text);
+            break;
+        }
+        per_op[op]++;
+
+        const uint8_t *fb = oled_get_buffer();
+        if (memcmp(fb, s_ref, OLED_FRAME_BYTES) != 0) {
+            int byte = 0;
+            while (fb[byte] == s_ref[byte]) {
+                byte++;
+            }
+            printf("DISTINTA: caso %ld, %s%s: byte %d (página %d, columna %d) 0x%02X, esperado 0x%02X\n",
+                   n, verify_ops[op], args, byte, byte / SCREEN_WIDTH, byte % SCREEN_WIDTH,
+                   fb[byte], s_ref[byte]);
+            return 1;
+        }
+    }
+
+    for (size_t i = 0; i < NUM_VERIFY_OPS; i++) {
+        printf("%-16s %8ld casos OK\n", verify_ops[i], per_op[i]);
+    }
+    return 0;
+}
+
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Uso: %s render <dir> | check <dir> | show <pantalla> | bench [iteraciones] | verify [casos]\n", prog);
+    fprintf(stderr, "Pantallas:");
+    for (size_t i = 0; i < NUM_SCREENS; i++) {
+        fprintf(stderr, " %s", screens[i].name);
+    }
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 3 && strcmp(argv[1], "render") == 0) {
+        return cmd_render(argv[2]);
+    }
+    if (argc >= 3 && strcmp(argv[1], "check") == 0) {
+        return cmd_check(argv[2]);
+    }
+    if (argc >= 3 && strcmp(argv[1], "show") == 0) {
+        return cmd_show(argv[2]);
+    }
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+        return cmd_bench(argc >= 3 ? strtol(argv[2], NULL, 10) : BENCH_DEFAULT_ITERS);
+    }
+    if (argc >= 2 && strcmp(argv[1], "verify") == 0) {
+        return cmd_verify(argc >= 3 ? strtol(argv[2], NULL, 10) : VERIFY_DEFAULT_CASES);
+    }
+    usage(argv[0]);
+    return 2;
+}
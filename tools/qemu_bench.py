@@ -0,0 +1,270 @@
+#!/usr/bin/env python3
+"""
+qemu_bench.py - Benchmark de arranque y latencia en QEMU (ESP32-C3).
+
+Compila el firmware con sdkconfig.qemu (Ethernet OpenCores + marcas BENCH),
+lo arranca en qemu-system-riscv32 con red "user" y reenvío de puerto, y mide:
+
+  - boot: instante (esp_timer, us) de cada marca BENCH emitida por el firmware
+          (got_ip, ws_server_started, first_ws_cmd) y el tiempo de reloj del
+          host desde el lanzamiento de QEMU hasta cada una.
+  - first_cmd_ms: tiempo desde el lanzamiento hasta el primer "STATUS"
+          respondido con éxito por /ws.
+  - latency: latencia de ida y vuelta en régimen estable de N comandos.
+
+El resultado se emite como JSON (stdout o --output) para poder compararlo
+entre commits. Con --baseline se compara contra un JSON previo y el script
+devuelve código 1 si alguna métrica empeora más que --threshold (%).
+
+Requiere ESP-IDF exportado (idf.py, esptool.py) y qemu-system-riscv32 de
+Espressif en el PATH. Solo usa la biblioteca estándar de Python.
+
+Autor: migbertweb
+Fecha: 2025-11-09
+"""
+
+import argparse
+import base64
+import json
+import os
+import re
+import socket
+import statistics
+import struct
+import subprocess
+import sys
+import threading
+import time
+
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+BENCH_RE = re.compile(r"BENCH: (\{.*\})")
+
+
+def build_image(build_dir):
+    """Compila con sdkconfig.qemu y genera una imagen de flash única."""
+    sdkconfig = os.path.join(build_dir, "sdkconfig")
+    subprocess.check_call(
+        ["idf.py", "-B", build_dir, "-D", "SDKCONFIG=" + sdkconfig,
+         "-D", "SDKCONFIG_DEFAULTS=sdkconfig.qemu", "build"],
+        cwd=REPO)
+    image = os.path.join(build_dir, "flash_image.bin")
+    subprocess.check_call(
+        ["esptool.py", "--chip", "esp32c3", "merge_bin", "--fill-flash-size", "4MB",
+         "-o", image, "@flash_args"],
+        cwd=build_dir)
+    return image
+
+
+class QemuRunner:
+    """Lanza QEMU y recoge las marcas BENCH de la consola serie."""
+
+    def __init__(self, image, port, icount):
+        cmd = ["qemu-system-riscv32", "-nographic", "-machine", "esp32c3",
+               "-drive", "file={},if=mtd,format=raw".format(image),
+               "-nic", "user,model=open_eth,hostfwd=tcp:127.0.0.1:{}-:80".format(port)]
+        if icount is not None:
+            cmd += ["-icount", str(icount)]
+        self.marks = {}
+        self.host_ms = {}
+        self.cond = threading.Condition()
+        self.t0 = time.monotonic()
+        self.proc = subprocess.Popen(cmd, stdin=subprocess.DEVNULL, stdout=subprocess.PIPE,
+                                     stderr=subprocess.STDOUT)
+        self.reader = threading.Thread(target=self._read, daemon=True)
+        self.reader.start()
+
+    def _read(self):
+        for raw in self.proc.stdout:
+            line = raw.decode("utf-8", "replace")
+            m = BENCH_RE.search(line)
+            if not m:
+                continue
+            try:
+                mark = json.loads(m.group(1))
+            except ValueError:
+                continue
+            with self.cond:
+                self.marks[mark["event"]] = mark["t_us"]
+                self.host_ms[mark["event"]] = (time.monotonic() - self.t0) * 1000.0
+                self.cond.notify_all()
+
+    def wait_mark(self, event, timeout):
+        with self.cond:
+            self.cond.wait_for(lambda: event in self.marks, timeout)
+            return event in self.marks
+
+    def stop(self):
+        self.proc.terminate()
+        try:
+            self.proc.wait(5)
+        except subprocess.TimeoutExpired:
+            self.proc.kill()
+
+
+class WsClient:
+    """Cliente WebSocket mínimo (solo frames de texto cortos)."""
+
+    def __init__(self, host, port, timeout):
+        self.sock = socket.create_connection((host, port), timeout)
+        key = base64.b64encode(os.urandom(16)).decode()
+        req = ("GET /ws HTTP/1.1\r\nHost: {}:{}\r\nUpgrade: websocket\r\n"
+               "Connection: Upgrade\r\nSec-WebSocket-Key: {}\r\n"
+               "Sec-WebSocket-Version: 13\r\n\r\n").format(host, port, key)
+        self.sock.sendall(req.encode())
+        resp = b""
+        while b"\r\n\r\n" not in resp:
+            chunk = self.sock.recv(1024)
+            if not chunk:
+                raise ConnectionError("handshake interrumpido")
+            resp += chunk
+        if b" 101 " not in resp.split(b"\r\n", 1)[0]:
+            raise ConnectionError("handshake rechazado: " + resp.decode(errors="replace"))
+
+    def _recv_exact(self, n):
+        data = b""
+        while len(data) < n:
+            chunk = self.sock.recv(n - len(data))
+            if not chunk:
+                raise ConnectionError("conexión cerrada")
+            data += chunk
+        return data
+
+    def send_text(self, text):
+        payload = text.encode()
+        mask = os.urandom(4)
+        header = struct.pack("!BB", 0x81, 0x80 | len(payload))
+        masked = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+        self.sock.sendall(header + mask + masked)
+
+    def recv_text(self):
+        b0, b1 = self._recv_exact(2)
+        length = b1 & 0x7F
+        if length == 126:
+            length = struct.unpack("!H", self._recv_exact(2))[0]
+        elif length == 127:
+            length = struct.unpack("!Q", self._recv_exact(8))[0]
+        return self._recv_exact(length).decode("utf-8", "replace")
+
+    def close(self):
+        self.sock.close()
+
+
+def first_command(port, deadline):
+    """Reintenta STATUS hasta obtener respuesta; devuelve (cliente, ms)."""
+    while time.monotonic() < deadline:
+        try:
+            ws = WsClient("127.0.0.1", port, 5)
+            ws.send_text("STATUS")
+            if ws.recv_text().startswith("LED:"):
+                return ws
+            ws.close()
+        except OSError:
+            pass
+        time.sleep(0.2)
+    raise TimeoutError("no se obtuvo respuesta de /ws")
+
+
+def steady_latency(ws, count, warmup):
+    samples = []
+    for i in range(warmup + count):
+        t = time.perf_counter()
+        ws.send_text("STATUS")
+        ws.recv_text()
+        if i >= warmup:
+            samples.append((time.perf_counter() - t) * 1000.0)
+    samples.sort()
+    return {
+        "n": len(samples),
+        "min_ms": round(samples[0], 3),
+        "median_ms": round(statistics.median(samples), 3),
+        "p95_ms": round(samples[int(len(samples) * 0.95) - 1], 3),
+        "max_ms": round(samples[-1], 3),
+    }
+
+
+def flatten(result):
+    """Métricas comparables (menor es mejor) como dict plano."""
+    out = {}
+    for event, t_us in result["boot"]["device_us"].items():
+        out["boot.device_us." + event] = t_us
+    out["first_cmd_ms"] = result["first_cmd_ms"]
+    for k in ("median_ms", "p95_ms"):
+        out["latency." + k] = result["latency"][k]
+    return out
+
+
+def compare(result, baseline_path, threshold):
+    with open(baseline_path) as f:
+        base = flatten(json.load(f))
+    cur = flatten(result)
+    regressions = []
+    for key, old in base.items():
+        new = cur.get(key)
+        if new is None or old <= 0:
+            continue
+        delta = (new - old) * 100.0 / old
+        if delta > threshold:
+            regressions.append({"metric": key, "baseline": old, "current": new,
+                                "delta_pct": round(delta, 1)})
+    return regressions
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("--build-dir", default=os.path.join(REPO, "build_qemu"))
+    ap.add_argument("--image", help="imagen de flash ya generada (omite la compilación)")
+    ap.add_argument("--port", type=int, default=18080, help="puerto local reenviado al 80")
+    ap.add_argument("--icount", type=int, default=None,
+                    help="pasar -icount N a QEMU para tiempos deterministas")
+    ap.add_argument("--count", type=int, default=200, help="comandos para la latencia estable")
+    ap.add_argument("--warmup", type=int, default=20)
+    ap.add_argument("--timeout", type=float, default=120.0)
+    ap.add_argument("--output", help="fichero JSON de salida (por defecto stdout)")
+    ap.add_argument("--baseline", help="JSON previo con el que comparar")
+    ap.add_argument("--threshold", type=float, default=10.0,
+                    help="empeoramiento máximo tolerado en %% (con --baseline)")
+    args = ap.parse_args()
+
+    image = args.image or build_image(args.build_dir)
+    commit = subprocess.run(["git", "rev-parse", "--short", "HEAD"], cwd=REPO,
+                            capture_output=True, text=True).stdout.strip()
+
+    qemu = QemuRunner(image, args.port, args.icount)
+    try:
+        deadline = time.monotonic() + args.timeout
+        if not qemu.wait_mark("ws_server_started", args.timeout):
+            raise TimeoutError("el firmware no llegó a start_websocket_server")
+        ws = first_command(args.port, deadline)
+        first_cmd_ms = (time.monotonic() - qemu.t0) * 1000.0
+        qemu.wait_mark("first_ws_cmd", 5)
+        latency = steady_latency(ws, args.count, args.warmup)
+        ws.close()
+    finally:
+        qemu.stop()
+
+    result = {
+        "commit": commit,
+        "icount": args.icount,
+        "boot": {
+            "device_us": qemu.marks,
+            "host_ms": {k: round(v, 1) for k, v in qemu.host_ms.items()},
+        },
+        "first_cmd_ms": round(first_cmd_ms, 1),
+        "latency": latency,
+    }
+
+    status = 0
+    if args.baseline:
+        result["regressions"] = compare(result, args.baseline, args.threshold)
+        status = 1 if result["regressions"] else 0
+
+    text = json.dumps(result, indent=2, sort_keys=True)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text + "\n")
+    print(text)
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,216 @@
+/**
+ * @file ws2812_host.c
+ * @brief Pruebas en el host del codificador de la tira WS2812.
+ *
+ * Compila components/ws2812/ws2812_encoder.c tal cual (no depende de
+ * ESP-IDF) y comprueba:
+ *
+ *   - tiempos de los símbolos de bit y de reset a la resolución del RMT
+ *   - orden de colores GRB (WS2812) y GRBW (SK6812), MSB primero
+ *   - aplicación de la tabla de gamma/brillo
+ *   - que rellenar por tramos de cualquier tamaño (como hace el driver
+ *     RMT con su memoria) da la misma secuencia que de una vez, con un
+ *     único reset al final y `done` solo en el último tramo
+ *
+ * Uso: ws2812_host   (imprime cada prueba y devuelve 1 si alguna falla)
+ *
+ * Compilación (desde la raíz del repositorio):
+ *
+ *   cc -O2 -Icomponents/ws2812/include components/ws2812/ws2812_encoder.c \
+ *      tools/ws2812_host/ws2812_host.c -o ws2812_host
+ *
+ * Autor: migbertweb
+ * Fecha: 2025-11-09
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ws2812_encoder.h"
+
+#define RESOLUTION_HZ  10000000   /* La de WS2812_RESOLUTION_HZ: 0,1 us por tick */
+#define MAX_BYTES      (16 * 4)
+#define MAX_SYMBOLS    (MAX_BYTES * 8 + 1)
+
+static int s_failures = 0;
+
+static void check(bool ok, const char *name)
+{
+    printf("%s: %s\n", name, ok ? "OK" : "FALLO");
+    if (!ok) {
+        s_failures++;
+    }
+}
+
+/* Campos de un símbolo { duration0:15, level0:1, duration1:15, level1:1 } */
+static bool symbol_is(uint32_t sym, uint32_t d0, uint32_t l0, uint32_t d1, uint32_t l1)
+{
+    return (sym & 0x7FFF) == d0 && ((sym >> 15) & 1) == l0 &&
+           ((sym >> 16) & 0x7FFF) == d1 && (sym >> 31) == l1;
+}
+
+/* Decodifica los símbolos de datos a bytes (MSB primero) */
+static bool decode(const ws2812_encoder_t *enc, const uint32_t *symbols, size_t bytes, uint8_t *out)
+{
+    for (size_t i = 0; i < bytes; i++) {
+        uint8_t value = 0;
+        for (int bit = 0; bit < 8; bit++) {
+            uint32_t sym = symbols[i * 8 + bit];
+            if (sym != enc->bit0 && sym != enc->bit1) {
+                return false;
+            }
+            value = (value << 1) | (sym == enc->bit1);
+        }
+        out[i] = value;
+    }
+    return true;
+}
+
+/* Trama completa en una sola llamada */
+static size_t encode_all(const ws2812_encoder_t *enc, const uint8_t *pixels, size_t size,
+                         uint32_t *symbols, bool *done)
+{
+    return ws2812_encoder_fill(enc, pixels, size, 0, MAX_SYMBOLS, symbols, done);
+}
+
+
+/* Pruebas ----------------------------------------------------------------- */
+static void test_symbols(void)
+{
+    ws2812_encoder_t enc;
+
+    /* WS2812: T0H 400 / T0L 850 ns, T1H 800 / T1L 450 ns (redondeo a 0,1 us) */
+    ws2812_encoder_setup(&enc, WS2812_TYPE_WS2812, RESOLUTION_HZ, NULL);
+    check(symbol_is(enc.bit0, 4, 1, 9, 0) && symbol_is(enc.bit1, 8, 1, 5, 0),
+          "WS2812: símbolos de bit");
+    /* Reset: 280 us a nivel bajo en dos mitades */
+    check(symbol_is(enc.reset, 1400, 0, 1400, 0), "WS2812: símbolo de reset");
+
+    ws2812_encoder_setup(&enc, WS2812_TYPE_SK6812_RGBW, RESOLUTION_HZ, NULL);
+    check(symbol_is(enc.bit0, 3, 1, 9, 0) && symbol_is(enc.bit1, 6, 1, 6, 0),
+          "SK6812: símbolos de bit");
+
+    /* Duración acotada al campo de 15 bits */
+    check(symbol_is(ws2812_make_symbol(1000000000u, 40000, 1), 0x7FFF, 1, 1, 0),
+          "símbolo saturado a 15 bits");
+}
+
+static void test_order(void)
+{
+    ws2812_encoder_t enc;
+    uint32_t symbols[MAX_SYMBOLS];
+    uint8_t out[MAX_BYTES];
+    bool done;
+
+    const uint8_t rgb[] = { 0x11, 0x22, 0x33, 0x80, 0x01, 0xFF };
+    const uint8_t grb[] = { 0x22, 0x11, 0x33, 0x01, 0x80, 0xFF };
+    ws2812_encoder_setup(&enc, WS2812_TYPE_WS2812, RESOLUTION_HZ, NULL);
+    size_t n = encode_all(&enc, rgb, sizeof(rgb), symbols, &done);
+    check(n == ws2812_encoder_total_symbols(sizeof(rgb)) && done &&
+          decode(&enc, symbols, sizeof(rgb), out) && memcmp(out, grb, sizeof(grb)) == 0 &&
+          symbols[n - 1] == enc.reset,
+          "WS2812: orden GRB, MSB primero");
+
+    const uint8_t rgbw[] = { 0x11, 0x22, 0x33, 0x44 };
+    const uint8_t grbw[] = { 0x22, 0x11, 0x33, 0x44 };
+    ws2812_encoder_setup(&enc, WS2812_TYPE_SK6812_RGBW, RESOLUTION_HZ, NULL);
+    n = encode_all(&enc, rgbw, sizeof(rgbw), symbols, &done);
+    check(n == ws2812_encoder_total_symbols(sizeof(rgbw)) && done &&
+          decode(&enc, symbols, sizeof(rgbw), out) && memcmp(out, grbw, sizeof(grbw)) == 0,
+          "SK6812: orden GRBW");
+
+    /* Trama vacía: solo el reset */
+    n = encode_all(&enc, rgbw, 0, symbols, &done);
+    check(n == 1 && done && symbols[0] == enc.reset, "trama vacía: solo reset");
+}
+
+static void test_lut(void)
+{
+    ws2812_encoder_t enc;
+    uint32_t symbols[MAX_SYMBOLS];
+    uint8_t lut[256], out[3];
+    bool done;
+
+    for (int i = 0; i < 256; i++) {
+        lut[i] = (uint8_t)(255 - i);
+    }
+    const uint8_t rgb[] = { 0x00, 0x10, 0xFF };
+    const uint8_t expected[] = { 0xEF, 0xFF, 0x00 };   /* G, R, B invertidos */
+    ws2812_encoder_setup(&enc, WS2812_TYPE_WS2812, RESOLUTION_HZ, lut);
+    encode_all(&enc, rgb, sizeof(rgb), symbols, &done);
+    check(decode(&enc, symbols, sizeof(rgb), out) && memcmp(out, expected, sizeof(out)) == 0,
+          "tabla de gamma/brillo");
+}
+
+/*
+ * Rellena por tramos de `chunk` símbolos como el driver RMT: si el tramo
+ * no admite ni un byte (0 símbolos sin terminar), el siguiente llega con
+ * la memoria ya libre (8 símbolos).
+ */
+static bool encode_chunked(const ws2812_encoder_t *enc, const uint8_t *pixels, size_t size,
+                           size_t chunk, uint32_t *symbols, size_t *total)
+{
+    size_t written = 0;
+    bool done = false;
+    int calls = 0;
+
+    while (!done) {
+        size_t free_syms = chunk;
+        size_t n = ws2812_encoder_fill(enc, pixels, size, written, free_syms, &symbols[written], &done);
+        if (n == 0 && !done) {
+            n = ws2812_encoder_fill(enc, pixels, size, written, 8, &symbols[written], &done);
+        }
+        if (n == 0 || n > (free_syms > 8 ? free_syms : 8) || ++calls > MAX_SYMBOLS) {
+            return false;
+        }
+        /* Solo bytes completos, salvo el reset final */
+        if (!done && n % 8 != 0) {
+            return false;
+        }
+        written += n;
+    }
+    *total = written;
+    return true;
+}
+
+static void test_chunks(void)
+{
+    ws2812_encoder_t enc;
+    uint8_t pixels[MAX_BYTES];
+    uint32_t reference[MAX_SYMBOLS], symbols[MAX_SYMBOLS];
+    bool done;
+
+    srand(1);
+    for (size_t i = 0; i < sizeof(pixels); i++) {
+        pixels[i] = (uint8_t)rand();
+    }
+
+    for (int type = 0; type < 2; type++) {
+        ws2812_encoder_setup(&enc, (ws2812_type_t)type, RESOLUTION_HZ, NULL);
+        size_t size = (sizeof(pixels) / enc.bytes_per_pixel) * enc.bytes_per_pixel;
+        size_t expected = encode_all(&enc, pixels, size, reference, &done);
+
+        bool ok = expected == ws2812_encoder_total_symbols(size) && done;
+        for (size_t chunk = 1; chunk <= 70 && ok; chunk++) {
+            size_t total = 0;
+            memset(symbols, 0, sizeof(symbols));
+            ok = encode_chunked(&enc, pixels, size, chunk, symbols, &total) &&
+                 total == expected &&
+                 memcmp(symbols, reference, expected * sizeof(uint32_t)) == 0;
+        }
+        check(ok, type == 0 ? "WS2812: tramos de 1..70 símbolos" : "SK6812: tramos de 1..70 símbolos");
+    }
+}
+
+
+int main(void)
+{
+    test_symbols();
+    test_order();
+    test_lut();
+    test_chunks();
+
+    printf("%s\n", s_failures ? "FALLO" : "OK");
+    return s_failures ? 1 : 0;
+}